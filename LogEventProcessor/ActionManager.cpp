@@ -1,22 +1,57 @@
 #include "ActionManager.h"
+#ifdef _WIN32
+#include "ActionSender.h"
+#endif
 #include <iostream>
 #include <sstream>
 #include <algorithm>
 #include <cctype>
-#include <regex>
 #include <thread>
 #include <chrono>
 
-ActionManager::ActionManager() 
-    : _regexMatcher(nullptr), _executedActionCount(0), _failedActionCount(0) {
+namespace {
+
+ActionKind parseActionKind(const std::string& type) {
+    if (type == "keystroke") return ActionKind::Keystroke;
+    if (type == "command") return ActionKind::Command;
+    if (type == "text") return ActionKind::Text;
+    if (type == "sms") return ActionKind::Sms;
+    return ActionKind::Unknown;
+}
+
+} // namespace
+
+ActionStep::ActionStep(const ActionMapping& m)
+    : mapping(m), value(ActionTemplate::parse(m.actionValue)), kind(parseActionKind(m.actionType)) {
+    if (kind == ActionKind::Keystroke && !value.hasPlaceholders()) {
+        ActionManager::parseChord(m.actionValue, keys, keyModifiers);
+    }
+}
+
+#ifdef _WIN32
+ActionManager::ActionManager() : ActionManager(std::make_unique<ActionSender>()) {
+}
+#else
+ActionManager::ActionManager() : ActionManager(std::make_unique<RecordingActionSink>(false)) {
+}
+#endif
+
+ActionManager::ActionManager(std::unique_ptr<ActionSink> sink)
+    : _sink(std::move(sink)), _regexMatcher(nullptr), _executedActionCount(0), _failedActionCount(0) {
+#ifdef _WIN32
+    _sender = dynamic_cast<ActionSender*>(_sink.get());
+#endif
+    _scheduler.start();
 }
 
 ActionManager::~ActionManager() {
+    // Scheduled steps call back into this object
+    _scheduler.stop();
 }
 
 bool ActionManager::initialize() {
-    if (!_actionSender.initialize()) {
-        std::cerr << "Failed to initialize ActionSender" << std::endl;
+    if (!_sink->initialize()) {
+        std::cerr << "Failed to initialize action sink" << std::endl;
         return false;
     }
     
@@ -27,7 +62,8 @@ bool ActionManager::initialize() {
 void ActionManager::addActionMapping(const ActionMapping& mapping) {
     std::lock_guard<std::mutex> lock(_mutex);
     auto& vec = _actionMappings[mapping.ruleName];
-    vec.push_back(mapping);
+    vec.push_back(std::make_shared<ActionStep>(mapping));
+    prepareRuleSteps(mapping.ruleName, vec);
     std::cout << "Added action mapping: " << mapping.ruleName 
               << " -> " << mapping.actionType << ":" << mapping.actionValue << std::endl;
 }
@@ -41,8 +77,9 @@ void ActionManager::addActionSequence(const std::string& ruleName, const std::ve
     std::lock_guard<std::mutex> lock(_mutex);
     auto& vec = _actionMappings[ruleName];
     for (const auto& s : steps) {
-        vec.push_back(s);
+        vec.push_back(std::make_shared<ActionStep>(s));
     }
+    prepareRuleSteps(ruleName, vec);
     std::cout << "Added action sequence for rule: " << ruleName << ", steps: " << steps.size() << std::endl;
 }
 
@@ -52,66 +89,28 @@ bool ActionManager::processEvent(const LogEventPtr& event) {
     }
     
     // Check if any regex rules match
-    std::smatch matches;
     bool anyMatch = false;
+    FoldedLine line(event->data);
+    std::vector<RuleMatch> matched;
+    std::vector<ActionInvocation> seq;
+    _regexMatcher->matchRules(line, event->channelInfo.channel, matched);
     
-    for (size_t i = 0; i < _regexMatcher->getRuleCount(); ++i) {
-        const RegexRule* rule = _regexMatcher->getRule(i);
-        if (!rule || !rule->enabled) {
-            continue;
-        }
-        
-        if (std::regex_search(event->data, matches, std::regex(rule->pattern, std::regex_constants::ECMAScript | std::regex_constants::optimize | std::regex_constants::icase))) {
+    for (const auto& match : matched) {
+        const RegexRule* rule = _regexMatcher->getRule(match.index);
+        if (rule) {
             // Check if we have an action mapping for this rule
-            std::vector<ActionMapping> seq;
-            {
-                std::lock_guard<std::mutex> lock(_mutex);
-                auto it = _actionMappings.find(rule->name);
-                if (it != _actionMappings.end()) {
-                    seq.reserve(it->second.size());
-                    // Determine extracted text: first capture group if present, otherwise full match
-                    std::string extractedText;
-                    if (matches.size() > 1) {
-                        extractedText = matches[1].str();
-                    } else if (matches.size() > 0) {
-                        extractedText = matches[0].str();
-                    }
-                    for (const auto& step : it->second) {
-                        if (!step.enabled) continue;
-                        ActionMapping s = step;
-                        s.logLine = event->data; // Set the log line for SMS action type
-                        if (!extractedText.empty() && s.actionValue.find('#') != std::string::npos) {
-                            std::string result;
-                            result.reserve(s.actionValue.size() + extractedText.size());
-                            for (char c : s.actionValue) {
-                                if (c == '#') { result += extractedText; } else { result.push_back(c); }
-                            }
-                            s.actionValue = result;
-                        }
-                        seq.push_back(std::move(s));
-                    }
-                }
-            }
+            seq.clear();
+            appendRuleActions(*rule, match.index, match.captures, event, seq);
             if (!seq.empty()) {
                 // Cooldown enforcement per rule
-                int cooldown = rule->cooldownMs;
-                if (cooldown > 0) {
-                    auto now = std::chrono::steady_clock::now();
-                    std::lock_guard<std::mutex> cdlock(_cooldownMutex);
-                    auto itLast = _lastRuleFireTime.find(rule->name);
-                    if (itLast != _lastRuleFireTime.end()) {
-                        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - itLast->second).count();
-                        if (elapsed < cooldown) {
-                            // Skip due to cooldown
-                            continue;
-                        }
-                    }
-                    _lastRuleFireTime[rule->name] = now;
+                if (!_cooldowns.tryClaim(rule->id, rule->cooldownMs)) {
+                    _regexMatcher->recordCooldownSuppression(match.index);
+                    continue;
                 }
                 std::cout << "[ACTION] Rule '" << rule->name << "' matched, executing " << seq.size() << " step(s)" << std::endl;
-                if (executeActions(seq)) {
-                    anyMatch = true;
-                }
+                scheduleSequence(std::move(seq));
+                seq = std::vector<ActionInvocation>();
+                anyMatch = true;
             }
         }
     }
@@ -119,87 +118,370 @@ bool ActionManager::processEvent(const LogEventPtr& event) {
     return anyMatch;
 }
 
-bool ActionManager::getActionsForEvent(const LogEventPtr& event, std::vector<ActionMapping>& outActions) const {
+bool ActionManager::getActionsForEvent(const LogEventPtr& event, std::vector<ActionInvocation>& outActions) const {
     if (!event || !_regexMatcher) return false;
-    std::smatch matches;
     bool any = false;
-    // Iterate rules in index order to keep deterministic
-    for (size_t i = 0; i < _regexMatcher->getRuleCount(); ++i) {
-        const RegexRule* rule = _regexMatcher->getRule(i);
-        if (!rule || !rule->enabled) continue;
-        if (std::regex_search(event->data, matches, std::regex(rule->pattern, std::regex_constants::ECMAScript | std::regex_constants::optimize | std::regex_constants::icase))) {
-            // Build sequence under mapping lock
-            std::vector<ActionMapping> seq;
-            {
-                std::lock_guard<std::mutex> lock(_mutex);
-                auto it = _actionMappings.find(rule->name);
-                if (it != _actionMappings.end()) {
-                    std::string extractedText;
-                    if (matches.size() > 1) {
-                        extractedText = matches[1].str();
-                    } else if (matches.size() > 0) {
-                        extractedText = matches[0].str();
-                    }
-                    for (const auto& step : it->second) {
-                        if (!step.enabled) continue;
-                        ActionMapping s = step;
-                        s.logLine = event->data; // Set the log line for SMS action type
-                        if (!extractedText.empty() && s.actionValue.find('#') != std::string::npos) {
-                            std::string result;
-                            result.reserve(s.actionValue.size() + extractedText.size());
-                            for (char c : s.actionValue) {
-                                if (c == '#') { result += extractedText; } else { result.push_back(c); }
-                            }
-                            s.actionValue = result;
-                        }
-                        seq.push_back(std::move(s));
-                    }
-                }
-            }
-            if (!seq.empty()) {
-                // No cooldown mutation in const method; return actions and let dispatcher enforce order
-                for (auto &s : seq) { outActions.push_back(std::move(s)); }
-                any = true;
-            }
+    FoldedLine line(event->data);
+    std::vector<RuleMatch> matched;
+    // Matches come back in rule index order to keep deterministic
+    _regexMatcher->matchRules(line, event->channelInfo.channel, matched);
+    for (const auto& match : matched) {
+        const RegexRule* rule = _regexMatcher->getRule(match.index);
+        if (!rule) continue;
+        // No cooldown mutation in const method; return actions and let dispatcher enforce order
+        if (appendRuleActions(*rule, match.index, match.captures, event, outActions)) {
+            any = true;
         }
     }
     return any;
 }
 
-bool ActionManager::executeActions(const std::vector<ActionMapping>& actions) {
-    bool allOk = true;
-    // Enforce per-rule cooldown before executing
-    if (!actions.empty() && _regexMatcher) {
-        const std::string& ruleName = actions.front().ruleName;
-        const RegexRule* rule = _regexMatcher->getRuleByName(ruleName);
-        if (rule && rule->cooldownMs > 0) {
-            auto now = std::chrono::steady_clock::now();
-            std::lock_guard<std::mutex> cdlock(_cooldownMutex);
-            auto itLast = _lastRuleFireTime.find(ruleName);
-            if (itLast != _lastRuleFireTime.end()) {
-                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - itLast->second).count();
-                if (elapsed < rule->cooldownMs) {
-                    return true; // treat as success but skip execution
-                }
+bool ActionManager::appendRuleActions(const RegexRule& rule, size_t ruleIndex, const MatchCaptures& matches,
+                                      const LogEventPtr& event, std::vector<ActionInvocation>& out) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _actionMappings.find(rule.name);
+    if (it == _actionMappings.end()) {
+        return false;
+    }
+    size_t before = out.size();
+    for (const auto& step : it->second) {
+        if (!step->mapping.enabled) continue;
+        ActionInvocation invocation;
+        invocation.step = step;
+        invocation.event = event;
+        invocation.ruleId = rule.id;
+        invocation.ruleIndex = ruleIndex;
+        invocation.cooldownMs = rule.cooldownMs;
+        if (step->value.hasPlaceholders()) {
+            step->value.render(event->data, matches, invocation.renderedValue);
+        }
+        out.push_back(std::move(invocation));
+    }
+    return out.size() > before;
+}
+
+bool ActionManager::executeActions(const std::vector<ActionInvocation>& actions) {
+    if (actions.empty()) {
+        return false;
+    }
+    // Enforce per-rule cooldown before executing; each rule's steps are adjacent and become
+    // their own sequence, so each one is charged to its own rate limit bucket
+    auto now = std::chrono::steady_clock::now();
+    bool scheduled = false;
+    size_t i = 0;
+    while (i < actions.size()) {
+        size_t end = i + 1;
+        while (end < actions.size() && actions[end].ruleId == actions[i].ruleId) {
+            ++end;
+        }
+        if (_cooldowns.tryClaim(actions[i].ruleId, actions[i].cooldownMs, now)) {
+            scheduleSequence(std::vector<ActionInvocation>(actions.begin() + i, actions.begin() + end));
+            scheduled = true;
+        } else if (_regexMatcher) {
+            _regexMatcher->recordCooldownSuppression(actions[i].ruleIndex);
+        }
+        i = end;
+    }
+    return scheduled;
+}
+
+void ActionManager::scheduleSequence(std::vector<ActionInvocation> actions) {
+    auto sequence = std::make_shared<const std::vector<ActionInvocation>>(std::move(actions));
+    _scheduler.schedule(std::chrono::milliseconds(0), [this, sequence]() { admitSequence(sequence); });
+}
+
+void ActionManager::admitSequence(const std::shared_ptr<const std::vector<ActionInvocation>>& actions) {
+    if (actions->empty()) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    uint32_t ruleId = actions->front().ruleId;
+    if (!_rateLimits.enabled()) {
+        runSequence(actions, 0);
+        return;
+    }
+    // Waiting sequences go first: they take any tokens freed since the last drain, and a
+    // newcomer only waits behind a sequence of its own rule. Sequences of other rules that
+    // are still waiting for their rule bucket do not hold it back.
+    if (!_throttled.empty()) {
+        drainThrottled();
+    }
+    bool ruleWaiting = std::any_of(_throttled.begin(), _throttled.end(),
+        [ruleId](const ThrottledSequence& waiting) { return waiting.ruleId == ruleId; });
+    if (!ruleWaiting && tryTakeTokens(ruleId, now)) {
+        runSequence(actions, 0);
+        return;
+    }
+    if (_rateLimits.policy == RateLimitPolicy::Drop) {
+        _rateDropped.fetch_add(1);
+        return;
+    }
+    // The staleness deadline counts from when the line was read, not from when it got here
+    auto deadline = now + _rateLimits.maxStaleness;
+    if (const LogEventPtr& event = actions->front().event) {
+        deadline -= std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::max(std::chrono::system_clock::duration::zero(), std::chrono::system_clock::now() - event->timestamp));
+    }
+    if (_rateLimits.policy == RateLimitPolicy::Coalesce) {
+        for (auto& waiting : _throttled) {
+            if (waiting.ruleId == ruleId) {
+                // The newer line replaces the older one in its place in line
+                waiting.actions = actions;
+                waiting.deadline = deadline;
+                _rateCoalesced.fetch_add(1);
+                return;
             }
-            _lastRuleFireTime[ruleName] = now;
         }
     }
-    for (const auto& m : actions) {
-        if (executeAction(m)) {
-            _executedActionCount.fetch_add(1);
+    if (_throttled.size() >= std::max<size_t>(1, _rateLimits.maxBacklog)) {
+        _throttled.pop_front();
+        _rateDropped.fetch_add(1);
+    }
+    _throttled.push_back(ThrottledSequence{actions, ruleId, deadline});
+    _rateDelayed.fetch_add(1);
+    _throttledCount.store(_throttled.size());
+    scheduleDrain(now);
+}
+
+bool ActionManager::tryTakeTokens(uint32_t ruleId, std::chrono::steady_clock::time_point now) {
+    TokenBucket* rule = _rateLimits.rulePerMinute > 0 ? &ruleBucket(ruleId) : nullptr;
+    if (!_globalBucket.isAvailable(now) || (rule && !rule->isAvailable(now))) {
+        return false;
+    }
+    _globalBucket.take();
+    if (rule) {
+        rule->take();
+    }
+    return true;
+}
+
+TokenBucket& ActionManager::ruleBucket(uint32_t ruleId) {
+    if (ruleId >= _ruleBuckets.size()) {
+        size_t first = _ruleBuckets.size();
+        _ruleBuckets.resize(static_cast<size_t>(ruleId) + 1);
+        for (size_t i = first; i < _ruleBuckets.size(); ++i) {
+            _ruleBuckets[i].configure(_rateLimits.rulePerMinute, _rateLimits.ruleBurst);
+        }
+    }
+    return _ruleBuckets[ruleId];
+}
+
+void ActionManager::drainThrottled() {
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::shared_ptr<const std::vector<ActionInvocation>>> admitted;
+    for (size_t i = 0; i < _throttled.size();) {
+        ThrottledSequence& waiting = _throttled[i];
+        if (waiting.deadline <= now) {
+            _rateExpired.fetch_add(1);
+        } else if (!_rateLimits.enabled() || tryTakeTokens(waiting.ruleId, now)) {
+            admitted.push_back(std::move(waiting.actions));
         } else {
-            _failedActionCount.fetch_add(1);
-            allOk = false;
+            ++i;
+            continue;
         }
-        if (m.delayMs > 0) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(m.delayMs));
+        _throttled.erase(_throttled.begin() + static_cast<std::ptrdiff_t>(i));
+    }
+    _throttledCount.store(_throttled.size());
+    for (const auto& actions : admitted) {
+        runSequence(actions, 0);
+    }
+    if (!_throttled.empty()) {
+        scheduleDrain(now);
+    }
+}
+
+void ActionManager::scheduleDrain(std::chrono::steady_clock::time_point now) {
+    if (_throttled.empty()) {
+        return;
+    }
+    // Wake for whichever comes first: a waiting sequence's tokens or its deadline
+    auto wait = std::chrono::steady_clock::duration::max();
+    auto globalWait = _globalBucket.timeUntilAvailable(now);
+    for (const auto& waiting : _throttled) {
+        auto ready = globalWait;
+        if (_rateLimits.rulePerMinute > 0) {
+            ready = std::max(ready, ruleBucket(waiting.ruleId).timeUntilAvailable(now));
         }
+        wait = std::min({ wait, ready, waiting.deadline - now });
     }
-    return allOk;
+    auto delay = std::chrono::ceil<std::chrono::milliseconds>(std::max(wait, std::chrono::steady_clock::duration::zero()));
+    auto due = now + delay;
+    if (due >= _drainDue) {
+        return; // The pending drain comes first
+    }
+    // Re-arm earlier; the drain already on the wheel sees it was superseded and does nothing
+    _drainDue = due;
+    _scheduler.schedule(delay, [this, due]() {
+        if (due != _drainDue) {
+            return;
+        }
+        _drainDue = std::chrono::steady_clock::time_point::max();
+        drainThrottled();
+    });
+}
+
+void ActionManager::setRateLimits(const RateLimitSettings& settings) {
+    _scheduler.schedule(std::chrono::milliseconds(0), [this, settings]() {
+        _rateLimits = settings;
+        _globalBucket.configure(settings.globalPerMinute, settings.globalBurst);
+        for (auto& bucket : _ruleBuckets) {
+            bucket.configure(settings.rulePerMinute, settings.ruleBurst);
+        }
+        while (_throttled.size() > std::max<size_t>(1, settings.maxBacklog)) {
+            _throttled.pop_front();
+            _rateDropped.fetch_add(1);
+        }
+        drainThrottled();
+    });
+}
+
+RateLimitStats ActionManager::getRateLimitStats() const {
+    RateLimitStats stats;
+    stats.delayed = _rateDelayed.load();
+    stats.dropped = _rateDropped.load();
+    stats.coalesced = _rateCoalesced.load();
+    stats.expired = _rateExpired.load();
+    stats.backlog = _throttledCount.load();
+    return stats;
+}
+
+void ActionManager::runSequence(const std::shared_ptr<const std::vector<ActionInvocation>>& actions, size_t next) {
+    if (next == 0) {
+        _sequenceCount.fetch_add(1);
+    }
+    if (next == 0 && !actions->empty() && actions->front().event) {
+        auto latency = std::chrono::system_clock::now() - actions->front().event->timestamp;
+        uint64_t us = static_cast<uint64_t>(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(latency).count()));
+        _dispatchLatencyTotalUs.fetch_add(us);
+        _dispatchCount.fetch_add(1);
+        uint64_t worst = _dispatchLatencyMaxUs.load();
+        while (us > worst && !_dispatchLatencyMaxUs.compare_exchange_weak(worst, us)) {
+        }
+    }
+    // Only the scheduler thread runs sequences, so the run buffers are reused without locking
+    thread_local std::vector<ActionBatchStep> batch;
+    // A deque so growing it for a later step keeps the keys planned earlier in the run in place
+    thread_local std::deque<std::vector<int>> renderedKeys;
+    thread_local std::unique_ptr<bool[]> results;
+    thread_local size_t resultCapacity = 0;
+    size_t i = next;
+    while (i < actions->size()) {
+        // Plan the run of keyboard steps up to the first delay, so each target is focused once for it
+        batch.clear();
+        size_t rendered = 0;
+        size_t end = i;
+        while (end < actions->size()) {
+            const ActionInvocation& invocation = (*actions)[end];
+            const ActionStep& step = *invocation.step;
+            ActionBatchStep planned;
+            if (step.kind == ActionKind::Keystroke) {
+                const std::vector<int>* keys = &step.keys;
+                planned.modifiers = step.keyModifiers;
+                if (step.value.hasPlaceholders()) {
+                    if (renderedKeys.size() <= rendered) renderedKeys.resize(rendered + 1);
+                    parseChord(invocation.value(), renderedKeys[rendered], planned.modifiers);
+                    keys = &renderedKeys[rendered++];
+                }
+                if (keys->empty()) break;
+                planned.op = keys->size() == 1 ? ActionBatchStep::Op::Keystroke : ActionBatchStep::Op::Chord;
+                planned.keys = keys;
+            } else if (step.kind == ActionKind::Text || step.kind == ActionKind::Command) {
+                planned.op = step.kind == ActionKind::Text ? ActionBatchStep::Op::Text : ActionBatchStep::Op::Command;
+                planned.text = &invocation.value();
+            } else {
+                break;
+            }
+            batch.push_back(planned);
+            ++end;
+            if (step.mapping.delayMs > 0) break;
+        }
+
+        if (batch.empty()) {
+            // sms, unknown types and unparseable keystrokes run alone and report their own errors
+            if (executeAction((*actions)[i])) {
+                _executedActionCount.fetch_add(1);
+            } else {
+                _failedActionCount.fetch_add(1);
+            }
+            end = i + 1;
+        } else if (!_sink->isReady()) {
+            std::cerr << "Action sink not ready" << std::endl;
+            _failedActionCount.fetch_add(batch.size());
+        } else {
+            if (resultCapacity < batch.size()) {
+                resultCapacity = batch.size();
+                results.reset(new bool[resultCapacity]);
+            }
+            _sink->sendBatch(batch.data(), batch.size(), results.get());
+            for (size_t r = 0; r < batch.size(); ++r) {
+                if (results[r]) {
+                    _executedActionCount.fetch_add(1);
+                } else {
+                    _failedActionCount.fetch_add(1);
+                }
+            }
+        }
+
+        int delayMs = (*actions)[end - 1].step->mapping.delayMs;
+        if (delayMs > 0 && end < actions->size()) {
+            // The rest of the sequence waits on the wheel; the scheduler thread moves on
+            _scheduler.schedule(std::chrono::milliseconds(delayMs), [this, actions, end]() { runSequence(actions, end); });
+            return;
+        }
+        i = end;
+    }
+}
+
+double ActionManager::getFocusSwitchesPerSequence() const {
+    size_t sequences = _sequenceCount.load();
+    return sequences > 0 ? static_cast<double>(_sink->getFocusSwitchCount()) / sequences : 0.0;
+}
+
+bool ActionManager::getDispatchLatency(double& avgMs, double& maxMs) const {
+    size_t count = _dispatchCount.load();
+    if (count == 0) {
+        avgMs = maxMs = 0.0;
+        return false;
+    }
+    avgMs = _dispatchLatencyTotalUs.load() / 1000.0 / count;
+    maxMs = _dispatchLatencyMaxUs.load() / 1000.0;
+    return true;
+}
+
+void ActionManager::prepareRuleSteps(const std::string& ruleName, const std::vector<ActionStepPtr>& steps) {
+    if (!_regexMatcher) {
+        return;
+    }
+    _cooldowns.reserve(_regexMatcher->getRuleIdCount());
+    // Bind #{name} placeholders to the rule's compiled groups, then record which groups the steps read
+    int demand = 0;
+    for (const auto& step : steps) {
+        auto unresolved = step->value.resolveNames([&](const std::string& name) {
+            return _regexMatcher->getCaptureIndex(ruleName, name);
+        });
+        for (const auto& name : unresolved) {
+            std::cerr << "Rule '" << ruleName << "': unknown capture group '" << name
+                      << "' in action value '" << step->mapping.actionValue << "'" << std::endl;
+        }
+        if (step->kind == ActionKind::Unknown) {
+            std::cerr << "Rule '" << ruleName << "': unknown action type '" << step->mapping.actionType << "'" << std::endl;
+        } else if (step->kind == ActionKind::Keystroke && step->keys.empty() && !step->value.hasPlaceholders()) {
+            std::cerr << "Rule '" << ruleName << "': no known key in keystroke '" << step->mapping.actionValue << "'" << std::endl;
+        }
+        // sms reads the full log line from the event, not a capture
+        if (step->kind != ActionKind::Sms) {
+            demand = std::max(demand, step->value.highestGroup());
+        }
+    }
+    _regexMatcher->setCaptureDemand(ruleName, demand);
 }
 
 void ActionManager::setRegexMatcher(RegexMatcher* matcher) {
+    if (matcher != _regexMatcher) {
+        // Rule ids are per matcher
+        _cooldowns.reset();
+        _scheduler.schedule(std::chrono::milliseconds(0), [this]() { _ruleBuckets.clear(); });
+    }
     _regexMatcher = matcher;
 }
 
@@ -207,7 +489,7 @@ bool ActionManager::setActionEnabled(const std::string& ruleName, bool enabled)
     std::lock_guard<std::mutex> lock(_mutex);
     auto it = _actionMappings.find(ruleName);
     if (it != _actionMappings.end()) {
-        for (auto& step : it->second) { step.enabled = enabled; }
+        for (auto& step : it->second) { step->mapping.enabled = enabled; }
         return true;
     }
     return false;
@@ -228,164 +510,89 @@ void ActionManager::clearActionMappings() {
     _actionMappings.clear();
 }
 
-bool ActionManager::executeAction(const ActionMapping& mapping) {
-    if (!_actionSender.isReady()) {
-        std::cerr << "ActionSender not ready" << std::endl;
+bool ActionManager::executeAction(const ActionInvocation& invocation) {
+    if (!_sink->isReady()) {
+        std::cerr << "Action sink not ready" << std::endl;
         return false;
     }
     
-    if (mapping.actionType == "keystroke") {
-        // Try to parse as chord first (multiple keys)
-        std::vector<int> keys; int modifiers = 0;
-        if (parseChord(mapping.actionValue, keys, modifiers) && !keys.empty()) {
-            if (keys.size() == 1) {
-                return _actionSender.sendKeystroke(keys[0], modifiers);
+    const ActionStep& step = *invocation.step;
+    switch (step.kind) {
+        case ActionKind::Keystroke: {
+            const std::vector<int>* keys = &step.keys;
+            int modifiers = step.keyModifiers;
+            std::vector<int> renderedKeys;
+            if (step.value.hasPlaceholders()) {
+                // Only values with placeholders are parsed per execution
+                parseChord(invocation.value(), renderedKeys, modifiers);
+                keys = &renderedKeys;
             }
-            return _actionSender.sendChord(keys, modifiers, false);
-        }
-        // Fallback to single key parsing
-        int key, singleMods;
-        if (parseKeystroke(mapping.actionValue, key, singleMods)) {
-            return _actionSender.sendKeystroke(key, singleMods);
-        } else {
-            std::cerr << "Failed to parse keystroke: " << mapping.actionValue << std::endl;
-            return false;
-        }
-    } else if (mapping.actionType == "command") {
-        return _actionSender.sendCommand(mapping.actionValue);
-    } else if (mapping.actionType == "text") {
-        return _actionSender.sendText(mapping.actionValue);
-    } else if (mapping.actionType == "sms") {
-        // For SMS action type, we need to extract the tell message from the log line
-        // and send it as an email. The log line should match the pattern: [word] tells you, '[message]'
-        return _actionSender.sendSms(mapping.logLine);
-    } else {
-        std::cerr << "Unknown action type: " << mapping.actionType << std::endl;
-        return false;
-    }
-}
-
-bool ActionManager::parseKeystroke(const std::string& keystrokeString, int& key, int& modifiers) {
-    key = 0;
-    modifiers = 0;
-
-    // Normalize: lowercase and remove spaces to support formats like "Ctrl + 1"
-    std::string normalized = keystrokeString;
-    std::transform(normalized.begin(), normalized.end(), normalized.begin(), ::tolower);
-    normalized.erase(std::remove_if(normalized.begin(), normalized.end(), [](unsigned char ch){ return std::isspace(ch); }), normalized.end());
-
-    // Split by '+'
-    std::vector<std::string> tokens;
-    std::string current;
-    for (char c : normalized) {
-        if (c == '+') {
-            if (!current.empty()) { tokens.push_back(current); current.clear(); }
-        } else {
-            current.push_back(c);
-        }
-    }
-    if (!current.empty()) tokens.push_back(current);
-
-    for (const auto& tok : tokens) {
-        if (tok == "ctrl" || tok == "control") { modifiers |= MOD_CONTROL; continue; }
-        if (tok == "alt") { modifiers |= MOD_ALT; continue; }
-        if (tok == "shift") { modifiers |= MOD_SHIFT; continue; }
-        if (key == 0) {
-            key = getVirtualKeyCode(tok);
-        } else {
-            // Multiple non-modifier keys not supported in single keystroke
-            // Ignore extras for now
+            if (keys->empty()) {
+                std::cerr << "Failed to parse keystroke: " << invocation.value() << std::endl;
+                return false;
+            }
+            if (keys->size() == 1) {
+                return _sink->sendKeystroke(keys->front(), modifiers);
+            }
+            return _sink->sendChord(*keys, modifiers, false);
         }
+        case ActionKind::Command:
+            return _sink->sendCommand(invocation.value());
+        case ActionKind::Text:
+            return _sink->sendText(invocation.value());
+        case ActionKind::Sms:
+            // The email carries the full log line so the tell can be extracted from it
+            return _sink->sendSms(invocation.event ? invocation.event->data : invocation.value());
+        case ActionKind::Unknown:
+            break;
     }
-
-    return key != 0;
+    std::cerr << "Unknown action type: " << step.mapping.actionType << std::endl;
+    return false;
 }
 
-bool ActionManager::parseChord(const std::string& keystrokeString, std::vector<int>& keys, int& modifiers) {
+bool ActionManager::parseChord(std::string_view keystrokeString, std::vector<int>& keys, int& modifiers) {
     keys.clear();
     modifiers = 0;
-    std::string normalized = keystrokeString;
-    std::transform(normalized.begin(), normalized.end(), normalized.begin(), ::tolower);
-    normalized.erase(std::remove_if(normalized.begin(), normalized.end(), [](unsigned char ch){ return std::isspace(ch); }), normalized.end());
-
-    // Split by '+'
-    std::vector<std::string> tokens;
-    std::string current;
-    for (char c : normalized) {
-        if (c == '+') {
-            if (!current.empty()) { tokens.push_back(current); current.clear(); }
-        } else {
-            current.push_back(c);
-        }
-    }
-    if (!current.empty()) tokens.push_back(current);
-
-    for (const auto& tok : tokens) {
-        if (tok == "ctrl" || tok == "control") { modifiers |= MOD_CONTROL; continue; }
-        if (tok == "alt") { modifiers |= MOD_ALT; continue; }
-        if (tok == "shift") { modifiers |= MOD_SHIFT; continue; }
-        int vk = getVirtualKeyCode(tok);
-        if (vk != 0) keys.push_back(vk);
-    }
-    return !keys.empty();
-}
-
-int ActionManager::getVirtualKeyCode(const std::string& keyString) const {
-    // Function keys
-    if (keyString == "f1") return VK_F1;
-    if (keyString == "f2") return VK_F2;
-    if (keyString == "f3") return VK_F3;
-    if (keyString == "f4") return VK_F4;
-    if (keyString == "f5") return VK_F5;
-    if (keyString == "f6") return VK_F6;
-    if (keyString == "f7") return VK_F7;
-    if (keyString == "f8") return VK_F8;
-    if (keyString == "f9") return VK_F9;
-    if (keyString == "f10") return VK_F10;
-    if (keyString == "f11") return VK_F11;
-    if (keyString == "f12") return VK_F12;
-    
-    // Special keys
-    if (keyString == "enter" || keyString == "return") return VK_RETURN;
-    if (keyString == "space") return VK_SPACE;
-    if (keyString == "tab") return VK_TAB;
-    if (keyString == "escape" || keyString == "esc") return VK_ESCAPE;
-    if (keyString == "backspace") return VK_BACK;
-    if (keyString == "delete") return VK_DELETE;
-    if (keyString == "insert") return VK_INSERT;
-    if (keyString == "home") return VK_HOME;
-    if (keyString == "end") return VK_END;
-    if (keyString == "pageup") return VK_PRIOR;
-    if (keyString == "pagedown") return VK_NEXT;
-    if (keyString == "up") return VK_UP;
-    if (keyString == "down") return VK_DOWN;
-    if (keyString == "left") return VK_LEFT;
-    if (keyString == "right") return VK_RIGHT;
-    
-    // Arrow keys
-    if (keyString == "up") return VK_UP;
-    if (keyString == "down") return VK_DOWN;
-    if (keyString == "left") return VK_LEFT;
-    if (keyString == "right") return VK_RIGHT;
-    
-    // Single character
-    if (keyString.length() == 1) {
-        char c = keyString[0];
-        if (c >= 'a' && c <= 'z') {
-            return c - 32; // Convert to uppercase
+    // Tokens are split on '+', lowercased and stripped of spaces in a fixed buffer
+    char token[16];
+    size_t length = 0;
+    bool overflow = false;
+    for (size_t i = 0; i <= keystrokeString.size(); ++i) {
+        if (i == keystrokeString.size() || keystrokeString[i] == '+') {
+            int vk = 0, modifier = 0;
+            if (length > 0 && !overflow && lookupKeyName(std::string_view(token, length), vk, modifier)) {
+                modifiers |= modifier;
+                if (vk != 0) keys.push_back(vk);
+            }
+            length = 0;
+            overflow = false;
+            continue;
         }
-        if (c >= '0' && c <= '9') {
-            return c;
+        unsigned char c = static_cast<unsigned char>(keystrokeString[i]);
+        if (std::isspace(c)) continue;
+        if (length == sizeof(token)) {
+            overflow = true;
+            continue;
         }
+        token[length++] = static_cast<char>(std::tolower(c));
     }
-    
-    return 0;
+    return !keys.empty();
 }
 
-bool ActionManager::checkEmailResponses() {
-    if (!_actionSender.isReady()) {
+bool ActionManager::submitEmailResponse(const std::string& response) {
+    if (response.empty() || !_sink->isReady()) {
         return false;
     }
-    
-    return _actionSender.checkEmailResponses();
+    // Runs on the scheduler thread like every other step, so it never interleaves with a sequence's keys
+    _scheduler.schedule(std::chrono::milliseconds(0), [this, response]() {
+        if (_sink->sendCommand(response)) {
+            std::cout << "[EMAIL RESPONSE] Command sent: " << response << std::endl;
+            _executedActionCount.fetch_add(1);
+            _sink->sendAcknowledgmentEmail(response);
+        } else {
+            std::cerr << "[EMAIL RESPONSE] Failed to send command: " << response << std::endl;
+            _failedActionCount.fetch_add(1);
+        }
+    });
+    return true;
 }
\ No newline at end of file
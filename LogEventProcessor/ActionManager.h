@@ -1,16 +1,23 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <vector>
-#include <unordered_map>
 #include <chrono>
-#include "ActionSender.h"
+#include <deque>
+#include "ActionSink.h"
+#include "ActionScheduler.h"
+#include "CooldownTable.h"
+#include "RateLimit.h"
 #include "RegexMatcher.h"
+#include "ActionTemplate.h"
 #include "LogEvent.h"
 
+class ActionSender;
+
 /**
  * @struct ActionMapping
  * @brief Maps regex rule names to actions
@@ -18,8 +25,7 @@
 struct ActionMapping {
     std::string ruleName;
     std::string actionType;  // "keystroke", "command", "text", "sms"
-    std::string actionValue; // The actual action to perform
-    std::string logLine;     // The original log line (for SMS action type)
+    std::string actionValue; // The actual action to perform (may contain # placeholders)
     int modifiers;           // Modifier keys for keystrokes
     bool enabled;
     int delayMs;             // Delay after executing this step (ms)
@@ -31,13 +37,64 @@ struct ActionMapping {
         : ruleName(rule), actionType(type), actionValue(value), modifiers(mods), enabled(isEnabled), delayMs(0) {}
 };
 
+/**
+ * @brief Action type, resolved from ActionMapping::actionType at load
+ */
+enum class ActionKind : uint8_t { Keystroke, Command, Text, Sms, Unknown };
+
+/**
+ * @struct ActionStep
+ * @brief A configured action step compiled at load time
+ *
+ * The value is parsed into a template, the type into an ActionKind, and a keystroke value
+ * without placeholders into its key list and modifier mask, so executing the step does no
+ * parsing and no allocation.
+ */
+struct ActionStep {
+    ActionMapping mapping;
+    ActionTemplate value;
+    ActionKind kind;
+    std::vector<int> keys; // Keystroke keys in press order; empty if the value has placeholders or no known key
+    int keyModifiers = 0;  // MOD_* mask parsed from the keystroke value
+    
+    explicit ActionStep(const ActionMapping& m);
+};
+
+using ActionStepPtr = std::shared_ptr<ActionStep>;
+
+/**
+ * @struct ActionInvocation
+ * @brief One step to execute for a matched event; shares the configured step instead of copying it
+ */
+struct ActionInvocation {
+    std::shared_ptr<const ActionStep> step;
+    std::string renderedValue; // Substituted value; only filled when the step's template has placeholders
+    LogEventPtr event;         // Source event (sms reads the full log line from it)
+    uint32_t ruleId = 0;       // RegexRule::id of the matched rule
+    size_t ruleIndex = 0;      // Its index in the matcher, for per-rule counters
+    int cooldownMs = 0;        // The matched rule's cooldown
+    
+    const std::string& value() const { return step->value.hasPlaceholders() ? renderedValue : step->mapping.actionValue; }
+    const std::string& ruleName() const { return step->mapping.ruleName; }
+};
+
 /**
  * @class ActionManager
  * @brief Manages the connection between regex matching and action execution
  */
 class ActionManager {
 public:
+    /**
+     * @brief Create a manager that drives the game client (ActionSender) on Windows, or a
+     *        counting RecordingActionSink elsewhere
+     */
     ActionManager();
+
+    /**
+     * @brief Create a manager that executes steps through the given sink
+     * @param sink Destination for every executed step
+     */
+    explicit ActionManager(std::unique_ptr<ActionSink> sink);
     ~ActionManager();
     
     /**
@@ -80,10 +137,15 @@ public:
     void setRegexMatcher(RegexMatcher* matcher);
     
     /**
-     * @brief Get the action sender instance
-     * @return Reference to the action sender
+     * @brief Get the sink executed steps go to
+     */
+    ActionSink& getActionSink() { return *_sink; }
+
+    /**
+     * @brief Get the Win32 action sender
+     * @return The sender, or nullptr when the sink is not an ActionSender
      */
-    ActionSender& getActionSender() { return _actionSender; }
+    ActionSender* getActionSender() { return _sender; }
     
     /**
      * @brief Enable or disable an action mapping
@@ -126,58 +188,167 @@ public:
     /**
      * @brief Collect actions that should be executed for a given event without executing them
      * @param event The log event to evaluate
-     * @param outActions Output vector of ActionMapping in deterministic order
+     * @param outActions Output vector of invocations in deterministic order
      * @return true if any actions were collected
      */
-    bool getActionsForEvent(const LogEventPtr& event, std::vector<ActionMapping>& outActions) const;
+    bool getActionsForEvent(const LogEventPtr& event, std::vector<ActionInvocation>& outActions) const;
 
     /**
-     * @brief Execute a list of actions sequentially
+     * @brief Schedule a list of actions to run in order on the scheduler thread
+     *
+     * Returns without waiting: a step's delay_ms defers the steps after it on the timer
+     * wheel instead of sleeping, so other sequences keep running in the meantime. The steps
+     * of each rule still cooling down are dropped first; each other rule's steps run as a
+     * sequence of their own, under that rule's rate limit.
      * @param actions Actions to execute
-     * @return true if all actions succeeded
+     * @return true if any actions were scheduled
+     */
+    bool executeActions(const std::vector<ActionInvocation>& actions);
+
+    /**
+     * @brief Get the number of scheduled steps waiting for their due time
+     */
+    size_t getPendingStepCount() const { return _scheduler.getPendingCount(); }
+
+    /**
+     * @brief Get the time from reading a line to sending the first step of its actions
+     * @param avgMs Output average over every sequence run so far
+     * @param maxMs Output worst case
+     * @return true if any sequence has run
      */
-    bool executeActions(const std::vector<ActionMapping>& actions);
+    bool getDispatchLatency(double& avgMs, double& maxMs) const;
+
+    /**
+     * @brief Get the average number of target window focus switches per action sequence
+     */
+    double getFocusSwitchesPerSequence() const;
+
+    /**
+     * @brief Set the token-bucket limits the scheduler applies when a sequence starts
+     *
+     * Applied on the scheduler thread; sequences already waiting are re-checked against the
+     * new limits (all of them start when limits are turned off).
+     */
+    void setRateLimits(const RateLimitSettings& settings);
+
+    /**
+     * @brief Get the counters of sequences held back by rate limits
+     */
+    RateLimitStats getRateLimitStats() const;
 
 private:
-    ActionSender _actionSender;
+    std::unique_ptr<ActionSink> _sink;
+    ActionSender* _sender = nullptr; // _sink, when it is the Win32 sender
+    ActionScheduler _scheduler;
     RegexMatcher* _regexMatcher;
-    std::map<std::string, std::vector<ActionMapping>> _actionMappings;
+    std::map<std::string, std::vector<ActionStepPtr>> _actionMappings;
     std::atomic<size_t> _executedActionCount;
     std::atomic<size_t> _failedActionCount;
+    std::atomic<uint64_t> _dispatchLatencyTotalUs{0};
+    std::atomic<uint64_t> _dispatchLatencyMaxUs{0};
+    std::atomic<size_t> _dispatchCount{0};
+    std::atomic<size_t> _sequenceCount{0};
     mutable std::mutex _mutex;
-    // Cooldown tracking per rule
-    std::unordered_map<std::string, std::chrono::steady_clock::time_point> _lastRuleFireTime;
-    mutable std::mutex _cooldownMutex;
+    // Cooldown state per rule id
+    CooldownTable _cooldowns;
+
+    // A sequence waiting for a token
+    struct ThrottledSequence {
+        std::shared_ptr<const std::vector<ActionInvocation>> actions;
+        uint32_t ruleId;
+        std::chrono::steady_clock::time_point deadline; // Dropped as stale after this
+    };
+    // Rate limit state; only the scheduler thread touches it
+    RateLimitSettings _rateLimits;
+    TokenBucket _globalBucket;
+    std::vector<TokenBucket> _ruleBuckets; // By rule id
+    std::deque<ThrottledSequence> _throttled;
+    std::chrono::steady_clock::time_point _drainDue = std::chrono::steady_clock::time_point::max(); // Pending drain
+    std::atomic<size_t> _rateDelayed{0};
+    std::atomic<size_t> _rateDropped{0};
+    std::atomic<size_t> _rateCoalesced{0};
+    std::atomic<size_t> _rateExpired{0};
+    std::atomic<size_t> _throttledCount{0};
     
     /**
-     * @brief Execute an action based on the mapping
-     * @param mapping The action mapping to execute
+     * @brief Execute one action step
+     * @param invocation The step and its substituted value
      * @return true if action was executed successfully, false otherwise
      */
-    bool executeAction(const ActionMapping& mapping);
-    
+    bool executeAction(const ActionInvocation& invocation);
+
+    /**
+     * @brief Run steps of a sequence until one asks for a delay, then schedule the rest
+     *
+     * Consecutive keyboard steps up to a delay go to the sink as one batch, so a sink with
+     * several target windows focuses each window once per batch instead of once per step.
+     * @param actions The whole sequence
+     * @param next Index of the first step to run
+     */
+    void runSequence(const std::shared_ptr<const std::vector<ActionInvocation>>& actions, size_t next);
+
+    /**
+     * @brief Schedule a sequence whose cooldowns have already been claimed
+     */
+    void scheduleSequence(std::vector<ActionInvocation> actions);
+
+    /**
+     * @brief Start a sequence if its rate limits allow, otherwise apply the excess policy
+     */
+    void admitSequence(const std::shared_ptr<const std::vector<ActionInvocation>>& actions);
+
+    /**
+     * @brief Take a token from the global and the rule's bucket if both have one
+     */
+    bool tryTakeTokens(uint32_t ruleId, std::chrono::steady_clock::time_point now);
+
+    /**
+     * @brief Start the waiting sequences that have tokens now and drop the stale ones
+     */
+    void drainThrottled();
+
+    /**
+     * @brief Wake drainThrottled when the next waiting sequence can start or expires
+     */
+    void scheduleDrain(std::chrono::steady_clock::time_point now);
+
+    TokenBucket& ruleBucket(uint32_t ruleId);
+
     /**
-     * @brief Parse a keystroke string (e.g., "ctrl+a", "f1", "enter")
-     * @param keystrokeString The string to parse
-     * @param key Output parameter for the virtual key code
-     * @param modifiers Output parameter for modifier keys
-     * @return true if parsing was successful, false otherwise
+     * @brief Append invocations for every enabled step of a matched rule
+     * @param rule The matched rule
+     * @param ruleIndex Its index in the matcher
+     * @param matches Capture spans into event->data
+     * @param event The matched event
+     * @param out Output invocations
+     * @return true if any invocation was appended
      */
-    bool parseKeystroke(const std::string& keystrokeString, int& key, int& modifiers);
-    // Parse possibly multiple keys like "ctrl+1+2" or "alt + f1 + f2"; returns list of keys and modifiers
-    bool parseChord(const std::string& keystrokeString, std::vector<int>& keys, int& modifiers);
+    bool appendRuleActions(const RegexRule& rule, size_t ruleIndex, const MatchCaptures& matches,
+                           const LogEventPtr& event, std::vector<ActionInvocation>& out) const;
     
+public:
+    /**
+     * @brief Parse a keystroke value like "ctrl+1+2" or "Alt + F1" (case and spaces ignored)
+     * @param keystrokeString The value to parse
+     * @param keys Output virtual key codes in press order; unknown names are skipped
+     * @param modifiers Output MOD_* mask
+     * @return true if at least one key was found
+     */
+    static bool parseChord(std::string_view keystrokeString, std::vector<int>& keys, int& modifiers);
+
+private:
     /**
-     * @brief Get virtual key code from string
-     * @param keyString The key string (e.g., "f1", "enter", "space")
-     * @return Virtual key code or 0 if not found
+     * @brief Resolve named placeholders against the rule's pattern and record the captures the steps consume
+     * @param ruleName Rule name
+     * @param steps All action steps mapped to the rule
      */
-    int getVirtualKeyCode(const std::string& keyString) const;
+    void prepareRuleSteps(const std::string& ruleName, const std::vector<ActionStepPtr>& steps);
     
 public:
     /**
-     * @brief Check for email responses and send them as commands
-     * @return True if a response was processed
+     * @brief Queue an emailed response to be sent to the game as a command, then acknowledged
+     * @param response The response command
+     * @return true if it was queued (false while the sink is not ready)
      */
-    bool checkEmailResponses();
+    bool submitEmailResponse(const std::string& response);
 };
@@ -0,0 +1,178 @@
+#include "ActionScheduler.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+namespace {
+constexpr uint64_t kNoWake = std::numeric_limits<uint64_t>::max();
+}
+
+ActionScheduler::ActionScheduler() : _epoch(std::chrono::steady_clock::now()) {
+}
+
+ActionScheduler::~ActionScheduler() {
+    stop();
+}
+
+void ActionScheduler::start() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_thread.joinable()) {
+        return;
+    }
+    _stopRequested = false;
+    _thread = std::thread(&ActionScheduler::run, this);
+}
+
+void ActionScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_thread.joinable()) {
+            return;
+        }
+        _stopRequested = true;
+    }
+    _condition.notify_all();
+    _thread.join();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t dropped = _pending.load();
+    for (auto& level : _levels) {
+        for (auto& slot : level.slots) {
+            slot.clear();
+        }
+        level.occupied = 0;
+    }
+    _ready.clear();
+    _pending.store(0);
+    if (dropped > 0) {
+        std::cout << "[SCHEDULER] Dropped " << dropped << " pending action step(s) on shutdown" << std::endl;
+    }
+}
+
+void ActionScheduler::schedule(std::chrono::milliseconds delay, Task task) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        // nowTick() truncates, so round up a tick to never run a delayed task early
+        int64_t ms = std::max<int64_t>(0, delay.count());
+        uint64_t due = nowTick() + static_cast<uint64_t>(ms) + (ms > 0 ? 1 : 0);
+        insert(Entry{ due, std::move(task) });
+        _pending.fetch_add(1);
+    }
+    _condition.notify_one();
+}
+
+uint64_t ActionScheduler::nowTick() const {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - _epoch).count());
+}
+
+void ActionScheduler::insert(Entry entry) {
+    if (entry.dueTick <= _currentTick) {
+        _ready.push_back(std::move(entry));
+        return;
+    }
+    uint64_t delta = entry.dueTick - _currentTick;
+    for (size_t level = 0; level < kLevels; ++level) {
+        unsigned shift = static_cast<unsigned>(level * kSlotBits);
+        bool last = level + 1 == kLevels;
+        if (!last && delta >= (uint64_t(1) << (shift + kSlotBits))) {
+            continue;
+        }
+        // Tasks beyond the last level's span park at its far end and are re-filed when it cascades
+        uint64_t tick = last ? std::min(entry.dueTick, _currentTick + (uint64_t(1) << (shift + kSlotBits)) - 1) : entry.dueTick;
+        size_t slot = static_cast<size_t>((tick >> shift) & kSlotMask);
+        _levels[level].slots[slot].push_back(std::move(entry));
+        _levels[level].occupied |= uint64_t(1) << slot;
+        return;
+    }
+}
+
+void ActionScheduler::cascade(size_t level) {
+    unsigned shift = static_cast<unsigned>(level * kSlotBits);
+    size_t slot = static_cast<size_t>((_currentTick >> shift) & kSlotMask);
+    std::vector<Entry> entries;
+    entries.swap(_levels[level].slots[slot]);
+    _levels[level].occupied &= ~(uint64_t(1) << slot);
+    for (auto& entry : entries) {
+        insert(std::move(entry));
+    }
+}
+
+void ActionScheduler::advanceTo(uint64_t tick) {
+    while (_currentTick < tick) {
+        bool empty = true;
+        for (const auto& level : _levels) {
+            empty = empty && level.occupied == 0;
+        }
+        if (empty) {
+            _currentTick = tick;
+            return;
+        }
+        ++_currentTick;
+        // Re-file the higher levels whose slot boundary this tick crosses, coarsest first
+        for (size_t level = kLevels - 1; level > 0; --level) {
+            if ((_currentTick & ((uint64_t(1) << (level * kSlotBits)) - 1)) == 0) {
+                cascade(level);
+            }
+        }
+        size_t slot = static_cast<size_t>(_currentTick & kSlotMask);
+        auto& due = _levels[0].slots[slot];
+        if (!due.empty()) {
+            for (auto& entry : due) {
+                _ready.push_back(std::move(entry));
+            }
+            due.clear();
+            _levels[0].occupied &= ~(uint64_t(1) << slot);
+        }
+    }
+}
+
+uint64_t ActionScheduler::ticksUntilNextWake() const {
+    if (!_ready.empty()) {
+        return 0;
+    }
+    bool empty = true;
+    for (const auto& level : _levels) {
+        empty = empty && level.occupied == 0;
+    }
+    if (empty) {
+        return kNoWake;
+    }
+    // The next level-0 wrap may cascade tasks down, so never sleep past it
+    uint64_t wake = kSlots - (_currentTick & kSlotMask);
+    uint64_t occupied = _levels[0].occupied;
+    for (uint64_t i = 1; i < wake && occupied != 0; ++i) {
+        if (occupied & (uint64_t(1) << ((_currentTick + i) & kSlotMask))) {
+            return i;
+        }
+    }
+    return wake;
+}
+
+void ActionScheduler::run() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stopRequested) {
+        advanceTo(nowTick());
+        if (!_ready.empty()) {
+            std::vector<Entry> batch;
+            batch.swap(_ready);
+            lock.unlock();
+            for (auto& entry : batch) {
+                try {
+                    entry.task();
+                } catch (const std::exception& ex) {
+                    std::cerr << "[SCHEDULER] Action step failed: " << ex.what() << std::endl;
+                }
+                _pending.fetch_sub(1);
+            }
+            lock.lock();
+            continue;
+        }
+        uint64_t wait = ticksUntilNextWake();
+        if (wait == kNoWake) {
+            _condition.wait(lock);
+        } else {
+            _condition.wait_until(lock, _epoch + std::chrono::milliseconds(_currentTick + wait));
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ActionScheduler
+ * @brief Runs tasks at their due time on one thread, using a hierarchical timer wheel.
+ *
+ * Four levels of 64 slots at 1 ms resolution cover about 4.6 hours; later tasks park in the
+ * last level and are re-filed as time advances. Scheduling is O(1), and the thread only
+ * wakes for the next occupied level-0 slot or the next level-0 wrap, never per millisecond.
+ * Tasks due in the same tick run in the order they were scheduled. A task may schedule
+ * follow-up tasks, which is how multi-step sequences keep their order without any thread
+ * sleeping between steps.
+ */
+class ActionScheduler {
+public:
+    using Task = std::function<void()>;
+
+    ActionScheduler();
+    ~ActionScheduler();
+
+    ActionScheduler(const ActionScheduler&) = delete;
+    ActionScheduler& operator=(const ActionScheduler&) = delete;
+
+    /**
+     * @brief Start the scheduler thread
+     */
+    void start();
+
+    /**
+     * @brief Stop the scheduler thread; tasks not yet due are dropped
+     */
+    void stop();
+
+    /**
+     * @brief Schedule a task
+     * @param delay Time from now until the task runs (zero runs it on the next pass)
+     * @param task Task to run on the scheduler thread
+     */
+    void schedule(std::chrono::milliseconds delay, Task task);
+
+    /**
+     * @brief Get the number of tasks waiting to run
+     */
+    size_t getPendingCount() const { return _pending.load(); }
+
+private:
+    static constexpr unsigned kSlotBits = 6;
+    static constexpr size_t kSlots = size_t(1) << kSlotBits;
+    static constexpr size_t kLevels = 4;
+    static constexpr uint64_t kSlotMask = kSlots - 1;
+
+    struct Entry {
+        uint64_t dueTick;
+        Task task;
+    };
+
+    struct Level {
+        std::vector<Entry> slots[kSlots];
+        uint64_t occupied = 0; // Bit n set when slots[n] is non-empty
+    };
+
+    std::chrono::steady_clock::time_point _epoch;
+    uint64_t _currentTick = 0;          // Every tick up to and including this one has run
+    Level _levels[kLevels];
+    std::vector<Entry> _ready;          // Due at or before the current tick
+
+    mutable std::mutex _mutex;
+    std::condition_variable _condition;
+    std::thread _thread;
+    bool _stopRequested = false;
+    std::atomic<size_t> _pending{0};
+
+    uint64_t nowTick() const;
+    void insert(Entry entry);
+    void cascade(size_t level);
+    void advanceTo(uint64_t tick);
+    uint64_t ticksUntilNextWake() const;
+    void run();
+};
@@ -6,15 +6,23 @@
 #include <tlhelp32.h>
 #include <map>
 #include <windows.h>
-#include <fstream>
 #include <cstdio>
 #include <ctime>
 
+namespace {
+// Folder holding EmailService.exe and the config.yaml it reads
+const char* const kEmailServiceDirectory = "C:\\Users\\Jake\\source\\repos\\EQLogAutomator\\x64\\Release";
+}
+
 ActionSender::ActionSender() 
     : _isReady(false), _successCount(0), _failureCount(0), 
       _processId(0), _windowHandle(NULL), _processHandle(NULL),
-      _startupTime(std::chrono::steady_clock::now()),
-      _targetAllProcesses(true) {
+      _targetAllProcesses(true),
+      _emailHelper(std::make_unique<HelperProcess>(std::string(kEmailServiceDirectory) + "\\EmailService.exe --serve config.yaml",
+                                                    kEmailServiceDirectory)),
+      _outbox(std::make_unique<EmailOutbox>([this](const std::string& kind, const std::string& body) {
+          return deliverEmail(kind, body);
+      })) {
 }
 
 ActionSender::~ActionSender() {
@@ -191,52 +199,32 @@ bool ActionSender::sendKeystroke(int key, int modifiers) {
             std::cerr << "Failed to bring window to foreground pid=" << tgt.pid << std::endl;
             continue;
         }
-    
-    bool success = true;
-    
-    // Send modifier keys down using scancodes (more reliable for games)
-    if (modifiers & MOD_CONTROL) {
-        success &= sendKeyScan(VK_CONTROL, false);
-    }
-    if (modifiers & MOD_ALT) {
-        success &= sendKeyScan(VK_MENU, false);
-    }
-    if (modifiers & MOD_SHIFT) {
-        success &= sendKeyScan(VK_SHIFT, false);
-    }
-    
-        // Send main key using scancodes (games often prefer raw scancodes)
-        success &= sendKeyScan(key, false);
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        success &= sendKeyScan(key, true);
-    
-    // Send modifier keys up using scancodes
-    if (modifiers & MOD_SHIFT) {
-        success &= sendKeyScan(VK_SHIFT, true);
-    }
-    if (modifiers & MOD_ALT) {
-        success &= sendKeyScan(VK_MENU, true);
-    }
-    if (modifiers & MOD_CONTROL) {
-        success &= sendKeyScan(VK_CONTROL, true);
-    }
-    
-        if (success) {
-            _successCount.fetch_add(1);
+        if (emitKeystroke(key, modifiers, tgt.pid)) {
             anySuccess = true;
-            std::cout << "[SEND] Keystroke success vk=" << key
-                      << " mods=" << modifiers
-                      << " pid=" << tgt.pid << std::endl;
-        } else {
-            _failureCount.fetch_add(1);
-            std::cerr << "[SEND] Keystroke FAILED vk=" << key
-                      << " mods=" << modifiers
-                      << " pid=" << tgt.pid << std::endl;
         }
     }
     return anySuccess;
 }
 
+bool ActionSender::emitKeystroke(int key, int modifiers, DWORD pid) {
+    _inputBatch.clear();
+    _inputBatch.addKeystroke(key, modifiers);
+    bool success = submitInput(_inputBatch);
+    
+    if (success) {
+        _successCount.fetch_add(1);
+        std::cout << "[SEND] Keystroke success vk=" << key
+                  << " mods=" << modifiers
+                  << " pid=" << pid << std::endl;
+    } else {
+        _failureCount.fetch_add(1);
+        std::cerr << "[SEND] Keystroke FAILED vk=" << key
+                  << " mods=" << modifiers
+                  << " pid=" << pid << std::endl;
+    }
+    return success;
+}
+
 bool ActionSender::sendText(const std::string& text) {
     if (!_isReady.load()) {
         std::cerr << "ActionSender not ready" << std::endl;
@@ -259,28 +247,28 @@ bool ActionSender::sendText(const std::string& text) {
             std::cerr << "Failed to bring target window to foreground pid=" << tgt.pid << std::endl;
             continue;
         }
-        bool success = true;
-        for (char c : text) {
-            int vk = charToVk(c);
-            if (vk != 0) {
-                success &= sendKeyScan(vk, false);
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                success &= sendKeyScan(vk, true);
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            }
-        }
-        if (success) {
-            _successCount.fetch_add(1);
+        if (emitText(text, tgt.pid)) {
             anySuccess = true;
-            std::cout << "[SEND] Text success len=" << text.size() << " pid=" << tgt.pid << std::endl;
-        } else {
-            _failureCount.fetch_add(1);
-            std::cerr << "[SEND] Text FAILED len=" << text.size() << " pid=" << tgt.pid << std::endl;
         }
     }
     return anySuccess;
 }
 
+bool ActionSender::emitText(const std::string& text, DWORD pid) {
+    // Characters without a key are skipped, as before
+    _inputBatch.clear();
+    _inputBatch.addText(text);
+    bool success = submitInput(_inputBatch);
+    if (success) {
+        _successCount.fetch_add(1);
+        std::cout << "[SEND] Text success len=" << text.size() << " pid=" << pid << std::endl;
+    } else {
+        _failureCount.fetch_add(1);
+        std::cerr << "[SEND] Text FAILED len=" << text.size() << " pid=" << pid << std::endl;
+    }
+    return success;
+}
+
 bool ActionSender::sendKeystrokeSequence(const std::vector<int>& keys, int modifiers) {
     if (!_isReady.load()) {
         std::cerr << "ActionSender not ready" << std::endl;
@@ -321,36 +309,75 @@ bool ActionSender::sendChord(const std::vector<int>& keys, int modifiers, bool p
             std::cerr << "Failed to bring target window to foreground pid=" << tgt.pid << std::endl;
             continue;
         }
-        bool success = true;
-        // Hold modifiers
-        if (modifiers & MOD_CONTROL) success &= sendKeyScan(VK_CONTROL, false);
-        if (modifiers & MOD_ALT)     success &= sendKeyScan(VK_MENU, false);
-        if (modifiers & MOD_SHIFT)   success &= sendKeyScan(VK_SHIFT, false);
-
-        // Press keys
-        for (int vk : keys) {
-            success &= sendKeyScan(vk, false);
-            if (!pressTogether) std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        }
-        // Release keys in reverse
-        for (auto it = keys.rbegin(); it != keys.rend(); ++it) {
-            success &= sendKeyScan(*it, true);
-            if (!pressTogether) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (emitChord(keys, modifiers, pressTogether)) {
+            anySuccess = true;
         }
+    }
+    return anySuccess;
+}
 
-        // Release modifiers
-        if (modifiers & MOD_SHIFT)   success &= sendKeyScan(VK_SHIFT, true);
-        if (modifiers & MOD_ALT)     success &= sendKeyScan(VK_MENU, true);
-        if (modifiers & MOD_CONTROL) success &= sendKeyScan(VK_CONTROL, true);
+bool ActionSender::emitChord(const std::vector<int>& keys, int modifiers, bool pressTogether) {
+    _inputBatch.clear();
+    _inputBatch.addChord(keys, modifiers, pressTogether);
+    bool success = submitInput(_inputBatch);
 
-        if (success) {
-            _successCount.fetch_add(1);
-            anySuccess = true;
-        } else {
-            _failureCount.fetch_add(1);
+    if (success) {
+        _successCount.fetch_add(1);
+    } else {
+        _failureCount.fetch_add(1);
+    }
+    return success;
+}
+
+bool ActionSender::sendBatch(const ActionBatchStep* steps, size_t count, bool* results) {
+    for (size_t i = 0; i < count; ++i) {
+        results[i] = false;
+    }
+    if (!_isReady.load()) {
+        std::cerr << "ActionSender not ready" << std::endl;
+        _failureCount.fetch_add(count);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_targets.empty()) {
+        _targets.push_back(Target{_processId, _windowHandle});
+    }
+    // One focus per target for the whole run; each target still sees the steps in order
+    for (const auto& tgt : _targets) {
+        std::cout << "[SEND] Preparing " << count << " step(s) pid=" << tgt.pid
+                  << " hwnd=" << (void*)tgt.hwnd << std::endl;
+        if (!bringToForeground(tgt.hwnd, tgt.pid)) {
+            std::cerr << "Failed to bring target window to foreground pid=" << tgt.pid << std::endl;
+            continue;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            const ActionBatchStep& step = steps[i];
+            bool ok = false;
+            switch (step.op) {
+                case ActionBatchStep::Op::Keystroke:
+                    ok = emitKeystroke(step.keys->front(), step.modifiers, tgt.pid);
+                    break;
+                case ActionBatchStep::Op::Chord:
+                    ok = emitChord(*step.keys, step.modifiers, false);
+                    break;
+                case ActionBatchStep::Op::Text:
+                    ok = emitText(*step.text, tgt.pid);
+                    break;
+                case ActionBatchStep::Op::Command:
+                    std::cout << "[SEND] Command '" << *step.text << "' pid=" << tgt.pid << std::endl;
+                    ok = emitText(*step.text, tgt.pid);
+                    ok = emitKeystroke(VK_RETURN, 0, tgt.pid) && ok;
+                    break;
+            }
+            results[i] = results[i] || ok;
         }
     }
-    return anySuccess;
+    bool allOk = true;
+    for (size_t i = 0; i < count; ++i) {
+        allOk = allOk && results[i];
+    }
+    return allOk;
 }
 
 bool ActionSender::sendCommand(const std::string& command) {
@@ -426,38 +453,6 @@ bool ActionSender::sendKeyUp(int key, int modifiers) {
     return SendInput(1, &input, sizeof(INPUT)) == 1;
 }
 
-int ActionSender::charToVk(char c) const {
-    if (c >= 'A' && c <= 'Z') {
-        return c;
-    }
-    if (c >= 'a' && c <= 'z') {
-        return c - 32; // Convert to uppercase
-    }
-    if (c >= '0' && c <= '9') {
-        return c;
-    }
-    
-    // Special characters
-    switch (c) {
-        case ' ': return VK_SPACE;
-        case '\t': return VK_TAB;
-        case '\r':
-        case '\n': return VK_RETURN;
-        case '.': return VK_DECIMAL;
-        case ',': return VK_OEM_COMMA;
-        case ';': return VK_OEM_1;
-        case '/': return VK_OEM_2;
-        case '`': return VK_OEM_3;
-        case '[': return VK_OEM_4;
-        case '\\': return VK_OEM_5;
-        case ']': return VK_OEM_6;
-        case '\'': return VK_OEM_7;
-        case '-': return VK_OEM_MINUS;
-        case '=': return VK_OEM_PLUS;
-        default: return 0;
-    }
-}
-
 int ActionSender::getModifierFlags(int key) const {
     int flags = 0;
     
@@ -511,6 +506,10 @@ bool ActionSender::bringToForeground() {
 
 bool ActionSender::bringToForeground(HWND hwnd, DWORD pid) {
     if (!hwnd) return false;
+    if (GetForegroundWindow() == hwnd) {
+        return true; // Already focused; skip the attach/raise dance and its settle delay
+    }
+    _focusSwitchCount.fetch_add(1);
     std::cout << "[FOCUS] Bringing window to foreground pid=" << pid
               << " hwnd=" << (void*)hwnd << std::endl;
     if (IsIconic(hwnd)) {
@@ -549,6 +548,47 @@ bool ActionSender::sendKeyScan(int vk, bool keyUp) const {
     return SendInput(1, &input, sizeof(INPUT)) == 1;
 }
 
+void ActionSender::setKeyPacing(std::chrono::milliseconds pacing) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _inputBatch.setKeyPacing(pacing);
+    std::cout << "[SEND] Key pacing " << _inputBatch.getKeyPacing().count() << "ms" << std::endl;
+}
+
+bool ActionSender::flushInput() {
+    if (_inputBuffer.empty()) {
+        return true;
+    }
+    UINT count = static_cast<UINT>(_inputBuffer.size());
+    UINT sent = SendInput(count, _inputBuffer.data(), sizeof(INPUT));
+    _inputBuffer.clear();
+    return sent == count;
+}
+
+bool ActionSender::submitInput(const InputBatch& batch) {
+    // One SendInput per unpaced run: the run reaches the input queue in one piece
+    bool success = true;
+    _inputBuffer.clear();
+    for (const InputEvent& event : batch.getEvents()) {
+        // Scancodes, not virtual keys: games often read raw scancodes
+        UINT scan = MapVirtualKeyA(event.vk, MAPVK_VK_TO_VSC);
+        if (scan != 0) {
+            INPUT input = {};
+            input.type = INPUT_KEYBOARD;
+            input.ki.wScan = (WORD)scan;
+            input.ki.dwFlags = KEYEVENTF_SCANCODE | (event.keyUp ? KEYEVENTF_KEYUP : 0);
+            _inputBuffer.push_back(input);
+        } else {
+            success = false;
+        }
+        if (event.pauseAfterMs > 0) {
+            success &= flushInput();
+            std::this_thread::sleep_for(std::chrono::milliseconds(event.pauseAfterMs));
+        }
+    }
+    success &= flushInput();
+    return success;
+}
+
 void ActionSender::sendModifiers(int modifiers, bool keyUp) {
     if (modifiers & MOD_CONTROL) {
         sendKeyScan(VK_CONTROL, keyUp);
@@ -564,202 +604,78 @@ void ActionSender::sendModifiers(int modifiers, bool keyUp) {
 bool ActionSender::sendSms(const std::string& logLine) {
     std::cout << "[SMS] Tell message detected: " << logLine << std::endl;
     
+    // Queue for the outbox sender; the email goes out with the other tells of its batch window
+    if (_outbox->enqueue("sms", logLine)) {
+        _successCount++;
+        return true;
+    }
+    _failureCount++;
+    return false;
+}
+
+bool ActionSender::runEmailService(const std::string& message) {
     try {
+        // The message is one command-line argument: keep it on one line and inside its quotes
+        std::string argument;
+        argument.reserve(message.size());
+        for (char c : message) {
+            if (c == '\n') argument += " | ";
+            else if (c == '"') argument += '\'';
+            else if (c != '\r') argument += c;
+        }
         // Call the C# EmailService to send the email
         std::string configPath = "config.yaml";
-        std::string command = "cmd /c \"cd /d C:\\Users\\Jake\\source\\repos\\EQLogAutomator\\x64\\Release && EmailService.exe " + configPath + " \"" + logLine + "\"\"";
+        std::string command = "cmd /c \"cd /d " + std::string(kEmailServiceDirectory) + " && EmailService.exe " + configPath + " \"" + argument + "\"\"";
         
         int result = system(command.c_str());
         
         if (result == 0) {
             std::cout << "[SMS] Email sent successfully" << std::endl;
-            _successCount++;
             return true;
         } else {
             std::cerr << "[SMS] Failed to send email. EmailService returned: " << result << std::endl;
-            _failureCount++;
             return false;
         }
     } catch (const std::exception& e) {
         std::cerr << "[SMS] Exception while sending email: " << e.what() << std::endl;
-        _failureCount++;
         return false;
     }
 }
 
-bool ActionSender::checkEmailResponses() {
-    try {
-        // Check for response file created by EmailMonitor
-        std::cout << "[EMAIL RESPONSE] Checking for response file..." << std::endl;
-        
-        char currentDir[MAX_PATH];
-        if (GetCurrentDirectoryA(MAX_PATH, currentDir) > 0) {
-            std::cout << "[EMAIL RESPONSE] Current working directory: " << currentDir << std::endl;
-        }
-        
-        // Look for response.txt in the current directory where EmailMonitor writes it
-        std::string responseFilePath = "response.txt";
-        std::cout << "[EMAIL RESPONSE] Looking for response file: " << responseFilePath << std::endl;
-        
-        std::ifstream responseFile(responseFilePath);
-        if (!responseFile.is_open()) {
-            std::cout << "[EMAIL RESPONSE] No response file found" << std::endl;
-            return false; // No response file found
-        }
-        std::cout << "[EMAIL RESPONSE] Response file found and opened" << std::endl;
-        
-        // Read all response lines (each response is on its own line)
-        std::vector<std::string> responseLines;
-        std::string line;
-        while (std::getline(responseFile, line)) {
-            if (!line.empty()) {
-                responseLines.push_back(line);
-            }
-        }
-        responseFile.close();
-        
-        if (responseLines.empty()) {
-            std::cout << "[EMAIL RESPONSE] No response lines found in file" << std::endl;
-            return false;
-        }
-        
-        std::cout << "[EMAIL RESPONSE] Found " << responseLines.size() << " response lines to process" << std::endl;
-        
-        // Process each response line
-        std::vector<std::string> unprocessedLines;
-        bool anyProcessed = false;
-        
-        for (const auto& fullResponse : responseLines) {
-            // Parse timestamp and response from format: "2025-09-13 12:52:05|response message"
-            size_t pipePos = fullResponse.find('|');
-            if (pipePos == std::string::npos) {
-                // No timestamp found, treat as old format and process anyway
-                std::cout << "[EMAIL RESPONSE] Processing response (no timestamp): " << fullResponse << std::endl;
-                
-                // Send the response as a command
-                bool success = sendCommand(fullResponse);
-                if (success) {
-                    std::cout << "[EMAIL RESPONSE] Command sent successfully: " << fullResponse << std::endl;
-                    _successCount++;
-                    anyProcessed = true;
-                    
-                    // Send acknowledgment email
-                    sendAcknowledgmentEmail(fullResponse);
-                } else {
-                    std::cerr << "[EMAIL RESPONSE] Failed to send command: " << fullResponse << std::endl;
-                    _failureCount++;
-                    // Keep failed responses for retry
-                    unprocessedLines.push_back(fullResponse);
-                }
-            } else {
-                std::string timestampStr = fullResponse.substr(0, pipePos);
-                std::string response = fullResponse.substr(pipePos + 1);
-                
-                // Parse timestamp to check if it's after our startup time
-                struct tm responseTime = {0};
-                if (sscanf_s(timestampStr.c_str(), "%d-%d-%d %d:%d:%d", 
-                            &responseTime.tm_year, &responseTime.tm_mon, &responseTime.tm_mday,
-                            &responseTime.tm_hour, &responseTime.tm_min, &responseTime.tm_sec) == 6) {
-                    
-                    responseTime.tm_year -= 1900; // Convert to tm format
-                    responseTime.tm_mon -= 1;
-                    time_t responseTimeT = mktime(&responseTime);
-                    
-                    // Convert startup time to time_t
-                    auto startupTimeT = std::chrono::system_clock::to_time_t(
-                        std::chrono::time_point_cast<std::chrono::system_clock::duration>(
-                            _startupTime - std::chrono::steady_clock::now() + std::chrono::system_clock::now()));
-                    
-                    if (responseTimeT < startupTimeT) {
-                        // Response is older than our startup time, ignore it
-                        std::cout << "[EMAIL RESPONSE] Ignoring old response from " << timestampStr << std::endl;
-                        continue;
-                    }
-                    
-                    std::cout << "[EMAIL RESPONSE] Processing response from " << timestampStr << ": " << response << std::endl;
-                    
-                    // Send the response as a command
-                    bool success = sendCommand(response);
-                    if (success) {
-                        std::cout << "[EMAIL RESPONSE] Command sent successfully: " << response << std::endl;
-                        _successCount++;
-                        anyProcessed = true;
-                        
-                        // Send acknowledgment email
-                        sendAcknowledgmentEmail(response);
-                    } else {
-                        std::cerr << "[EMAIL RESPONSE] Failed to send command: " << response << std::endl;
-                        _failureCount++;
-                        // Keep failed responses for retry
-                        unprocessedLines.push_back(fullResponse);
-                    }
-                } else {
-                    // Failed to parse timestamp, process anyway
-                    std::cout << "[EMAIL RESPONSE] Processing response (invalid timestamp): " << fullResponse << std::endl;
-                    
-                    // Send the response as a command
-                    bool success = sendCommand(fullResponse);
-                    if (success) {
-                        std::cout << "[EMAIL RESPONSE] Command sent successfully: " << fullResponse << std::endl;
-                        _successCount++;
-                        anyProcessed = true;
-                        
-                        // Send acknowledgment email
-                        sendAcknowledgmentEmail(fullResponse);
-                    } else {
-                        std::cerr << "[EMAIL RESPONSE] Failed to send command: " << fullResponse << std::endl;
-                        _failureCount++;
-                        // Keep failed responses for retry
-                        unprocessedLines.push_back(fullResponse);
-                    }
-                }
-            }
-        }
-        
-        // Rewrite the file with only unprocessed responses
-        if (!unprocessedLines.empty()) {
-            std::ofstream outFile(responseFilePath);
-            for (const auto& line : unprocessedLines) {
-                outFile << line << std::endl;
-            }
-            outFile.close();
-            std::cout << "[EMAIL RESPONSE] Wrote " << unprocessedLines.size() << " unprocessed responses back to file" << std::endl;
-        } else {
-            // All responses processed successfully, delete the file
-            std::remove(responseFilePath.c_str());
-            std::cout << "[EMAIL RESPONSE] All responses processed, deleted response file" << std::endl;
-        }
-        
-        return anyProcessed;
-    } catch (const std::exception& e) {
-        std::cerr << "[EMAIL RESPONSE] Exception while processing response: " << e.what() << std::endl;
-        _failureCount++;
+bool ActionSender::deliverEmail(const std::string& kind, const std::string& body) {
+    if (!_useEmailHelper.load()) {
+        return runEmailService(body);
+    }
+    // One request per email to the resident EmailService; it is started once and restarted on failure
+    std::string reply;
+    if (!_emailHelper->request(kind + '\n' + body, reply, std::chrono::seconds(60))) {
+        std::cerr << "[SMS] EmailService helper unavailable" << std::endl;
+        return false;
+    }
+    if (reply.rfind("OK", 0) != 0) {
+        std::cerr << "[SMS] EmailService helper: " << reply << std::endl;
         return false;
     }
+    std::cout << "[SMS] Email sent successfully" << std::endl;
+    return true;
+}
+
+void ActionSender::setEmailHelperEnabled(bool enabled) {
+    if (_useEmailHelper.exchange(enabled) != enabled) {
+        std::cout << "[SMS] Emails sent " << (enabled ? "through the resident EmailService helper" : "by starting EmailService per email") << std::endl;
+    }
+}
+
+void ActionSender::configureOutbox(const std::string& journalPath, const OutboxSettings& settings) {
+    _outbox->configure(settings);
+    _outbox->open(journalPath);
 }
 
 bool ActionSender::sendAcknowledgmentEmail(const std::string& response) {
-    std::cout << "[ACK] Sending acknowledgment for response: " << response << std::endl;
+    std::cout << "[ACK] Queueing acknowledgment for response: " << response << std::endl;
     
-    try {
-        // Call the C# EmailService to send the acknowledgment email
-        std::string configPath = "config.yaml";
-        std::string acknowledgmentMessage = "ACK: Your response '" + response + "' has been received and processed at " + 
-                                          std::to_string(std::time(nullptr)) + ". This is an automated acknowledgment from the EQ Log Automator.";
-        std::string command = "cmd /c \"cd /d C:\\Users\\Jake\\source\\repos\\EQLogAutomator\\x64\\Release && EmailService.exe " + configPath + " \"" + acknowledgmentMessage + "\"\"";
-        
-        int result = system(command.c_str());
-        
-        if (result == 0) {
-            std::cout << "[ACK] Acknowledgment email sent successfully" << std::endl;
-            return true;
-        } else {
-            std::cerr << "[ACK] Failed to send acknowledgment email. EmailService returned: " << result << std::endl;
-            return false;
-        }
-    } catch (const std::exception& e) {
-        std::cerr << "[ACK] Exception while sending acknowledgment email: " << e.what() << std::endl;
-        return false;
-    }
+    std::string acknowledgmentMessage = "ACK: Your response '" + response + "' has been received and processed at " + 
+                                      std::to_string(std::time(nullptr)) + ". This is an automated acknowledgment from the EQ Log Automator.";
+    return _outbox->enqueue("ack", acknowledgmentMessage);
 }
 
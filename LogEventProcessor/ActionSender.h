@@ -8,12 +8,16 @@
 #include <atomic>
 #include <map>
 #include <chrono>
+#include "ActionSink.h"
+#include "InputBatch.h"
+#include "EmailOutbox.h"
+#include "HelperProcess.h"
 
 /**
  * @class ActionSender
- * @brief Sends keystrokes to the eqgame.exe process
+ * @brief Win32 action sink: sends keystrokes to the eqgame.exe process
  */
-class ActionSender {
+class ActionSender : public ActionSink {
 public:
     ActionSender();
     ~ActionSender();
@@ -22,7 +26,7 @@ public:
      * @brief Initialize the action sender and find the eqgame.exe process
      * @return true if initialization successful, false otherwise
      */
-    bool initialize();
+    bool initialize() override;
     
     /**
      * @brief Configure process targeting settings
@@ -36,7 +40,7 @@ public:
      * @brief Check if the action sender is ready to send keystrokes
      * @return true if ready, false otherwise
      */
-    bool isReady() const { return _isReady.load(); }
+    bool isReady() const override { return _isReady.load(); }
     
     /**
      * @brief Send a single keystroke to the process
@@ -44,14 +48,14 @@ public:
      * @param modifiers Modifier keys (Ctrl, Alt, Shift) - can be combined with |
      * @return true if keystroke was sent successfully, false otherwise
      */
-    bool sendKeystroke(int key, int modifiers = 0);
+    bool sendKeystroke(int key, int modifiers = 0) override;
     
     /**
      * @brief Send a string of characters to the process
      * @param text The text to send
      * @return true if text was sent successfully, false otherwise
      */
-    bool sendText(const std::string& text);
+    bool sendText(const std::string& text) override;
     
     /**
      * @brief Send a sequence of keystrokes
@@ -66,14 +70,14 @@ public:
      * @param command The command to send (e.g., "sit", "stand", "follow")
      * @return true if command was sent successfully, false otherwise
      */
-    bool sendCommand(const std::string& command);
+    bool sendCommand(const std::string& command) override;
 
     /**
-     * @brief Send SMS (tell message) via email
+     * @brief Queue an SMS (tell message) for the email outbox
      * @param logLine The log line containing the tell message
-     * @return true if SMS was sent successfully, false otherwise
+     * @return true if the SMS was queued, false otherwise
      */
-    bool sendSms(const std::string& logLine);
+    bool sendSms(const std::string& logLine) override;
 
     /**
      * @brief Send a chord: hold modifiers, press each key in order, then release modifiers
@@ -82,7 +86,22 @@ public:
      * @param pressTogether If true and feasible, attempt minimal delay to simulate simultaneity
      * @return true if the chord was sent successfully
      */
-    bool sendChord(const std::vector<int>& keys, int modifiers = 0, bool pressTogether = false);
+    bool sendChord(const std::vector<int>& keys, int modifiers = 0, bool pressTogether = false) override;
+
+    /**
+     * @brief Send a run of steps, focusing each target window once for the whole run
+     */
+    bool sendBatch(const ActionBatchStep* steps, size_t count, bool* results) override;
+
+    /**
+     * @brief Get the number of times a target window had to be brought to the foreground
+     */
+    size_t getFocusSwitchCount() const override { return _focusSwitchCount.load(); }
+
+    /**
+     * @brief Set the pause used where a client needs keys paced (0 sends each step in one SendInput)
+     */
+    void setKeyPacing(std::chrono::milliseconds pacing);
     
     /**
      * @brief Refresh the process handle (useful if process restarts)
@@ -115,16 +134,28 @@ public:
     size_t getFailureCount() const { return _failureCount.load(); }
     
     /**
-     * @brief Check for email responses and send them as commands
+     * @brief Queue an acknowledgment email for a processed response
+     * @param response The response that was processed
+     * @return true if the acknowledgment was queued, false otherwise
      */
-    bool checkEmailResponses();
+    bool sendAcknowledgmentEmail(const std::string& response) override;
 
     /**
-     * @brief Send acknowledgment email for processed response
-     * @param response The response that was processed
-     * @return true if acknowledgment was sent successfully, false otherwise
+     * @brief Open the email outbox journal and set its batching and retry policy
+     * @param journalPath Outbox journal (undelivered messages survive restarts there)
+     * @param settings Batching and retry policy
+     */
+    void configureOutbox(const std::string& journalPath, const OutboxSettings& settings);
+
+    /**
+     * @brief Send emails through one resident EmailService (--serve) instead of starting it per email
+     */
+    void setEmailHelperEnabled(bool enabled);
+
+    /**
+     * @brief Get email outbox delivery counters
      */
-    bool sendAcknowledgmentEmail(const std::string& response);
+    OutboxStats getOutboxStats() const { return _outbox->getStats(); }
 
 private:
     struct Target {
@@ -135,7 +166,7 @@ private:
     std::atomic<bool> _isReady;
     std::atomic<size_t> _successCount;
     std::atomic<size_t> _failureCount;
-    std::chrono::steady_clock::time_point _startupTime;
+    std::atomic<size_t> _focusSwitchCount{0};
     
     DWORD _processId;
     HWND _windowHandle;
@@ -148,6 +179,10 @@ private:
     std::vector<std::string> _targetProcessNames;
     
     mutable std::mutex _mutex;
+
+    // Input builder and SendInput buffer, reused under _mutex
+    InputBatch _inputBatch;
+    std::vector<INPUT> _inputBuffer;
     
     /**
      * @brief Find the eqgame.exe process
@@ -178,13 +213,6 @@ private:
      */
     bool sendKeyUp(int key, int modifiers = 0);
     
-    /**
-     * @brief Convert character to virtual key code
-     * @param c Character to convert
-     * @return Virtual key code
-     */
-    int charToVk(char c) const;
-    
     /**
      * @brief Get modifier flags for a key
      * @param key Virtual key code
@@ -204,12 +232,40 @@ private:
     bool sendKeyScan(int vk, bool keyUp = false) const;
     
 
+    /**
+     * @brief Send input to the focused window without touching focus
+     * @param pid Target process, for logging
+     */
+    bool emitKeystroke(int key, int modifiers, DWORD pid);
+    bool emitText(const std::string& text, DWORD pid);
+    bool emitChord(const std::vector<int>& keys, int modifiers, bool pressTogether);
+
+    /**
+     * @brief Submit a batch as scancode input, one SendInput per unpaced run
+     * @return true if every event had a scancode and was accepted
+     */
+    bool submitInput(const InputBatch& batch);
+    bool flushInput();
+
+    /**
+     * @brief Outbox transport: send one email through the helper, or by running EmailService
+     */
+    bool deliverEmail(const std::string& kind, const std::string& body);
+
+    /**
+     * @brief Run EmailService.exe for one message
+     * @return true if EmailService reported success
+     */
+    bool runEmailService(const std::string& message);
+
     /**
      * @brief Press or release modifier virtual keys based on flags
      */
     void sendModifiers(int modifiers, bool keyUp);
     
 private:
-    // Private members will be added here
-    
+    std::atomic<bool> _useEmailHelper{true};
+    std::unique_ptr<HelperProcess> _emailHelper;
+    // Declared last so its sender thread stops before the rest of the sender is torn down
+    std::unique_ptr<EmailOutbox> _outbox;
 };
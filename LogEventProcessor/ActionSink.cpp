@@ -0,0 +1,135 @@
+#include "ActionSink.h"
+
+bool ActionSink::sendStep(const ActionBatchStep& step) {
+    switch (step.op) {
+        case ActionBatchStep::Op::Keystroke: return sendKeystroke(step.keys->front(), step.modifiers);
+        case ActionBatchStep::Op::Chord: return sendChord(*step.keys, step.modifiers, false);
+        case ActionBatchStep::Op::Text: return sendText(*step.text);
+        case ActionBatchStep::Op::Command: return sendCommand(*step.text);
+    }
+    return false;
+}
+
+bool ActionSink::sendBatch(const ActionBatchStep* steps, size_t count, bool* results) {
+    bool allOk = true;
+    for (size_t i = 0; i < count; ++i) {
+        results[i] = sendStep(steps[i]);
+        allOk = allOk && results[i];
+    }
+    return allOk;
+}
+
+void RecordingActionSink::focus(size_t target) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_focusedTarget == target) {
+        return;
+    }
+    _focusedTarget = target;
+    _focusSwitches.fetch_add(1);
+    if (_record) {
+        Call call;
+        call.type = CallType::Focus;
+        call.at = std::chrono::steady_clock::now();
+        call.target = target;
+        _calls.push_back(std::move(call));
+    }
+}
+
+void RecordingActionSink::deliver(const Call& call) {
+    _callCount.fetch_add(1);
+    if (_record) {
+        Call copy = call;
+        copy.at = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(_mutex);
+        _calls.push_back(std::move(copy));
+    }
+}
+
+bool RecordingActionSink::add(Call call) {
+    // A single-step call visits every target, like ActionSender
+    for (size_t target = 0; target < _targets; ++target) {
+        focus(target);
+        call.target = target;
+        deliver(call);
+    }
+    return true;
+}
+
+bool RecordingActionSink::sendKeystroke(int key, int modifiers) {
+    Call call;
+    call.type = CallType::Keystroke;
+    call.keys.push_back(key);
+    call.modifiers = modifiers;
+    return add(std::move(call));
+}
+
+bool RecordingActionSink::sendChord(const std::vector<int>& keys, int modifiers, bool) {
+    Call call;
+    call.type = CallType::Chord;
+    call.keys = keys;
+    call.modifiers = modifiers;
+    return add(std::move(call));
+}
+
+bool RecordingActionSink::sendText(const std::string& text) {
+    Call call;
+    call.type = CallType::Text;
+    call.value = text;
+    return add(std::move(call));
+}
+
+bool RecordingActionSink::sendCommand(const std::string& command) {
+    Call call;
+    call.type = CallType::Command;
+    call.value = command;
+    return add(std::move(call));
+}
+
+bool RecordingActionSink::sendSms(const std::string& logLine) {
+    // SMS goes out by email, not to a window
+    Call call;
+    call.type = CallType::Sms;
+    call.value = logLine;
+    deliver(call);
+    return true;
+}
+
+bool RecordingActionSink::sendBatch(const ActionBatchStep* steps, size_t count, bool* results) {
+    for (size_t target = 0; target < _targets; ++target) {
+        focus(target);
+        if (!_record) {
+            _callCount.fetch_add(count);
+            continue;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            const ActionBatchStep& step = steps[i];
+            Call call;
+            call.target = target;
+            call.modifiers = step.modifiers;
+            switch (step.op) {
+                case ActionBatchStep::Op::Keystroke: call.type = CallType::Keystroke; call.keys.push_back(step.keys->front()); break;
+                case ActionBatchStep::Op::Chord: call.type = CallType::Chord; call.keys = *step.keys; break;
+                case ActionBatchStep::Op::Text: call.type = CallType::Text; call.value = *step.text; break;
+                case ActionBatchStep::Op::Command: call.type = CallType::Command; call.value = *step.text; break;
+            }
+            deliver(call);
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        results[i] = true;
+    }
+    return true;
+}
+
+std::vector<RecordingActionSink::Call> RecordingActionSink::getCalls() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _calls;
+}
+
+void RecordingActionSink::clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _calls.clear();
+    _callCount.store(0);
+    _focusSwitches.store(0);
+    _focusedTarget = static_cast<size_t>(-1);
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "KeyCodes.h"
+
+/**
+ * @struct ActionBatchStep
+ * @brief One keyboard step of a run handed to ActionSink::sendBatch
+ */
+struct ActionBatchStep {
+    enum class Op : uint8_t { Keystroke, Chord, Text, Command };
+    Op op = Op::Keystroke;
+    const std::vector<int>* keys = nullptr; // Keystroke (first key) and Chord
+    int modifiers = 0;
+    const std::string* text = nullptr;      // Text and Command
+};
+
+/**
+ * @class ActionSink
+ * @brief Destination for executed action steps.
+ *
+ * ActionManager parses and schedules steps, then hands each one to a sink. ActionSender is
+ * the Win32 sink that drives the game client; RecordingActionSink runs anywhere and only
+ * records calls, for benchmarks and load tests.
+ */
+class ActionSink {
+public:
+    virtual ~ActionSink() = default;
+
+    /**
+     * @brief Prepare the sink (find target processes, open connections, ...)
+     * @return true if the sink can accept actions
+     */
+    virtual bool initialize() = 0;
+
+    /**
+     * @brief Check if the sink is ready to accept actions
+     */
+    virtual bool isReady() const = 0;
+
+    /**
+     * @brief Send a single keystroke
+     * @param key Virtual key code (KeyCodes.h)
+     * @param modifiers MOD_CONTROL, MOD_ALT and MOD_SHIFT combined with |
+     */
+    virtual bool sendKeystroke(int key, int modifiers = 0) = 0;
+
+    /**
+     * @brief Hold modifiers, press each key in order, then release modifiers
+     * @param keys Virtual key codes to press
+     * @param modifiers Modifier flags
+     * @param pressTogether Minimize the delay between presses to simulate simultaneity
+     */
+    virtual bool sendChord(const std::vector<int>& keys, int modifiers = 0, bool pressTogether = false) = 0;
+
+    /**
+     * @brief Type a string of characters
+     */
+    virtual bool sendText(const std::string& text) = 0;
+
+    /**
+     * @brief Send a chat command (e.g. "sit", "/tell ...")
+     */
+    virtual bool sendCommand(const std::string& command) = 0;
+
+    /**
+     * @brief Forward a tell as SMS
+     * @param logLine The log line containing the tell
+     */
+    virtual bool sendSms(const std::string& logLine) = 0;
+
+    /**
+     * @brief Confirm to the player that an emailed response was sent to the game
+     * @param response The response command
+     * @return true if the acknowledgment was queued (sinks without email ignore it)
+     */
+    virtual bool sendAcknowledgmentEmail(const std::string& response) { (void)response; return true; }
+
+    /**
+     * @brief Send a run of keyboard steps that has no delay between them
+     *
+     * Sinks driving several windows override this to focus each window once and replay the
+     * whole run there, instead of refocusing for every step. The default sends each step.
+     * @param steps Steps in order
+     * @param count Number of steps
+     * @param results Output per-step success (count entries)
+     * @return true if every step succeeded
+     */
+    virtual bool sendBatch(const ActionBatchStep* steps, size_t count, bool* results);
+
+    /**
+     * @brief Get the number of focus switches between target windows so far
+     */
+    virtual size_t getFocusSwitchCount() const { return 0; }
+
+protected:
+    /**
+     * @brief Send one batch step through the single-step methods
+     */
+    bool sendStep(const ActionBatchStep& step);
+};
+
+/**
+ * @class RecordingActionSink
+ * @brief Portable sink that timestamps every call instead of performing it
+ *
+ * With recording off it only counts calls (a null sink), so throughput runs do not grow
+ * memory. It can simulate several target windows the way ActionSender drives them: a
+ * single-step call visits every target in turn, while sendBatch visits each target once
+ * for the whole run. Each step is recorded once per target, and every change of target is
+ * a focus switch.
+ */
+class RecordingActionSink : public ActionSink {
+public:
+    enum class CallType { Keystroke, Chord, Text, Command, Sms, Focus };
+
+    struct Call {
+        CallType type;
+        std::chrono::steady_clock::time_point at;
+        std::vector<int> keys; // Keystroke: one key; Chord: every key
+        int modifiers = 0;
+        std::string value;     // Text, command or SMS log line
+        size_t target = 0;     // Simulated target window
+    };
+
+    /**
+     * @param record Keep every call (false counts calls only)
+     * @param targets Number of simulated target windows
+     */
+    explicit RecordingActionSink(bool record = true, size_t targets = 1)
+        : _record(record), _targets(targets > 0 ? targets : 1) {}
+
+    bool initialize() override { return true; }
+    bool isReady() const override { return true; }
+    bool sendKeystroke(int key, int modifiers = 0) override;
+    bool sendChord(const std::vector<int>& keys, int modifiers = 0, bool pressTogether = false) override;
+    bool sendText(const std::string& text) override;
+    bool sendCommand(const std::string& command) override;
+    bool sendSms(const std::string& logLine) override;
+    bool sendBatch(const ActionBatchStep* steps, size_t count, bool* results) override;
+    size_t getFocusSwitchCount() const override { return _focusSwitches.load(); }
+
+    /**
+     * @brief Get the number of steps delivered (one per step per target)
+     */
+    size_t getCallCount() const { return _callCount.load(); }
+
+    /**
+     * @brief Get a copy of the recorded calls, oldest first
+     */
+    std::vector<Call> getCalls() const;
+
+    /**
+     * @brief Forget recorded calls and reset the call count
+     */
+    void clear();
+
+private:
+    bool _record;
+    size_t _targets;
+    size_t _focusedTarget = static_cast<size_t>(-1);
+    std::atomic<size_t> _callCount{0};
+    std::atomic<size_t> _focusSwitches{0};
+    mutable std::mutex _mutex;
+    std::vector<Call> _calls;
+
+    bool add(Call call);
+    void focus(size_t target);
+    void deliver(const Call& call);
+};
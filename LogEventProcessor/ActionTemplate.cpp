@@ -0,0 +1,117 @@
+#include "ActionTemplate.h"
+#include <algorithm>
+#include <cctype>
+
+ActionTemplate ActionTemplate::parse(const std::string& value) {
+    ActionTemplate result;
+    std::string literal;
+    auto flushLiteral = [&]() {
+        if (!literal.empty()) {
+            result._segments.push_back(Segment{SegmentKind::Literal, literal, -1});
+            literal.clear();
+        }
+    };
+
+    size_t i = 0;
+    while (i < value.size()) {
+        char c = value[i];
+        if (c != '#') {
+            literal.push_back(c);
+            ++i;
+            continue;
+        }
+        // Everything beyond the legacy bare '#' is braced, so existing values such as "#1" or
+        // "##" keep meaning the capture followed by "1", or the capture twice
+        if (i + 1 < value.size() && value[i + 1] == '{') {
+            size_t close = value.find('}', i + 2);
+            if (close != std::string::npos && close > i + 2) {
+                std::string name = value.substr(i + 2, close - (i + 2));
+                bool numeric = std::all_of(name.begin(), name.end(),
+                                           [](char d) { return std::isdigit(static_cast<unsigned char>(d)) != 0; });
+                if (name == "#") {
+                    literal.push_back('#');
+                } else {
+                    flushLiteral();
+                    if (name == "line") {
+                        result._segments.push_back(Segment{SegmentKind::LogLine, std::string(), -1});
+                    } else if (numeric && name.size() <= kMaxGroupDigits) {
+                        result._segments.push_back(Segment{SegmentKind::Capture, std::string(), std::stoi(name)});
+                    } else {
+                        // Includes numbers past kMaxGroupDigits, which resolveNames then reports
+                        result._segments.push_back(Segment{SegmentKind::NamedCapture, name, -1});
+                    }
+                }
+                i = close + 1;
+                continue;
+            }
+        }
+        flushLiteral();
+        result._segments.push_back(Segment{SegmentKind::LegacyCapture, std::string(), 1});
+        ++i;
+    }
+    flushLiteral();
+
+    result._hasPlaceholders = std::any_of(result._segments.begin(), result._segments.end(),
+                                          [](const Segment& s) { return s.kind != SegmentKind::Literal; });
+    return result;
+}
+
+int ActionTemplate::highestGroup() const {
+    int highest = 0;
+    for (const auto& segment : _segments) {
+        if (segment.kind == SegmentKind::LegacyCapture || segment.kind == SegmentKind::Capture ||
+            segment.kind == SegmentKind::NamedCapture) {
+            highest = std::max(highest, segment.group);
+        }
+    }
+    return highest;
+}
+
+std::vector<std::string> ActionTemplate::resolveNames(const std::function<int(const std::string&)>& lookup) {
+    std::vector<std::string> unresolved;
+    for (auto& segment : _segments) {
+        if (segment.kind == SegmentKind::NamedCapture) {
+            segment.group = lookup ? lookup(segment.text) : -1;
+            if (segment.group < 0) {
+                unresolved.push_back(segment.text);
+            }
+        }
+    }
+    return unresolved;
+}
+
+std::string_view ActionTemplate::segmentView(const Segment& segment, std::string_view line,
+                                             const MatchCaptures& captures) const {
+    switch (segment.kind) {
+        case SegmentKind::Literal:
+            return segment.text;
+        case SegmentKind::LogLine:
+            return line;
+        case SegmentKind::LegacyCapture: {
+            // An empty capture leaves the '#' in place, as the original substitution did
+            std::string_view text;
+            if (captures.size() > 1) text = captures[1].view(line);
+            else if (!captures.empty()) text = captures[0].view(line);
+            return text.empty() ? std::string_view("#") : text;
+        }
+        case SegmentKind::Capture:
+        case SegmentKind::NamedCapture:
+            if (segment.group >= 0 && static_cast<size_t>(segment.group) < captures.size()) {
+                return captures[segment.group].view(line);
+            }
+            return std::string_view();
+    }
+    return std::string_view();
+}
+
+void ActionTemplate::render(std::string_view line, const MatchCaptures& captures, std::string& out) const {
+    size_t total = 0;
+    for (const auto& segment : _segments) {
+        total += segmentView(segment, line, captures).size();
+    }
+    out.clear();
+    out.reserve(total);
+    for (const auto& segment : _segments) {
+        out.append(segmentView(segment, line, captures));
+    }
+}
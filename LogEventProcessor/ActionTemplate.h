@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include "MatchEngine.h"
+
+/**
+ * @class ActionTemplate
+ * @brief An action value parsed at load time into literal and placeholder segments.
+ *
+ * Placeholder syntax:
+ *   #         capture 1, or the whole match when the pattern has no groups; left as '#' when
+ *             that is empty (legacy form: "#1" is the capture then "1", "##" the capture twice)
+ *   #{N}      capture group N, up to two digits (#{0} is the whole match)
+ *   #{name}   named capture group (engines with named groups: pcre2, re2)
+ *   #{line}   the full log line
+ *   #{#}      a literal '#'
+ */
+class ActionTemplate {
+public:
+    ActionTemplate() = default;
+
+    /**
+     * @brief Parse an action value
+     * @param value Raw action value from the configuration
+     * @return Parsed template
+     */
+    static ActionTemplate parse(const std::string& value);
+
+    /**
+     * @brief Check whether rendering depends on the match
+     * @return true if any segment is a placeholder
+     */
+    bool hasPlaceholders() const { return _hasPlaceholders; }
+
+    /**
+     * @brief Highest capture group the template reads (0 if it reads none)
+     */
+    int highestGroup() const;
+
+    /**
+     * @brief Resolve #{name} segments to group numbers
+     * @param lookup Returns the group number for a name, or -1 if unknown
+     * @return Names that could not be resolved (rendered as empty)
+     */
+    std::vector<std::string> resolveNames(const std::function<int(const std::string&)>& lookup);
+
+    /**
+     * @brief Render into out, sized once from the segment lengths
+     * @param line Original log line the captures index into
+     * @param captures Capture spans of the match
+     * @param out Output buffer (cleared first)
+     */
+    void render(std::string_view line, const MatchCaptures& captures, std::string& out) const;
+
+private:
+    enum class SegmentKind { Literal, LegacyCapture, Capture, NamedCapture, LogLine };
+
+    static constexpr size_t kMaxGroupDigits = 2; // #{N} reads groups 0-99
+
+    struct Segment {
+        SegmentKind kind;
+        std::string text; // Literal text or capture name
+        int group;        // Capture group for Capture / resolved NamedCapture (-1 if unresolved)
+    };
+
+    std::vector<Segment> _segments;
+    bool _hasPlaceholders = false;
+
+    std::string_view segmentView(const Segment& segment, std::string_view line, const MatchCaptures& captures) const;
+};
@@ -0,0 +1,286 @@
+#include "Benchmark.h"
+#include "ConfigManager.h"
+#include "RegexMatcher.h"
+#include "ActionManager.h"
+#include "MatchEngine.h"
+#include "ActionSink.h"
+#include "HelperProcess.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+Benchmark::Benchmark(const ConfigManager& config, int iterations)
+    : _config(config), _iterations(iterations > 0 ? iterations : 1) {
+}
+
+bool Benchmark::loadCorpus(const std::string& corpusPath) {
+    std::ifstream file(corpusPath);
+    if (!file.is_open()) {
+        std::cerr << "[BENCH] Could not open corpus: " << corpusPath << std::endl;
+        return false;
+    }
+    _corpus.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty()) {
+            _corpus.push_back(line);
+        }
+    }
+    std::cout << "[BENCH] Loaded " << _corpus.size() << " corpus lines from " << corpusPath << std::endl;
+    return !_corpus.empty();
+}
+
+int Benchmark::compareEngines() {
+    RegexMatcher baseMatcher;
+    ActionManager baseActions;
+    if (!_config.loadRegexRulesAndActions(baseMatcher, baseActions)) {
+        std::cerr << "[BENCH] Failed to load rules" << std::endl;
+        return 1;
+    }
+
+    std::cout << std::endl << "[BENCH] Engine comparison: " << baseMatcher.getRuleCount() << " rules, "
+              << _corpus.size() << " lines x " << _iterations << " iterations" << std::endl;
+    std::cout << std::left << std::setw(8) << "engine"
+              << std::right << std::setw(10) << "compiled" << std::setw(8) << "failed"
+              << std::setw(14) << "compile_ms" << std::setw(14) << "match_ms"
+              << std::setw(14) << "lines/s" << std::setw(12) << "matches" << std::endl;
+
+    size_t referenceMatches = 0;
+    bool haveReference = false;
+    for (const auto& engineName : availableMatchEngines()) {
+        RegexMatcher matcher;
+        matcher.setDefaultEngine(engineName);
+
+        auto compileStart = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < baseMatcher.getRuleCount(); ++i) {
+            // Drop per-rule engine overrides so every engine sees the same rule set
+            RegexRule rule = *baseMatcher.getRule(i);
+            rule.engine.clear();
+            matcher.addRule(rule);
+        }
+        auto compileEnd = std::chrono::steady_clock::now();
+
+        size_t failed = 0;
+        for (size_t i = 0; i < matcher.getRuleCount(); ++i) {
+            if (!matcher.getRuleEngineName(i)) failed++;
+        }
+
+        size_t matches = 0;
+        MatchCaptures captures;
+        auto matchStart = std::chrono::steady_clock::now();
+        for (int iter = 0; iter < _iterations; ++iter) {
+            for (const auto& text : _corpus) {
+                FoldedLine line(text);
+                for (size_t i = 0; i < matcher.getRuleCount(); ++i) {
+                    if (matcher.getRule(i)->enabled && matcher.matchRule(i, line, captures)) {
+                        matches++;
+                    }
+                }
+            }
+        }
+        auto matchEnd = std::chrono::steady_clock::now();
+
+        double compileMs = std::chrono::duration<double, std::milli>(compileEnd - compileStart).count();
+        double matchMs = std::chrono::duration<double, std::milli>(matchEnd - matchStart).count();
+        double linesPerSec = matchMs > 0.0 ? (_corpus.size() * static_cast<double>(_iterations)) / (matchMs / 1000.0) : 0.0;
+
+        std::cout << std::left << std::setw(8) << engineName
+                  << std::right << std::setw(10) << (matcher.getRuleCount() - failed) << std::setw(8) << failed
+                  << std::setw(14) << std::fixed << std::setprecision(2) << compileMs
+                  << std::setw(14) << matchMs
+                  << std::setw(14) << std::setprecision(0) << linesPerSec
+                  << std::setw(12) << matches;
+        if (haveReference && matches != referenceMatches) {
+            std::cout << "  (differs from " << availableMatchEngines().front() << ")";
+        }
+        std::cout << std::endl;
+
+        if (!haveReference) {
+            referenceMatches = matches;
+            haveReference = true;
+        }
+    }
+    return 0;
+}
+
+int Benchmark::compileStartup() {
+    // A mix of the shapes found in real rule packs: anchored tells, loot lines, free text with alternation
+    auto generateRules = [](size_t count) {
+        std::vector<RegexRule> rules;
+        rules.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            std::string n = std::to_string(i);
+            std::string pattern;
+            switch (i % 3) {
+                case 0: pattern = "^(\\w+) tells you, 'keyword" + n + " (\\d+)'$"; break;
+                case 1: pattern = "--you have looted an? (item" + n + "|relic" + n + ")\\.--"; break;
+                default: pattern = "(\\w+) (hits|slashes|bashes) you for (\\d+) points? of damage\\. \\(marker" + n + "\\)"; break;
+            }
+            rules.emplace_back("generated_" + n, pattern);
+        }
+        return rules;
+    };
+
+    std::cout << std::endl << "[BENCH] Rule load time" << std::endl;
+    std::cout << std::left << std::setw(8) << "engine" << std::right << std::setw(8) << "rules"
+              << std::setw(16) << "one_by_one_ms" << std::setw(14) << "batch_ms" << std::setw(10) << "speedup"
+              << std::setw(14) << "cached_ms" << std::endl;
+    std::error_code ec;
+    std::string cachePath = (std::filesystem::temp_directory_path(ec) / "lep_bench_rule_cache.bin").string();
+
+    for (size_t count : {static_cast<size_t>(1000), static_cast<size_t>(10000)}) {
+        std::vector<RegexRule> rules = generateRules(count);
+        for (const auto& engineName : availableMatchEngines()) {
+            double oneByOneMs = 0.0;
+            double batchMs = 0.0;
+            double cachedMs = 0.0;
+            {
+                // Warm the cache so the timed loads below are hits
+                RegexMatcher warm;
+                warm.setDefaultEngine(engineName);
+                warm.addRulesCached(rules, cachePath);
+            }
+            for (int iter = 0; iter < _iterations; ++iter) {
+                RegexMatcher single;
+                single.setDefaultEngine(engineName);
+                auto start = std::chrono::steady_clock::now();
+                for (const auto& rule : rules) {
+                    single.addRule(rule);
+                }
+                auto mid = std::chrono::steady_clock::now();
+                RegexMatcher batch;
+                batch.setDefaultEngine(engineName);
+                batch.addRules(rules);
+                auto end = std::chrono::steady_clock::now();
+                RegexMatcher cached;
+                cached.setDefaultEngine(engineName);
+                cached.addRulesCached(rules, cachePath);
+                auto cachedEnd = std::chrono::steady_clock::now();
+                oneByOneMs += std::chrono::duration<double, std::milli>(mid - start).count();
+                batchMs += std::chrono::duration<double, std::milli>(end - mid).count();
+                cachedMs += std::chrono::duration<double, std::milli>(cachedEnd - end).count();
+            }
+            oneByOneMs /= _iterations;
+            batchMs /= _iterations;
+            cachedMs /= _iterations;
+            std::cout << std::left << std::setw(8) << engineName << std::right << std::setw(8) << count
+                      << std::setw(16) << std::fixed << std::setprecision(1) << oneByOneMs
+                      << std::setw(14) << batchMs
+                      << std::setw(9) << std::setprecision(2) << (batchMs > 0.0 ? oneByOneMs / batchMs : 0.0) << "x"
+                      << std::setw(14) << std::setprecision(1) << cachedMs << std::endl;
+        }
+    }
+    std::filesystem::remove(cachePath, ec);
+    return 0;
+}
+
+int Benchmark::pipeline(size_t targets) {
+    auto sinkOwner = std::make_unique<RecordingActionSink>(false, targets);
+    RecordingActionSink* sink = sinkOwner.get();
+    RegexMatcher matcher;
+    ActionManager actions(std::move(sinkOwner));
+    actions.setRegexMatcher(&matcher);
+    if (!_config.loadRegexRulesAndActions(matcher, actions)) {
+        std::cerr << "[BENCH] Failed to load rules" << std::endl;
+        return 1;
+    }
+
+    std::cout << std::endl << "[BENCH] Pipeline: " << matcher.getRuleCount() << " rules, "
+              << actions.getMappingCount() << " action mappings, " << _corpus.size() << " lines x "
+              << _iterations << " iterations, " << targets << " target window(s)" << std::endl;
+
+    // Per-action console logging would dominate the timing
+    std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+    auto start = std::chrono::steady_clock::now();
+    size_t lineNumber = 0;
+    for (int iter = 0; iter < _iterations; ++iter) {
+        for (const auto& text : _corpus) {
+            actions.processEvent(std::make_shared<LogEvent>(text, ++lineNumber));
+        }
+    }
+    auto submitted = std::chrono::steady_clock::now();
+    // Delayed steps finish on the scheduler; wait for them, bounded in case a config delays for minutes
+    while (actions.getPendingStepCount() > 0 && submitted + std::chrono::seconds(60) > std::chrono::steady_clock::now()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    auto drained = std::chrono::steady_clock::now();
+    std::cout.rdbuf(coutBuffer);
+    std::cout.clear();
+
+    double submitMs = std::chrono::duration<double, std::milli>(submitted - start).count();
+    double totalMs = std::chrono::duration<double, std::milli>(drained - start).count();
+    double linesPerSec = submitMs > 0.0 ? lineNumber / (submitMs / 1000.0) : 0.0;
+    double avgLatencyMs = 0.0, maxLatencyMs = 0.0;
+    actions.getDispatchLatency(avgLatencyMs, maxLatencyMs);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "[BENCH] Lines: " << lineNumber << " in " << submitMs << " ms ("
+              << std::setprecision(0) << linesPerSec << " lines/s)" << std::endl
+              << std::setprecision(2)
+              << "[BENCH] Actions sent: " << sink->getCallCount() << ", failed: " << actions.getFailedActionCount()
+              << ", still scheduled: " << actions.getPendingStepCount() << ", drained after " << totalMs << " ms" << std::endl
+              << "[BENCH] Line-to-first-step latency: avg " << avgLatencyMs << " ms, max " << maxLatencyMs << " ms" << std::endl
+              << "[BENCH] Focus switches: " << sink->getFocusSwitchCount() << " ("
+              << actions.getFocusSwitchesPerSequence() << " per sequence)" << std::endl;
+    return 0;
+}
+
+int Benchmark::emailHelper(const std::string& helperCommand, size_t messages) {
+    messages = std::max<size_t>(1, messages);
+    size_t spawnMessages = std::min<size_t>(messages, 50);
+    std::cout << std::endl << "[BENCH] Email helper: " << helperCommand << std::endl;
+
+    // Helper start-up logging would dominate the timing
+    std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+    std::string reply;
+    size_t spawnFailed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < spawnMessages; ++i) {
+        HelperProcess helper(helperCommand);
+        if (!helper.request("sms\n[bench] spawn message " + std::to_string(i), reply, std::chrono::seconds(10)) ||
+            reply.rfind("OK", 0) != 0) {
+            spawnFailed++;
+        }
+    }
+    auto spawned = std::chrono::steady_clock::now();
+    HelperProcess helper(helperCommand);
+    size_t persistentFailed = 0;
+    for (size_t i = 0; i < messages; ++i) {
+        if (!helper.request("sms\n[bench] persistent message " + std::to_string(i), reply, std::chrono::seconds(10)) ||
+            reply.rfind("OK", 0) != 0) {
+            persistentFailed++;
+        }
+    }
+    auto done = std::chrono::steady_clock::now();
+    std::cout.rdbuf(coutBuffer);
+    std::cout.clear();
+
+    double spawnMs = std::chrono::duration<double, std::milli>(spawned - start).count();
+    double persistentMs = std::chrono::duration<double, std::milli>(done - spawned).count();
+    std::cout << std::fixed << std::setprecision(3)
+              << "[BENCH] Spawn per message: " << spawnMessages << " in " << spawnMs << " ms ("
+              << spawnMs / spawnMessages << " ms/message), failed " << spawnFailed << std::endl
+              << "[BENCH] Persistent helper: " << messages << " in " << persistentMs << " ms ("
+              << persistentMs / messages << " ms/message), failed " << persistentFailed
+              << ", helper starts " << helper.getStartCount() << std::endl;
+    return spawnFailed + persistentFailed == 0 ? 0 : 1;
+}
+
+int Benchmark::serveEmailHelperStandin() {
+    // Requests are "<kind>\n<body>"; stdout carries the replies, so report on stderr
+    size_t served = 0;
+    int result = HelperProcess::serve([&served](const std::string& request) -> std::string {
+        size_t newline = request.find('\n');
+        if (newline == std::string::npos || newline == 0) {
+            return "ERROR malformed request";
+        }
+        served++;
+        return "OK";
+    });
+    std::cerr << "[STANDIN] Served " << served << " request(s)" << std::endl;
+    return result;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Forward declarations
+class ConfigManager;
+
+/**
+ * @class Benchmark
+ * @brief Offline benchmark harness driven from the command line (--bench)
+ */
+class Benchmark {
+public:
+    /**
+     * @param config Loaded configuration; its regex rules are the benchmark rule set
+     * @param iterations Number of passes over the corpus per measurement
+     */
+    Benchmark(const ConfigManager& config, int iterations = 5);
+
+    /**
+     * @brief Load the corpus to match against
+     * @param corpusPath Path to a log file; every non-empty line becomes one event
+     * @return true if at least one line was loaded, false otherwise
+     */
+    bool loadCorpus(const std::string& corpusPath);
+
+    /**
+     * @brief Compare every compiled-in regex engine on the same rule set and corpus
+     * @return Process exit code (0 on success)
+     */
+    int compareEngines();
+
+    /**
+     * @brief Time rule loading for generated rule packs (1k and 10k rules) on every engine,
+     *        adding rules one at a time versus one batch; needs no corpus
+     * @return Process exit code (0 on success)
+     */
+    int compileStartup();
+
+    /**
+     * @brief Run the corpus through matching, action planning and scheduling into a
+     *        recording sink, reporting throughput and line-to-action latency; needs no game client
+     * @param targets Number of game windows the sink simulates (drives the focus switch count)
+     * @return Process exit code (0 on success)
+     */
+    int pipeline(size_t targets = 1);
+
+    /**
+     * @brief Send messages to an email helper, starting it per message (the old EmailService
+     *        spawn) and then keeping one instance, reporting messages per second for each
+     * @param helperCommand Command that starts the helper (e.g. this program with --email-helper-standin)
+     * @param messages Messages sent to the persistent helper (the spawn run sends fewer)
+     * @return Process exit code (0 on success)
+     */
+    int emailHelper(const std::string& helperCommand, size_t messages = 1000);
+
+    /**
+     * @brief Stand-in for EmailService --serve: answers helper requests on stdin/stdout
+     *        without sending mail, so the protocol runs anywhere
+     * @return Process exit code
+     */
+    static int serveEmailHelperStandin();
+
+private:
+    const ConfigManager& _config;
+    int _iterations;
+    std::vector<std::string> _corpus;
+};
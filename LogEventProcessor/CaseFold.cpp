@@ -0,0 +1,253 @@
+#include "CaseFold.h"
+#include <algorithm>
+#include <cctype>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define LEP_CASEFOLD_SSE2 1
+#endif
+
+namespace {
+
+inline char lowerAscii(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Parse a fixed number of hex digits starting at pos; returns -1 if any digit is missing
+long parseHex(const std::string& s, size_t pos, size_t digits) {
+    if (pos + digits > s.size()) return -1;
+    long value = 0;
+    for (size_t k = 0; k < digits; ++k) {
+        int h = hexValue(s[pos + k]);
+        if (h < 0) return -1;
+        value = value * 16 + h;
+    }
+    return value;
+}
+
+std::string toHex(long value, size_t digits) {
+    static const char* hex = "0123456789abcdef";
+    std::string out(digits, '0');
+    for (size_t k = 0; k < digits; ++k) {
+        out[digits - 1 - k] = hex[value & 0xF];
+        value >>= 4;
+    }
+    return out;
+}
+
+inline long lowerCodePoint(long cp) {
+    return (cp >= 'A' && cp <= 'Z') ? cp + ('a' - 'A') : cp;
+}
+
+// Append the class range lo-hi as it must read against folded text
+void appendClassRange(std::string& out, char lo, char hi) {
+    bool loUpper = lo >= 'A' && lo <= 'Z';
+    bool hiUpper = hi >= 'A' && hi <= 'Z';
+    if (loUpper && hiUpper) {
+        out += std::string{ lowerAscii(lo), '-', lowerAscii(hi) };
+        return;
+    }
+    out += std::string{ lo, '-', hi };
+    // A mixed range such as A-z keeps its other members; its letters also match in lowercase
+    if (lo <= 'Z' && hi >= 'A' && lo <= hi) {
+        char first = lowerAscii(std::max(lo, 'A'));
+        char last = lowerAscii(std::min(hi, 'Z'));
+        out.push_back(first);
+        if (last != first) {
+            out += std::string{ '-', last };
+        }
+    }
+}
+
+} // namespace
+
+void asciiToLower(const char* src, size_t length, char* dst) {
+    size_t i = 0;
+#ifdef LEP_CASEFOLD_SSE2
+    const __m128i beforeA = _mm_set1_epi8('A' - 1);
+    const __m128i afterZ = _mm_set1_epi8('Z' + 1);
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    for (; i + 16 <= length; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        // Signed compares: bytes >= 0x80 are negative and never fall inside 'A'..'Z'
+        __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, beforeA), _mm_cmplt_epi8(v, afterZ));
+        v = _mm_or_si128(v, _mm_and_si128(upper, caseBit));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+    }
+#endif
+    for (; i < length; ++i) {
+        dst[i] = lowerAscii(src[i]);
+    }
+}
+
+std::string lowerPatternLiterals(const std::string& pattern) {
+    std::string out;
+    out.reserve(pattern.size());
+    const size_t n = pattern.size();
+    size_t i = 0;
+    bool inQuote = false;   // inside \Q...\E
+    int classDepth = 0;     // inside [...]
+
+    // Copy verbatim up to and including the terminator
+    auto copyUntil = [&](char terminator) {
+        while (i < n && pattern[i] != terminator) out.push_back(pattern[i++]);
+        if (i < n) out.push_back(pattern[i++]);
+    };
+
+    while (i < n) {
+        char c = pattern[i];
+
+        if (inQuote) {
+            if (c == '\\' && i + 1 < n && pattern[i + 1] == 'E') {
+                out += "\\E";
+                i += 2;
+                inQuote = false;
+            } else {
+                out.push_back(lowerAscii(c));
+                ++i;
+            }
+            continue;
+        }
+
+        if (c == '\\' && i + 1 < n) {
+            char e = pattern[i + 1];
+            if (e == 'Q') {
+                out += "\\Q";
+                i += 2;
+                inQuote = true;
+            } else if (e == 'x' && i + 2 < n && pattern[i + 2] == '{') {
+                // \x{HHHH}
+                size_t close = pattern.find('}', i + 3);
+                long cp = close == std::string::npos ? -1 : parseHex(pattern, i + 3, close - (i + 3));
+                if (cp >= 0) {
+                    out += "\\x{" + toHex(lowerCodePoint(cp), close - (i + 3)) + "}";
+                    i = close + 1;
+                } else {
+                    out += "\\x";
+                    i += 2;
+                }
+            } else if (e == 'x' || e == 'u') {
+                // \xHH and \uHHHH name a character that may be an uppercase letter
+                size_t digits = e == 'x' ? 2 : 4;
+                long cp = parseHex(pattern, i + 2, digits);
+                if (cp >= 0) {
+                    out += std::string("\\") + e + toHex(lowerCodePoint(cp), digits);
+                    i += 2 + digits;
+                } else {
+                    out.push_back('\\');
+                    out.push_back(e);
+                    i += 2;
+                }
+            } else if (e == 'c' && i + 2 < n) {
+                // Control escape: letter case is irrelevant but keep it as written
+                out.append(pattern, i, 3);
+                i += 3;
+            } else if ((e == 'k' || e == 'g' || e == 'p' || e == 'P') && i + 2 < n &&
+                       (pattern[i + 2] == '<' || pattern[i + 2] == '{' || pattern[i + 2] == '\'')) {
+                // Named backreference or Unicode property: keep the name
+                char open = pattern[i + 2];
+                char close = open == '<' ? '>' : (open == '{' ? '}' : '\'');
+                out.append(pattern, i, 3);
+                i += 3;
+                copyUntil(close);
+            } else {
+                // Class escapes (\S, \W, \D, \B, ...) and escaped metacharacters are case sensitive
+                out.push_back('\\');
+                out.push_back(e);
+                i += 2;
+            }
+            continue;
+        }
+
+        if (classDepth > 0) {
+            if (c == '[' && i + 1 < n && pattern[i + 1] == ':') {
+                // POSIX class: [:upper:] would never match folded text, so it becomes [:lower:]
+                size_t close = pattern.find(":]", i + 2);
+                if (close != std::string::npos) {
+                    std::string name = pattern.substr(i + 2, close - (i + 2));
+                    out += "[:" + (name == "upper" ? std::string("lower") : name) + ":]";
+                    i = close + 2;
+                    continue;
+                }
+            }
+            if (c == ']') {
+                classDepth--;
+            } else if (i + 2 < n && pattern[i + 1] == '-' && pattern[i + 2] != ']' && pattern[i + 2] != '\\' &&
+                       pattern[i + 2] != '[') {
+                // Lowering each endpoint alone would turn A-z into a-z, or Z-a into an invalid z-a
+                appendClassRange(out, c, pattern[i + 2]);
+                i += 3;
+                continue;
+            }
+            out.push_back(lowerAscii(c));
+            ++i;
+            continue;
+        }
+
+        if (c == '[') {
+            classDepth++;
+            out.push_back(c);
+            ++i;
+            // A leading ']' (or '^]') is a literal member, not the end of the class
+            if (i < n && pattern[i] == '^') out.push_back(pattern[i++]);
+            if (i < n && pattern[i] == ']') out.push_back(pattern[i++]);
+            continue;
+        }
+
+        if (c == '(' && i + 1 < n && pattern[i + 1] == '*') {
+            // PCRE verbs such as (*UTF) or (*SKIP)
+            copyUntil(')');
+            continue;
+        }
+
+        if (c == '(' && i + 1 < n && pattern[i + 1] == '?') {
+            std::string_view rest(pattern.data() + i, n - i);
+            if (rest.rfind("(?<", 0) == 0 && rest.size() > 3 && rest[3] != '=' && rest[3] != '!') {
+                out += "(?<";
+                i += 3;
+                copyUntil('>');
+            } else if (rest.rfind("(?P<", 0) == 0 || rest.rfind("(?P>", 0) == 0) {
+                out.append(pattern, i, 4);
+                i += 4;
+                copyUntil('>');
+            } else if (rest.rfind("(?P=", 0) == 0 || rest.rfind("(?&", 0) == 0) {
+                size_t prefix = rest[2] == 'P' ? 4 : 3;
+                out.append(pattern, i, prefix);
+                i += prefix;
+                copyUntil(')');
+            } else if (rest.rfind("(?'", 0) == 0) {
+                out += "(?'";
+                i += 3;
+                copyUntil('\'');
+            } else {
+                // Inline flags like (?i), (?U) or (?x: keep their case
+                out += "(?";
+                i += 2;
+                while (i < n && (std::isalpha(static_cast<unsigned char>(pattern[i])) || pattern[i] == '-' || pattern[i] == '^')) {
+                    out.push_back(pattern[i++]);
+                }
+            }
+            continue;
+        }
+
+        out.push_back(lowerAscii(c));
+        ++i;
+    }
+    return out;
+}
+
+FoldedLine::FoldedLine(std::string_view original) : _original(original) {
+    thread_local std::string buffer;
+    if (buffer.size() < original.size()) {
+        buffer.resize(original.size());
+    }
+    asciiToLower(original.data(), original.size(), &buffer[0]);
+    _folded = std::string_view(buffer.data(), original.size());
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Lowercase ASCII letters from src into dst (same length); other bytes are copied unchanged
+ * @param src Source bytes
+ * @param length Number of bytes
+ * @param dst Destination buffer of at least length bytes (may equal src)
+ */
+void asciiToLower(const char* src, size_t length, char* dst);
+
+/**
+ * @brief Lowercase the literal parts of a regex so it matches ASCII-lowercased text case-sensitively.
+ *
+ * Escapes (\S, \W, \D, ...), group names, backreference names and PCRE verbs are kept as written.
+ * @param pattern Regex pattern
+ * @return Pattern equivalent to a case-insensitive compile of the original for ASCII input
+ */
+std::string lowerPatternLiterals(const std::string& pattern);
+
+/**
+ * @class FoldedLine
+ * @brief A line and its ASCII-lowercased copy, built once and shared by every rule search.
+ *
+ * The folded copy lives in a per-thread buffer, so only one FoldedLine may be alive per thread.
+ * Folding preserves byte length, so capture offsets found in folded() index original() directly.
+ */
+class FoldedLine {
+public:
+    explicit FoldedLine(std::string_view original);
+
+    std::string_view original() const { return _original; }
+    std::string_view folded() const { return _folded; }
+
+private:
+    std::string_view _original;
+    std::string_view _folded;
+};
@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <iostream>
 #include <unordered_set>
+#include <filesystem>
 
 ConfigManager::ConfigManager() : _isLoaded(false), _lastConfigPath("") {
 }
@@ -67,7 +68,12 @@ std::string ConfigManager::getLogFilePath() const {
 }
 
 std::string ConfigManager::getOutputDirectory() const {
-    return getString("output_directory", "./output");
+    std::string dir = getString("output_directory", "");
+    // parseYAML only strips double quotes; treat '' like an unset value
+    if (dir.size() >= 2 && dir.front() == '\'' && dir.back() == '\'') {
+        dir = dir.substr(1, dir.size() - 2);
+    }
+    return dir.empty() ? "./output" : dir;
 }
 
 int ConfigManager::getPollingInterval() const {
@@ -198,6 +204,66 @@ bool ConfigManager::loadRegexRulesAndActions(RegexMatcher& matcher, ActionManage
     std::vector<ActionMapping> currentSteps;
     ActionMapping currentStep;
     int currentCooldownMs = 0;
+    std::string currentEngine;
+    bool currentStopProcessing = false;
+    std::string currentGroup;
+    uint32_t currentChannels = 0;
+    
+    // rule_groups: entries, added to the matcher before the rules that name them
+    bool inRuleGroups = false;
+    std::vector<RuleGroup> ruleGroups;
+    auto unquote = [](std::string v) {
+        v.erase(0, v.find_first_not_of(" \t")); v.erase(v.find_last_not_of(" \t") + 1);
+        if (v.size() >= 2 && (v.front()=='"' || v.front()=='\'') && v.back()==v.front()) v = v.substr(1, v.size()-2);
+        return v;
+    };
+    
+    // Rules are collected and compiled in one batch; actions are attached once the patterns exist
+    struct ParsedRule {
+        RegexRule rule;
+        bool isSequence;
+        std::vector<ActionMapping> steps;
+    };
+    std::vector<ParsedRule> parsedRules;
+    auto flushRule = [&]() {
+        if (!currentRule.empty() && !currentPattern.empty()) {
+            // Flush any pending step in actions list
+            if (inActionsList) {
+                if (!currentStep.actionType.empty() || !currentStep.actionValue.empty()) {
+                    currentSteps.push_back(currentStep);
+                }
+            }
+            std::cout << "[PARSE] Adding rule name='" << currentRule << "' pattern='" << currentPattern << "'"
+                      << (inActionsList ? " with steps" : " with single action") << std::endl;
+            ParsedRule parsed{RegexRule(currentRule, currentPattern, "", currentEnabled, currentCooldownMs, currentEngine,
+                                        currentStopProcessing),
+                              inActionsList && !currentSteps.empty(), {}};
+            if (parsed.isSequence) {
+                // Ensure ruleName is set on each step
+                for (auto& s : currentSteps) { s.ruleName = currentRule; }
+                parsed.steps = currentSteps;
+            } else {
+                parsed.steps.emplace_back(currentRule, currentActionType, currentActionValue, currentModifiers, currentEnabled);
+            }
+            parsed.rule.group = currentGroup;
+            parsed.rule.channels = currentChannels;
+            parsedRules.push_back(std::move(parsed));
+        } else if (!currentRule.empty()) {
+            std::cout << "[PARSE] Skipping rule name='" << currentRule << "' due to empty pattern" << std::endl;
+        }
+    };
+    
+    // Global engine applies to every rule without its own "engine:" key
+    std::string defaultEngine = getString("regex_engine", "");
+    if (!defaultEngine.empty()) {
+        matcher.setDefaultEngine(defaultEngine);
+    }
+    matcher.setAdaptiveOrder(getBool("adaptive_rule_order", false));
+    matcher.setFirstMatch(getBool("first_match", false));
+    matcher.setMatchCacheEntries(static_cast<size_t>(std::max(0, getInt("match_cache_entries", 2048))));
+    matcher.setSearchBudget(static_cast<uint64_t>(std::max(0, getInt("regex_match_limit", 1000000))),
+                            static_cast<uint32_t>(std::max(0, getInt("regex_search_budget_ms", 50))),
+                            static_cast<uint32_t>(std::max(0, getInt("regex_quarantine_strikes", 3))));
     
     // Helper: convert template with '#' into regex by only replacing '#' with a capture of non-space
     auto templateToRegex = [](const std::string& templ) -> std::string {
@@ -226,12 +292,48 @@ bool ConfigManager::loadRegexRulesAndActions(RegexMatcher& matcher, ActionManage
     };
 
     while (std::getline(stream, line)) {
+        // A top-level key starts in column 0; only rule_groups needs to know
+        bool topLevelKey = !line.empty() && line[0] != ' ' && line[0] != '\t' && line[0] != '-' &&
+                           line[0] != '#' && line.find(':') != std::string::npos;
         // Trim whitespace
         line.erase(0, line.find_first_not_of(" \t"));
         line.erase(line.find_last_not_of(" \t") + 1);
         
         if (line == "regex_rules:") {
             inRegexRules = true;
+            inRuleGroups = false;
+            continue;
+        }
+        if (line == "rule_groups:") {
+            flushRule();
+            currentRule.clear();
+            inRegexRules = false;
+            inRuleGroups = true;
+            continue;
+        }
+        if (inRuleGroups && topLevelKey) {
+            // Any other top-level key ends the section; the line is handled below as usual
+            inRuleGroups = false;
+        }
+        if (inRuleGroups) {
+            if (line.empty() || line[0] == '#') {
+                // Blank line or comment
+            } else if (line.rfind("- name:", 0) == 0) {
+                ruleGroups.emplace_back();
+                ruleGroups.back().name = unquote(line.substr(7));
+            } else if (!ruleGroups.empty() && line.rfind("gate:", 0) == 0) {
+                ruleGroups.back().gateLiteral = unquote(line.substr(5));
+            } else if (!ruleGroups.empty() && line.rfind("gate_pattern:", 0) == 0) {
+                ruleGroups.back().gatePattern = collapseDoubleBackslashes(unquote(line.substr(13)));
+            } else if (!ruleGroups.empty() && line.rfind("parent:", 0) == 0) {
+                ruleGroups.back().parent = unquote(line.substr(7));
+            } else if (!ruleGroups.empty() && line.rfind("engine:", 0) == 0) {
+                ruleGroups.back().engine = unquote(line.substr(7));
+            } else {
+                // Most likely a rule placed under rule_groups: instead of regex_rules:
+                std::cerr << "rule_groups: ignoring unrecognised line '" << line << "'"
+                          << (ruleGroups.empty() ? std::string() : " in group '" + ruleGroups.back().name + "'") << std::endl;
+            }
             continue;
         }
         
@@ -243,26 +345,7 @@ bool ConfigManager::loadRegexRulesAndActions(RegexMatcher& matcher, ActionManage
         
         if (inRegexRules && line.rfind("- name:", 0) == 0) {
             // Save previous rule if exists
-            if (!currentRule.empty() && !currentPattern.empty()) {
-                // Flush any pending step in actions list
-                if (inActionsList) {
-                    if (!currentStep.actionType.empty() || !currentStep.actionValue.empty()) {
-                        currentSteps.push_back(currentStep);
-                    }
-                }
-                std::cout << "[PARSE] Adding rule name='" << currentRule << "' pattern='" << currentPattern << "'"
-                          << (inActionsList ? " with steps" : " with single action") << std::endl;
-                matcher.addRule(currentRule, currentPattern, "", currentEnabled, currentCooldownMs);
-                if (inActionsList && !currentSteps.empty()) {
-                    // Ensure ruleName is set on each step
-                    for (auto& s : currentSteps) { s.ruleName = currentRule; }
-                    actionManager.addActionSequence(currentRule, currentSteps);
-                } else {
-                    actionManager.addActionMapping(currentRule, currentActionType, currentActionValue, currentModifiers, currentEnabled);
-                }
-            } else if (!currentRule.empty()) {
-                std::cout << "[PARSE] Skipping rule name='" << currentRule << "' due to empty pattern" << std::endl;
-            }
+            flushRule();
             
             // Start new rule
             // Extract value after ':' and strip optional quotes
@@ -282,6 +365,10 @@ bool ConfigManager::loadRegexRulesAndActions(RegexMatcher& matcher, ActionManage
             currentModifiers = 0;
             currentEnabled = true;
             currentCooldownMs = 0;
+            currentEngine.clear();
+            currentStopProcessing = false;
+            currentGroup.clear();
+            currentChannels = 0;
             inActionsList = false;
             currentSteps.clear();
             currentStep = ActionMapping();
@@ -308,6 +395,29 @@ bool ConfigManager::loadRegexRulesAndActions(RegexMatcher& matcher, ActionManage
             try { currentCooldownMs = std::stoi(v); } catch (...) { currentCooldownMs = 0; }
             if (currentCooldownMs < 0) currentCooldownMs = 0;
         }
+        else if (inRegexRules && line.rfind("engine:", 0) == 0) {
+            size_t colon = line.find(':');
+            std::string v = line.substr(colon + 1);
+            v.erase(0, v.find_first_not_of(" \t")); v.erase(v.find_last_not_of(" \t") + 1);
+            if (!v.empty() && (v.front()=='"' || v.front()=='\'')) { char q=v.front(); if (v.back()==q) v=v.substr(1, v.size()-2);} 
+            currentEngine = v;
+        }
+        else if (inRegexRules && line.rfind("stop_processing:", 0) == 0) {
+            std::string v = line.substr(16);
+            v.erase(0, v.find_first_not_of(" \t")); v.erase(v.find_last_not_of(" \t") + 1);
+            std::transform(v.begin(), v.end(), v.begin(), ::tolower);
+            currentStopProcessing = (v == "true" || v == "1" || v == "yes");
+        }
+        else if (inRegexRules && line.rfind("channel:", 0) == 0) {
+            std::string unknown;
+            if (!parseLogChannels(unquote(line.substr(8)), currentChannels, unknown)) {
+                std::cerr << "Rule '" << currentRule << "': unknown channel '" << unknown
+                          << "' (expected tell, group, guild, say, chat, combat or system)" << std::endl;
+            }
+        }
+        else if (inRegexRules && line.rfind("group:", 0) == 0) {
+            currentGroup = unquote(line.substr(6));
+        }
         else if (inRegexRules && line == "actions:") {
             inActionsList = true;
             currentSteps.clear();
@@ -419,26 +529,31 @@ bool ConfigManager::loadRegexRulesAndActions(RegexMatcher& matcher, ActionManage
     }
     
     // Save the last rule
-    if (!currentRule.empty() && !currentPattern.empty()) {
-        if (inActionsList) {
-            if (!currentStep.actionType.empty() || !currentStep.actionValue.empty()) {
-                currentSteps.push_back(currentStep);
-            }
-        }
-        std::cout << "[PARSE] Adding rule name='" << currentRule << "' pattern='" << currentPattern << "'"
-                  << (inActionsList ? " with steps" : " with single action") << std::endl;
-        matcher.addRule(currentRule, currentPattern, "", currentEnabled, currentCooldownMs);
-        if (inActionsList && !currentSteps.empty()) {
-            for (auto& s : currentSteps) { s.ruleName = currentRule; }
-            actionManager.addActionSequence(currentRule, currentSteps);
+    flushRule();
+    
+    if (!ruleGroups.empty()) {
+        std::cout << "Loaded " << matcher.addRuleGroups(ruleGroups) << " rule groups." << std::endl;
+    }
+    std::vector<RegexRule> rules;
+    rules.reserve(parsedRules.size());
+    for (const auto& parsed : parsedRules) {
+        rules.push_back(parsed.rule);
+    }
+    if (getBool("rule_cache", true)) {
+        matcher.addRulesCached(rules, (std::filesystem::path(getOutputDirectory()) / "rule_cache.bin").string());
+    } else {
+        matcher.addRules(rules);
+    }
+    for (const auto& parsed : parsedRules) {
+        if (parsed.isSequence) {
+            actionManager.addActionSequence(parsed.rule.name, parsed.steps);
         } else {
-            actionManager.addActionMapping(currentRule, currentActionType, currentActionValue, currentModifiers, currentEnabled);
+            actionManager.addActionMapping(parsed.steps.front());
         }
-    } else if (!currentRule.empty()) {
-        std::cout << "[PARSE] Skipping rule name='" << currentRule << "' due to empty pattern" << std::endl;
     }
     
-    std::cout << "Loaded " << matcher.getRuleCount() << " regex rules with actions." << std::endl;
+    std::cout << "Loaded " << matcher.getRuleCount() << " regex rules with actions ("
+              << matcher.getCompiledRuleCount() << " compiled; disabled rules compile when enabled)." << std::endl;
     return true;
 }
 
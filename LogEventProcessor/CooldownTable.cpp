@@ -0,0 +1,69 @@
+#include "CooldownTable.h"
+#include <iostream>
+
+CooldownTable::CooldownTable() : _epoch(Clock::now()) {
+    for (auto& chunk : _chunks) {
+        chunk.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+CooldownTable::~CooldownTable() {
+    for (auto& chunk : _chunks) {
+        delete[] chunk.load(std::memory_order_relaxed);
+    }
+}
+
+CooldownTable::Slot* CooldownTable::chunk(size_t index) {
+    Slot* slots = _chunks[index].load(std::memory_order_acquire);
+    if (slots) {
+        return slots;
+    }
+    std::lock_guard<std::mutex> lock(_allocMutex);
+    slots = _chunks[index].load(std::memory_order_relaxed);
+    if (!slots) {
+        slots = new Slot[kChunkSlots];
+        _chunks[index].store(slots, std::memory_order_release);
+    }
+    return slots;
+}
+
+void CooldownTable::reserve(size_t count) {
+    size_t chunks = (count + kChunkSlots - 1) >> kChunkBits;
+    for (size_t i = 0; i < chunks && i < kMaxChunks; ++i) {
+        chunk(i);
+    }
+}
+
+bool CooldownTable::tryClaim(uint32_t ruleId, int cooldownMs, Clock::time_point now) {
+    if (cooldownMs <= 0) {
+        return true;
+    }
+    size_t index = ruleId >> kChunkBits;
+    if (index >= kMaxChunks) {
+        std::cerr << "[COOLDOWN] Rule id " << ruleId << " beyond table capacity; cooldown not applied" << std::endl;
+        return true;
+    }
+    Slot& slot = chunk(index)[ruleId & (kChunkSlots - 1)];
+    int64_t nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(now - _epoch).count();
+    int64_t readyAt = nowNs + static_cast<int64_t>(cooldownMs) * 1000000;
+    int64_t current = slot.readyAtNs.load(std::memory_order_relaxed);
+    // A failed exchange means another thread just claimed; the loop re-checks against its time
+    do {
+        if (nowNs < current) {
+            return false;
+        }
+    } while (!slot.readyAtNs.compare_exchange_weak(current, readyAt, std::memory_order_acq_rel, std::memory_order_relaxed));
+    return true;
+}
+
+void CooldownTable::reset() {
+    for (auto& chunk : _chunks) {
+        Slot* slots = chunk.load(std::memory_order_acquire);
+        if (!slots) {
+            continue;
+        }
+        for (size_t i = 0; i < kChunkSlots; ++i) {
+            slots[i].readyAtNs.store(0, std::memory_order_relaxed);
+        }
+    }
+}
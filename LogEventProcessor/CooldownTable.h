@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+/**
+ * @class CooldownTable
+ * @brief Per-rule cooldown state indexed by RegexRule::id, without locks on the hot path.
+ *
+ * Each rule owns one cache line holding the earliest time it may fire again. A fire is
+ * claimed with compare-and-swap, so when several threads race for the same rule exactly one
+ * wins and the rest see the cooldown. Slots live in fixed chunks that never move; a chunk is
+ * allocated once, by reserve() at load time or on its first claim.
+ */
+class CooldownTable {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CooldownTable();
+    ~CooldownTable();
+
+    CooldownTable(const CooldownTable&) = delete;
+    CooldownTable& operator=(const CooldownTable&) = delete;
+
+    /**
+     * @brief Allocate slots for rule ids below count
+     */
+    void reserve(size_t count);
+
+    /**
+     * @brief Claim a fire for a rule unless it is still cooling down
+     * @param ruleId Dense rule id
+     * @param cooldownMs Cooldown to start on success (0 always succeeds and records nothing)
+     * @param now Time of the fire
+     * @return true if the rule may fire; false if it fired less than its cooldown ago
+     */
+    bool tryClaim(uint32_t ruleId, int cooldownMs, Clock::time_point now = Clock::now());
+
+    /**
+     * @brief Forget every cooldown (rule ids are being reassigned)
+     */
+    void reset();
+
+private:
+    static constexpr size_t kChunkBits = 6;
+    static constexpr size_t kChunkSlots = size_t(1) << kChunkBits;
+    static constexpr size_t kMaxChunks = 1024; // 65536 rule ids
+
+    struct alignas(64) Slot {
+        std::atomic<int64_t> readyAtNs{0}; // Clock ticks since _epoch; the rule may fire at or after this
+    };
+
+    Clock::time_point _epoch;
+    std::atomic<Slot*> _chunks[kMaxChunks];
+    std::mutex _allocMutex;
+
+    Slot* chunk(size_t index);
+};
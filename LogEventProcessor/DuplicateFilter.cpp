@@ -0,0 +1,88 @@
+#include "DuplicateFilter.h"
+#include "MatchMemo.h"
+#include <algorithm>
+
+DuplicateFilter::DuplicateFilter() {
+}
+
+void DuplicateFilter::configure(std::chrono::milliseconds window, size_t maxEntries, uint32_t channelMask) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    // The live slices (current plus kBuckets - 1 before it) always span at least the window
+    _sliceMs = window.count() > 0 ? (window.count() + kBuckets - 2) / static_cast<int64_t>(kBuckets - 1) : 0;
+    _bucketCapacity = std::max<size_t>(maxEntries / kBuckets, 1);
+    _channelMask = channelMask;
+
+    size_t slots = 2;
+    while (slots < _bucketCapacity * 2) {
+        slots <<= 1;
+    }
+    for (auto& bucket : _buckets) {
+        bucket.slice = -1;
+        bucket.size = 0;
+        if (_sliceMs > 0) {
+            bucket.keys.assign(slots, 0);
+        } else {
+            std::vector<uint64_t>().swap(bucket.keys);
+        }
+    }
+}
+
+bool DuplicateFilter::isEnabled() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _sliceMs > 0;
+}
+
+bool DuplicateFilter::isDuplicate(std::string_view body, uint32_t channel, Clock::time_point when) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_sliceMs == 0 || (_channelMask != 0 && (_channelMask & (1u << channel)) == 0)) {
+        return false;
+    }
+
+    uint64_t key = MatchMemo::hashBody(body, 0);
+    if (key == 0) {
+        key = 1;
+    }
+    int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(when.time_since_epoch()).count();
+    int64_t slice = nowMs / _sliceMs;
+    size_t mask = _buckets[0].keys.size() - 1;
+
+    for (const auto& bucket : _buckets) {
+        if (bucket.slice < 0 || bucket.slice > slice || slice - bucket.slice >= static_cast<int64_t>(kBuckets)) {
+            continue;
+        }
+        for (size_t i = key & mask; bucket.keys[i] != 0; i = (i + 1) & mask) {
+            if (bucket.keys[i] == key) {
+                ++_suppressed;
+                return true;
+            }
+        }
+    }
+
+    Bucket& current = _buckets[slice % kBuckets];
+    if (current.slice != slice) {
+        std::fill(current.keys.begin(), current.keys.end(), 0);
+        current.size = 0;
+        current.slice = slice;
+    }
+    if (current.size >= _bucketCapacity) {
+        ++_overflow;
+        return false;
+    }
+    size_t i = key & mask;
+    while (current.keys[i] != 0) {
+        i = (i + 1) & mask;
+    }
+    current.keys[i] = key;
+    ++current.size;
+    return false;
+}
+
+size_t DuplicateFilter::getSuppressedCount() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _suppressed;
+}
+
+size_t DuplicateFilter::getOverflowCount() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _overflow;
+}
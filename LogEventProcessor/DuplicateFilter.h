@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class DuplicateFilter
+ * @brief Drops log lines whose message was already seen within a time window.
+ *
+ * A line's key is a hash of its body (the text after the timestamp), so the same message
+ * echoed by another character's log or repeated by the client maps to the same key. The
+ * window is split into kBuckets time slices, each an open-addressing hash set of fixed
+ * size; a line is a duplicate if its key is in any live slice. The slice whose time has
+ * come around again is cleared before reuse, so memory never grows past the configured
+ * entry count. A full slice stops recording keys until it rotates (those lines pass).
+ */
+class DuplicateFilter {
+public:
+    using Clock = std::chrono::system_clock;
+
+    DuplicateFilter();
+
+    /**
+     * @brief Set the suppression window, clearing every remembered line
+     * @param window Lines repeated within this long are dropped; zero disables the filter
+     * @param maxEntries Upper bound on remembered lines across the window
+     * @param channelMask Channels to filter (bit n = LogChannel n); 0 filters every channel
+     */
+    void configure(std::chrono::milliseconds window, size_t maxEntries, uint32_t channelMask);
+
+    /**
+     * @brief Check whether the filter is active
+     */
+    bool isEnabled() const;
+
+    /**
+     * @brief Record a line and report whether it repeats one seen within the window
+     * @param body Line text after the timestamp header
+     * @param channel Line channel (LogChannel value)
+     * @param when Time the line was read
+     * @return true if the line is a duplicate and should be dropped
+     */
+    bool isDuplicate(std::string_view body, uint32_t channel, Clock::time_point when);
+
+    /**
+     * @brief Get the number of lines dropped as duplicates
+     */
+    size_t getSuppressedCount() const;
+
+    /**
+     * @brief Get the number of lines that passed because their slice was full
+     */
+    size_t getOverflowCount() const;
+
+private:
+    static constexpr size_t kBuckets = 4;
+
+    struct Bucket {
+        int64_t slice = -1;          // Time slice this bucket holds; -1 when unused
+        size_t size = 0;
+        std::vector<uint64_t> keys;  // Open addressing, 0 marks an empty slot
+    };
+
+    mutable std::mutex _mutex;
+    int64_t _sliceMs = 0;            // Window / (kBuckets - 1); zero when disabled
+    size_t _bucketCapacity = 0;
+    uint32_t _channelMask = 0;
+    Bucket _buckets[kBuckets];
+    size_t _suppressed = 0;
+    size_t _overflow = 0;
+};
@@ -0,0 +1,300 @@
+#include "EmailOutbox.h"
+#include <algorithm>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+EmailOutbox::EmailOutbox(Transport transport) : _transport(std::move(transport)) {
+}
+
+EmailOutbox::~EmailOutbox() {
+    stop();
+    if (_journal) {
+        std::fclose(_journal);
+    }
+}
+
+bool EmailOutbox::open(const std::string& journalPath) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_thread.joinable()) {
+        return _journal != nullptr;
+    }
+    _journalPath = journalPath;
+    replayJournal();
+    // Rewrite the journal with only the pending messages (recovered ones and any queued before open)
+    compactJournal();
+    if (!_journal) {
+        std::cerr << "[OUTBOX] Cannot write journal: " << journalPath << " (messages are kept in memory only)" << std::endl;
+    }
+    _stopRequested = false;
+    _thread = std::thread(&EmailOutbox::run, this);
+    return _journal != nullptr;
+}
+
+void EmailOutbox::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_thread.joinable()) {
+            return;
+        }
+        _stopRequested = true;
+    }
+    _condition.notify_all();
+    _thread.join();
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_pending.empty()) {
+        std::cout << "[OUTBOX] " << _pending.size() << " undelivered message(s) kept for the next start" << std::endl;
+    }
+}
+
+void EmailOutbox::configure(const OutboxSettings& settings) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _settings = settings;
+        _settings.batchMax = std::max<size_t>(1, _settings.batchMax);
+    }
+    _condition.notify_all();
+}
+
+bool EmailOutbox::enqueue(const std::string& kind, const std::string& body) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Message message;
+        message.id = _nextId++;
+        message.kind = kind;
+        message.body = body;
+        message.createdAt = static_cast<int64_t>(std::time(nullptr));
+        message.dueAt = Clock::now() + _settings.batchWindow;
+        writeRecord("E " + std::to_string(message.id) + ' ' + kind + ' ' + std::to_string(message.createdAt) + ' ' + escape(body));
+        _pending.push_back(std::move(message));
+        _stats.enqueued++;
+    }
+    _condition.notify_one();
+    return true;
+}
+
+OutboxStats EmailOutbox::getStats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    OutboxStats stats = _stats;
+    stats.pending = _pending.size() + _inFlight;
+    return stats;
+}
+
+void EmailOutbox::run() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    std::vector<Message> batch;
+    while (!_stopRequested) {
+        if (takeBatch(batch, Clock::now())) {
+            std::string body;
+            for (const auto& message : batch) {
+                if (!body.empty()) body += '\n';
+                body += message.body;
+            }
+            std::string kind = batch.front().kind;
+            lock.unlock();
+            bool delivered = false;
+            try {
+                delivered = _transport(kind, body);
+            } catch (const std::exception& ex) {
+                std::cerr << "[OUTBOX] Transport failed: " << ex.what() << std::endl;
+            }
+            lock.lock();
+            finishBatch(batch, delivered);
+            continue;
+        }
+        if (_pending.empty()) {
+            _condition.wait(lock);
+        } else {
+            auto next = std::min_element(_pending.begin(), _pending.end(),
+                [](const Message& a, const Message& b) { return a.dueAt < b.dueAt; });
+            _condition.wait_until(lock, next->dueAt);
+        }
+    }
+}
+
+bool EmailOutbox::takeBatch(std::vector<Message>& batch, Clock::time_point now) {
+    batch.clear();
+    auto first = std::min_element(_pending.begin(), _pending.end(),
+        [](const Message& a, const Message& b) { return a.dueAt < b.dueAt; });
+    if (first == _pending.end() || first->dueAt > now) {
+        return false;
+    }
+    // The due message takes along every other message of its kind that is not backing off
+    std::string kind = first->kind;
+    auto stays = [&](const Message& message) {
+        bool joins = batch.size() < _settings.batchMax && message.kind == kind &&
+                     (message.attempts == 0 || message.dueAt <= now);
+        if (joins) {
+            batch.push_back(message);
+        }
+        return !joins;
+    };
+    _pending.erase(std::stable_partition(_pending.begin(), _pending.end(), stays), _pending.end());
+    _inFlight = batch.size();
+    return !batch.empty();
+}
+
+void EmailOutbox::finishBatch(std::vector<Message>& batch, bool delivered) {
+    if (delivered) {
+        _stats.delivered += batch.size();
+        _stats.batches++;
+        for (const auto& message : batch) {
+            writeRecord("D " + std::to_string(message.id));
+        }
+        std::cout << "[OUTBOX] Sent " << batch.size() << " " << batch.front().kind << " message(s)" << std::endl;
+    } else {
+        _stats.retries++;
+        std::string kind = batch.front().kind;
+        auto now = Clock::now();
+        for (auto& message : batch) {
+            message.attempts++;
+            if (_settings.maxAttempts > 0 && message.attempts >= _settings.maxAttempts) {
+                std::cerr << "[OUTBOX] Giving up on " << message.kind << " message after " << message.attempts
+                          << " attempts: " << message.body << std::endl;
+                _stats.failed++;
+                writeRecord("D " + std::to_string(message.id));
+                continue;
+            }
+            message.dueAt = now + retryDelay(message.attempts);
+            _pending.push_back(std::move(message));
+        }
+        std::sort(_pending.begin(), _pending.end(), [](const Message& a, const Message& b) { return a.id < b.id; });
+        std::cerr << "[OUTBOX] Delivery of " << batch.size() << " " << kind
+                  << " message(s) failed; " << _pending.size() << " pending" << std::endl;
+    }
+    batch.clear();
+    _inFlight = 0;
+    // Keep the journal from growing: rewrite it when it is mostly delivered records
+    if (_pending.empty() ? _journalRecords > 0 : _journalRecords > 256 && _journalRecords > 4 * _pending.size()) {
+        compactJournal();
+    }
+}
+
+EmailOutbox::Clock::duration EmailOutbox::retryDelay(unsigned attempts) const {
+    auto delay = _settings.retryBase;
+    for (unsigned i = 1; i < attempts && delay < _settings.retryMax; ++i) {
+        delay *= 2;
+    }
+    return std::min(delay, _settings.retryMax);
+}
+
+void EmailOutbox::writeRecord(const std::string& record) {
+    if (!_journal) {
+        return;
+    }
+    std::fputs(record.c_str(), _journal);
+    std::fputc('\n', _journal);
+    std::fflush(_journal);
+    _journalRecords++;
+}
+
+void EmailOutbox::compactJournal() {
+    if (_journalPath.empty()) {
+        return;
+    }
+    if (_journal) {
+        std::fclose(_journal);
+        _journal = nullptr;
+    }
+    // Write the pending messages to a new file and swap it in, so a crash leaves one whole journal
+    std::string tempPath = _journalPath + ".tmp";
+    FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (file) {
+        for (const auto& message : _pending) {
+            std::string record = "E " + std::to_string(message.id) + ' ' + message.kind + ' ' +
+                                 std::to_string(message.createdAt) + ' ' + escape(message.body) + '\n';
+            std::fputs(record.c_str(), file);
+        }
+        bool written = std::fflush(file) == 0;
+        std::fclose(file);
+        std::error_code ec;
+        if (written) {
+            std::filesystem::rename(tempPath, _journalPath, ec);
+        }
+        if (!written || ec) {
+            std::cerr << "[OUTBOX] Failed to compact journal: " << _journalPath << std::endl;
+        }
+    }
+    _journal = std::fopen(_journalPath.c_str(), "ab");
+    _journalRecords = _pending.size();
+}
+
+void EmailOutbox::replayJournal() {
+    std::ifstream in(_journalPath, std::ios::binary);
+    if (!in.is_open()) {
+        return;
+    }
+    std::map<uint64_t, Message> recovered;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        char type = 0;
+        uint64_t id = 0;
+        fields >> type >> id;
+        if (type == 'D') {
+            recovered.erase(id);
+        } else if (type == 'E') {
+            Message message;
+            message.id = id;
+            fields >> message.kind >> message.createdAt;
+            if (fields.get() == ' ') {
+                std::string body;
+                std::getline(fields, body);
+                message.body = unescape(body);
+                recovered[id] = std::move(message);
+            }
+        }
+    }
+    if (recovered.empty()) {
+        return;
+    }
+    // Recovered messages are older than anything queued before open; renumber all of them in order
+    std::vector<Message> pending;
+    pending.reserve(recovered.size() + _pending.size());
+    auto now = Clock::now();
+    for (auto& entry : recovered) {
+        entry.second.dueAt = now + _settings.batchWindow;
+        pending.push_back(std::move(entry.second));
+    }
+    for (auto& message : _pending) {
+        pending.push_back(std::move(message));
+    }
+    _nextId = 1;
+    for (auto& message : pending) {
+        message.id = _nextId++;
+    }
+    _pending.swap(pending);
+    _stats.enqueued += recovered.size();
+    std::cout << "[OUTBOX] Recovered " << recovered.size() << " undelivered message(s) from " << _journalPath << std::endl;
+}
+
+std::string EmailOutbox::escape(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            default: out += c; break;
+        }
+    }
+    return out;
+}
+
+std::string EmailOutbox::unescape(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\\' && i + 1 < text.size()) {
+            char next = text[++i];
+            out += next == 'n' ? '\n' : next == 'r' ? '\r' : next;
+        } else {
+            out += text[i];
+        }
+    }
+    return out;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @struct OutboxSettings
+ * @brief Batching and retry policy of an EmailOutbox
+ */
+struct OutboxSettings {
+    std::chrono::milliseconds batchWindow{2000}; // Wait this long after a message for more of the same kind
+    size_t batchMax = 20;                        // Messages per delivery
+    std::chrono::milliseconds retryBase{2000};   // First retry delay; doubles per failed attempt
+    std::chrono::milliseconds retryMax{300000};  // Retry delay cap
+    unsigned maxAttempts = 8;                    // Give up after this many failed deliveries (0 = never)
+};
+
+/**
+ * @struct OutboxStats
+ * @brief Delivery counters of an EmailOutbox
+ */
+struct OutboxStats {
+    size_t enqueued = 0;   // Messages accepted (including ones recovered from the journal)
+    size_t delivered = 0;  // Messages handed to the transport successfully
+    size_t batches = 0;    // Successful deliveries (each carries one or more messages)
+    size_t retries = 0;    // Failed deliveries that were rescheduled
+    size_t failed = 0;     // Messages given up after maxAttempts
+    size_t pending = 0;    // Messages waiting
+};
+
+/**
+ * @class EmailOutbox
+ * @brief Persistent queue for sms/email actions, drained by a background sender.
+ *
+ * enqueue() appends the message to an on-disk journal and returns; it never waits for the
+ * transport. The sender thread holds each message for the batch window, then delivers every
+ * waiting message of the same kind as one body (one line per message). A failed delivery
+ * is retried with exponential backoff. Delivered messages are marked in the journal, and
+ * messages still pending at shutdown are delivered on the next start.
+ */
+class EmailOutbox {
+public:
+    /**
+     * @brief Deliver one body; returns true on success
+     * @param kind Message kind ("sms", "ack"); batches never mix kinds
+     * @param body Message lines separated by '\n'
+     */
+    using Transport = std::function<bool(const std::string& kind, const std::string& body)>;
+
+    explicit EmailOutbox(Transport transport);
+    ~EmailOutbox();
+
+    EmailOutbox(const EmailOutbox&) = delete;
+    EmailOutbox& operator=(const EmailOutbox&) = delete;
+
+    /**
+     * @brief Recover undelivered messages from the journal and start the sender thread
+     * @param journalPath Journal file; created if missing
+     * @return true if the journal is writable
+     */
+    bool open(const std::string& journalPath);
+
+    /**
+     * @brief Stop the sender thread; pending messages stay in the journal
+     */
+    void stop();
+
+    /**
+     * @brief Change the batching and retry policy
+     */
+    void configure(const OutboxSettings& settings);
+
+    /**
+     * @brief Queue a message for delivery
+     * @return true if the message was queued (and journaled, when a journal is open)
+     */
+    bool enqueue(const std::string& kind, const std::string& body);
+
+    OutboxStats getStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Message {
+        uint64_t id;
+        std::string kind;
+        std::string body;
+        int64_t createdAt;            // Unix seconds, kept in the journal
+        unsigned attempts = 0;
+        Clock::time_point dueAt;      // Earliest delivery (batch window, then backoff)
+    };
+
+    Transport _transport;
+    OutboxSettings _settings;
+    std::vector<Message> _pending;
+    uint64_t _nextId = 1;
+    std::string _journalPath;
+    FILE* _journal = nullptr;
+    size_t _journalRecords = 0;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _condition;
+    std::thread _thread;
+    bool _stopRequested = false;
+    OutboxStats _stats;
+    size_t _inFlight = 0; // Messages taken by the delivery in progress
+
+    void run();
+    bool takeBatch(std::vector<Message>& batch, Clock::time_point now);
+    void finishBatch(std::vector<Message>& batch, bool delivered);
+    Clock::duration retryDelay(unsigned attempts) const;
+    void writeRecord(const std::string& record);
+    void compactJournal();
+    void replayJournal();
+
+    static std::string escape(const std::string& text);
+    static std::string unescape(const std::string& text);
+};
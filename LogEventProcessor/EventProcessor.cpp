@@ -2,6 +2,7 @@
 #include <iostream>
 #include <iomanip>
 #include <chrono>
+#include <ctime>
 #include "ActionManager.h"
 
 EventProcessor::EventProcessor(ThreadSafeQueue<LogEventPtr>& eventQueue)
@@ -58,12 +59,22 @@ void EventProcessor::enableParallelProcessing(bool enabled, size_t workerCount)
     _workerCount = workerCount;
 }
 
+void EventProcessor::setDuplicateWindow(std::chrono::milliseconds window, size_t maxEntries, uint32_t channelMask) {
+    _duplicateFilter.configure(window, maxEntries, channelMask);
+}
+
+bool EventProcessor::isDuplicate(const LogEventPtr& event) {
+    const ChannelInfo& info = event->channelInfo;
+    return _duplicateFilter.isDuplicate(std::string_view(event->data).substr(info.bodyOffset),
+                                        static_cast<uint32_t>(info.channel), event->timestamp);
+}
+
 void EventProcessor::processLoop() {
     LogEventPtr event;
     if (!_parallelEnabled) {
         while (!_shouldStop.load()) {
             if (_eventQueue.wait_and_pop(event)) {
-                if (event && _eventHandler) {
+                if (event && _eventHandler && !isDuplicate(event)) {
                     _eventHandler(event);
                     _processedEventCount.fetch_add(1);
                 }
@@ -88,7 +99,7 @@ void EventProcessor::processLoop() {
 
     size_t seqCounter = 1;
     while (!_shouldStop.load()) {
-        if (_eventQueue.wait_and_pop(event)) {
+        if (_eventQueue.wait_and_pop(event) && event && !isDuplicate(event)) {
             _matchQueue.push(MatchTask{seqCounter++, event});
         }
     }
@@ -103,7 +114,7 @@ void EventProcessor::processLoop() {
 void EventProcessor::workerLoop() {
     MatchTask task;
     while (_matchQueue.wait_and_pop(task)) {
-        std::vector<ActionMapping> actions;
+        std::vector<ActionInvocation> actions;
         bool any = _actionManagerRef->getActionsForEvent(task.event, actions);
         if (any) {
             _resultQueue.push(MatchResult{task.seq, std::move(actions)});
@@ -152,7 +163,11 @@ void EventProcessor::defaultEventHandler(const LogEventPtr& event) {
         event->timestamp.time_since_epoch()) % 1000;
     
     std::tm timeinfo;
+#ifdef _WIN32
     localtime_s(&timeinfo, &time_t);
+#else
+    localtime_r(&time_t, &timeinfo);
+#endif
     
     std::cout << "[" << std::put_time(&timeinfo, "%Y-%m-%d %H:%M:%S");
     std::cout << "." << std::setfill('0') << std::setw(3) << ms.count() << "] ";
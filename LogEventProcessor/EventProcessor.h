@@ -8,9 +8,10 @@
 #include <map>
 #include "ThreadSafeQueue.h"
 #include "LogEvent.h"
+#include "DuplicateFilter.h"
 
 // Forward declarations
-struct ActionMapping;
+struct ActionInvocation;
 class ActionManager;
 
 /**
@@ -55,6 +56,19 @@ public:
      */
     size_t getProcessedEventCount() const { return _processedEventCount.load(); }
 
+    /**
+     * @brief Drop lines whose message repeats one seen within a window, before they are matched
+     * @param window Suppression window; zero disables deduplication
+     * @param maxEntries Upper bound on remembered lines
+     * @param channelMask Channels to deduplicate (bit n = LogChannel n); 0 means all
+     */
+    void setDuplicateWindow(std::chrono::milliseconds window, size_t maxEntries, uint32_t channelMask);
+
+    /**
+     * @brief Get the number of lines dropped as duplicates
+     */
+    size_t getSuppressedEventCount() const { return _duplicateFilter.getSuppressedCount(); }
+
     // Parallel matching API
     void enableParallelProcessing(bool enabled, size_t workerCount = 4);
 
@@ -65,6 +79,7 @@ private:
     std::atomic<bool> _shouldStop;
     std::atomic<size_t> _processedEventCount;
     EventHandler _eventHandler;
+    DuplicateFilter _duplicateFilter;
 
     // Parallel pipeline members
     bool _parallelEnabled = false;
@@ -72,11 +87,11 @@ private:
     std::vector<std::thread> _workers;
     struct MatchTask { size_t seq; LogEventPtr event; };
     ThreadSafeQueue<MatchTask> _matchQueue{ };
-    struct MatchResult { size_t seq; std::vector<ActionMapping> actions; };
+    struct MatchResult { size_t seq; std::vector<ActionInvocation> actions; };
     ThreadSafeQueue<MatchResult> _resultQueue{ };
     std::atomic<size_t> _nextSequenceToExecute{1};
     std::mutex _pendingMutex;
-    std::map<size_t, std::vector<ActionMapping>> _pending;
+    std::map<size_t, std::vector<ActionInvocation>> _pending;
     ActionManager* _actionManagerRef = nullptr; // set externally
     void workerLoop();
     void resultDispatcherLoop();
@@ -85,6 +100,12 @@ private:
      * @brief Main processing loop
      */
     void processLoop();
+
+    /**
+     * @brief Check an event against the duplicate window
+     * @return true if the event should be dropped
+     */
+    bool isDuplicate(const LogEventPtr& event);
     
     /**
      * @brief Default event handler - prints event to console
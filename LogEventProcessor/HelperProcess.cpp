@@ -0,0 +1,319 @@
+#include "HelperProcess.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+HelperProcess::HelperProcess(std::string command, std::string workingDirectory)
+    : _command(std::move(command)), _workingDirectory(std::move(workingDirectory)) {
+}
+
+HelperProcess::~HelperProcess() {
+    stop();
+}
+
+void HelperProcess::encodeLength(uint32_t length, unsigned char prefix[4]) {
+    prefix[0] = static_cast<unsigned char>(length);
+    prefix[1] = static_cast<unsigned char>(length >> 8);
+    prefix[2] = static_cast<unsigned char>(length >> 16);
+    prefix[3] = static_cast<unsigned char>(length >> 24);
+}
+
+uint32_t HelperProcess::decodeLength(const unsigned char prefix[4]) {
+    return uint32_t(prefix[0]) | uint32_t(prefix[1]) << 8 | uint32_t(prefix[2]) << 16 | uint32_t(prefix[3]) << 24;
+}
+
+bool HelperProcess::request(const std::string& payload, std::string& reply, std::chrono::milliseconds timeout) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    reply.clear();
+    if (payload.size() > kMaxFrameBytes) {
+        std::cerr << "[HELPER] Request of " << payload.size() << " bytes exceeds the frame limit" << std::endl;
+        return false;
+    }
+    if (!isRunning()) {
+        auto now = std::chrono::steady_clock::now();
+        if (_startCount > 0 && now - _lastStart < _restartInterval) {
+            return false; // Restarted too recently; the caller retries later
+        }
+        if (!start()) {
+            _failureCount++;
+            return false;
+        }
+    }
+    _requestCount++;
+
+    unsigned char prefix[4];
+    encodeLength(static_cast<uint32_t>(payload.size()), prefix);
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    bool ok = writeAll(reinterpret_cast<const char*>(prefix), sizeof(prefix)) &&
+              writeAll(payload.data(), payload.size()) &&
+              readAll(reinterpret_cast<char*>(prefix), sizeof(prefix), deadline);
+    if (ok) {
+        uint32_t length = decodeLength(prefix);
+        ok = length <= kMaxFrameBytes;
+        if (ok) {
+            reply.resize(length);
+            ok = length == 0 || readAll(&reply[0], length, deadline);
+        }
+    }
+    if (!ok) {
+        // The stream is out of step or the helper is gone: start over with a fresh process
+        std::cerr << "[HELPER] Request failed; restarting helper: " << _command << std::endl;
+        _failureCount++;
+        reply.clear();
+        kill();
+    }
+    return ok;
+}
+
+void HelperProcess::stop() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    kill();
+}
+
+#ifdef _WIN32
+
+bool HelperProcess::isRunning() const {
+    return _process != NULL && WaitForSingleObject(_process, 0) == WAIT_TIMEOUT;
+}
+
+bool HelperProcess::start() {
+    kill();
+    _lastStart = std::chrono::steady_clock::now();
+    _startCount++;
+
+    SECURITY_ATTRIBUTES sa = {};
+    sa.nLength = sizeof(sa);
+    sa.bInheritHandle = TRUE;
+    HANDLE childIn = NULL, childOut = NULL;
+    if (!CreatePipe(&childIn, &_toChild, &sa, 0) || !CreatePipe(&_fromChild, &childOut, &sa, 0)) {
+        std::cerr << "[HELPER] CreatePipe failed: " << GetLastError() << std::endl;
+        if (childIn) CloseHandle(childIn);
+        kill();
+        return false;
+    }
+    // Our ends stay private to this process
+    SetHandleInformation(_toChild, HANDLE_FLAG_INHERIT, 0);
+    SetHandleInformation(_fromChild, HANDLE_FLAG_INHERIT, 0);
+
+    STARTUPINFOA si = {};
+    si.cb = sizeof(si);
+    si.dwFlags = STARTF_USESTDHANDLES;
+    si.hStdInput = childIn;
+    si.hStdOutput = childOut;
+    si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+    PROCESS_INFORMATION pi = {};
+    std::vector<char> commandLine(_command.begin(), _command.end());
+    commandLine.push_back('\0');
+    BOOL created = CreateProcessA(NULL, commandLine.data(), NULL, NULL, TRUE, CREATE_NO_WINDOW, NULL,
+                                  _workingDirectory.empty() ? NULL : _workingDirectory.c_str(), &si, &pi);
+    CloseHandle(childIn);
+    CloseHandle(childOut);
+    if (!created) {
+        std::cerr << "[HELPER] Failed to start '" << _command << "': " << GetLastError() << std::endl;
+        kill();
+        return false;
+    }
+    CloseHandle(pi.hThread);
+    _process = pi.hProcess;
+    std::cout << "[HELPER] Started pid=" << pi.dwProcessId << ": " << _command << std::endl;
+    return true;
+}
+
+void HelperProcess::kill() {
+    // Closing its stdin asks the helper to exit; terminate it if it does not
+    if (_toChild) { CloseHandle(_toChild); _toChild = NULL; }
+    if (_fromChild) { CloseHandle(_fromChild); _fromChild = NULL; }
+    if (_process) {
+        if (WaitForSingleObject(_process, 500) == WAIT_TIMEOUT) {
+            TerminateProcess(_process, 1);
+        }
+        CloseHandle(_process);
+        _process = NULL;
+    }
+}
+
+bool HelperProcess::writeAll(const char* data, size_t size) {
+    while (size > 0) {
+        DWORD written = 0;
+        if (!WriteFile(_toChild, data, static_cast<DWORD>(size), &written, NULL)) {
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+bool HelperProcess::readAll(char* data, size_t size, std::chrono::steady_clock::time_point deadline) {
+    // Anonymous pipes have no overlapped reads: wait for data with PeekNamedPipe
+    while (size > 0) {
+        DWORD available = 0;
+        if (!PeekNamedPipe(_fromChild, NULL, 0, NULL, &available, NULL)) {
+            return false;
+        }
+        if (available == 0) {
+            if (std::chrono::steady_clock::now() >= deadline || WaitForSingleObject(_process, 1) != WAIT_TIMEOUT) {
+                return false;
+            }
+            continue;
+        }
+        DWORD read = 0;
+        if (!ReadFile(_fromChild, data, static_cast<DWORD>(std::min<size_t>(size, available)), &read, NULL) || read == 0) {
+            return false;
+        }
+        data += read;
+        size -= read;
+    }
+    return true;
+}
+
+#else
+
+bool HelperProcess::isRunning() const {
+    return _pid > 0 && waitpid(_pid, nullptr, WNOHANG) == 0;
+}
+
+bool HelperProcess::start() {
+    kill();
+    _lastStart = std::chrono::steady_clock::now();
+    _startCount++;
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        std::cerr << "[HELPER] socketpair failed: " << errno << std::endl;
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "[HELPER] fork failed: " << errno << std::endl;
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        // Child: the socket becomes stdin and stdout
+        close(fds[0]);
+        dup2(fds[1], STDIN_FILENO);
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[1]);
+        if (!_workingDirectory.empty() && chdir(_workingDirectory.c_str()) != 0) {
+            _exit(127);
+        }
+        execl("/bin/sh", "sh", "-c", _command.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    close(fds[1]);
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    _socket = fds[0];
+    _pid = pid;
+    std::cout << "[HELPER] Started pid=" << pid << ": " << _command << std::endl;
+    return true;
+}
+
+void HelperProcess::kill() {
+    // Closing the socket asks the helper to exit; terminate it if it does not
+    if (_socket >= 0) {
+        close(_socket);
+        _socket = -1;
+    }
+    if (_pid > 0) {
+        int waits = 0;
+        while (waitpid(_pid, nullptr, WNOHANG) == 0) {
+            if (++waits > 50) {
+                ::kill(_pid, SIGKILL);
+                waitpid(_pid, nullptr, 0);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        _pid = -1;
+    }
+}
+
+bool HelperProcess::writeAll(const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = send(_socket, data, size, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool HelperProcess::readAll(char* data, size_t size, std::chrono::steady_clock::time_point deadline) {
+    while (size > 0) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0) {
+            return false;
+        }
+        pollfd pfd = { _socket, POLLIN, 0 };
+        int ready = poll(&pfd, 1, static_cast<int>(left));
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready <= 0) {
+            return false;
+        }
+        ssize_t got = recv(_socket, data, size, 0);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        data += got;
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+#endif
+
+int HelperProcess::serve(const std::function<std::string(const std::string&)>& handler) {
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    // One reply frame per request frame, until stdin closes
+    std::string request;
+    unsigned char prefix[4];
+    while (std::fread(prefix, 1, sizeof(prefix), stdin) == sizeof(prefix)) {
+        uint32_t length = decodeLength(prefix);
+        if (length > kMaxFrameBytes) {
+            std::cerr << "[HELPER] Oversized request frame (" << length << " bytes)" << std::endl;
+            return 1;
+        }
+        request.resize(length);
+        if (length > 0 && std::fread(&request[0], 1, length, stdin) != length) {
+            return 1;
+        }
+        std::string reply = handler(request);
+        encodeLength(static_cast<uint32_t>(reply.size()), prefix);
+        if (std::fwrite(prefix, 1, sizeof(prefix), stdout) != sizeof(prefix) ||
+            std::fwrite(reply.data(), 1, reply.size(), stdout) != reply.size() ||
+            std::fflush(stdout) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/types.h>
+#endif
+
+/**
+ * @class HelperProcess
+ * @brief A long-lived child process answering requests over its stdin/stdout.
+ *
+ * Requests and replies are frames: a 4-byte little-endian length followed by that many
+ * bytes. The child is started on the first request and reused for every request after
+ * it. A failed exchange (child exited, broken pipe, timeout, malformed frame) kills the
+ * child; the next request starts a new one, at most once per restart interval. The child
+ * talks over anonymous pipes on Windows and a UNIX socket pair elsewhere, so its stderr
+ * stays free for logging.
+ */
+class HelperProcess {
+public:
+    static constexpr uint32_t kMaxFrameBytes = 1u << 20;
+
+    /**
+     * @param command Command line that starts the helper
+     * @param workingDirectory Directory the helper runs in (empty keeps ours)
+     */
+    HelperProcess(std::string command, std::string workingDirectory = "");
+    ~HelperProcess();
+
+    HelperProcess(const HelperProcess&) = delete;
+    HelperProcess& operator=(const HelperProcess&) = delete;
+
+    /**
+     * @brief Send one request and wait for its reply, starting the helper if needed
+     * @param payload Request frame body
+     * @param reply Output reply frame body
+     * @param timeout Longest wait for the reply
+     * @return true if a reply arrived
+     */
+    bool request(const std::string& payload, std::string& reply, std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Stop the helper (it is restarted by the next request)
+     */
+    void stop();
+
+    bool isRunning() const;
+    size_t getStartCount() const { return _startCount; }
+    size_t getRequestCount() const { return _requestCount; }
+    size_t getFailureCount() const { return _failureCount; }
+
+    /**
+     * @brief Helper side: answer frames from stdin on stdout until stdin closes
+     * @param handler Maps a request body to its reply body
+     * @return Process exit code
+     */
+    static int serve(const std::function<std::string(const std::string&)>& handler);
+
+    /**
+     * @brief Encode a frame length as the 4-byte little-endian prefix
+     */
+    static void encodeLength(uint32_t length, unsigned char prefix[4]);
+    static uint32_t decodeLength(const unsigned char prefix[4]);
+
+private:
+    std::string _command;
+    std::string _workingDirectory;
+    std::chrono::milliseconds _restartInterval{1000};
+    std::chrono::steady_clock::time_point _lastStart{};
+    size_t _startCount = 0;
+    size_t _requestCount = 0;
+    size_t _failureCount = 0;
+    mutable std::mutex _mutex;
+
+#ifdef _WIN32
+    HANDLE _process = NULL;
+    HANDLE _toChild = NULL;
+    HANDLE _fromChild = NULL;
+#else
+    pid_t _pid = -1;
+    int _socket = -1;
+#endif
+
+    bool start();
+    void kill();
+    bool writeAll(const char* data, size_t size);
+    bool readAll(char* data, size_t size, std::chrono::steady_clock::time_point deadline);
+};
@@ -0,0 +1,77 @@
+#include "InputBatch.h"
+#include <algorithm>
+
+InputBatch::InputBatch(std::chrono::milliseconds keyPacing) {
+    setKeyPacing(keyPacing);
+}
+
+void InputBatch::setKeyPacing(std::chrono::milliseconds keyPacing) {
+    _keyPacingMs = static_cast<uint16_t>(std::clamp<int64_t>(keyPacing.count(), 0, 1000));
+}
+
+void InputBatch::add(int vk, bool keyUp, bool paced) {
+    InputEvent event;
+    event.vk = static_cast<uint16_t>(vk);
+    event.keyUp = keyUp;
+    event.pauseAfterMs = paced ? _keyPacingMs : 0;
+    _events.push_back(event);
+}
+
+void InputBatch::addModifiers(int modifiers, bool keyUp) {
+    // Press Ctrl, Alt, Shift; release in reverse
+    if (!keyUp) {
+        if (modifiers & MOD_CONTROL) add(VK_CONTROL, false, false);
+        if (modifiers & MOD_ALT)     add(VK_MENU, false, false);
+        if (modifiers & MOD_SHIFT)   add(VK_SHIFT, false, false);
+    } else {
+        if (modifiers & MOD_SHIFT)   add(VK_SHIFT, true, false);
+        if (modifiers & MOD_ALT)     add(VK_MENU, true, false);
+        if (modifiers & MOD_CONTROL) add(VK_CONTROL, true, false);
+    }
+}
+
+void InputBatch::addKeystroke(int vk, int modifiers) {
+    addModifiers(modifiers, false);
+    add(vk, false, true); // Hold the key for one pacing interval
+    add(vk, true, false);
+    addModifiers(modifiers, true);
+}
+
+void InputBatch::addChord(const std::vector<int>& keys, int modifiers, bool pressTogether) {
+    addModifiers(modifiers, false);
+    for (int vk : keys) {
+        add(vk, false, !pressTogether);
+    }
+    for (auto it = keys.rbegin(); it != keys.rend(); ++it) {
+        add(*it, true, !pressTogether);
+    }
+    addModifiers(modifiers, true);
+}
+
+size_t InputBatch::addText(std::string_view text) {
+    size_t skipped = 0;
+    _events.reserve(_events.size() + text.size() * 2);
+    for (char c : text) {
+        int vk = charToVirtualKey(c);
+        if (vk == 0) {
+            ++skipped;
+            continue;
+        }
+        add(vk, false, true);
+        add(vk, true, true);
+    }
+    return skipped;
+}
+
+size_t InputBatch::getRunCount() const {
+    size_t runs = 0;
+    bool open = false;
+    for (const auto& event : _events) {
+        open = true;
+        if (event.pauseAfterMs > 0) {
+            ++runs;
+            open = false;
+        }
+    }
+    return runs + (open ? 1 : 0);
+}
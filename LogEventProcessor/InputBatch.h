@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "KeyCodes.h"
+
+/**
+ * @struct InputEvent
+ * @brief One key transition in an InputBatch
+ */
+struct InputEvent {
+    uint16_t vk = 0;           // Virtual key code (KeyCodes.h)
+    bool keyUp = false;
+    uint16_t pauseAfterMs = 0; // Wait this long after the event before sending the rest (0 = none)
+};
+
+/**
+ * @class InputBatch
+ * @brief Builds the key-down/key-up events for keystrokes, chords and text as one array.
+ *
+ * The builder is platform-independent; a backend (ActionSender on Win32) submits each
+ * unpaced run of events with a single injection call. With key pacing at zero a whole
+ * string is one run. A non-zero pacing marks the points where the old per-key sender slept
+ * (holding a key down, and between typed characters), for clients that drop keys sent
+ * back to back.
+ */
+class InputBatch {
+public:
+    /**
+     * @param keyPacing Pause inserted at each pacing point (zero sends everything at once)
+     */
+    explicit InputBatch(std::chrono::milliseconds keyPacing = std::chrono::milliseconds(0));
+
+    void setKeyPacing(std::chrono::milliseconds keyPacing);
+    std::chrono::milliseconds getKeyPacing() const { return std::chrono::milliseconds(_keyPacingMs); }
+
+    /**
+     * @brief Drop all events, keeping capacity for reuse
+     */
+    void clear() { _events.clear(); }
+
+    /**
+     * @brief Add modifiers down, key down and up, modifiers up
+     * @param vk Virtual key code
+     * @param modifiers MOD_CONTROL, MOD_ALT and MOD_SHIFT combined with |
+     */
+    void addKeystroke(int vk, int modifiers = 0);
+
+    /**
+     * @brief Add modifiers down, each key down in order, keys up in reverse, modifiers up
+     * @param pressTogether Never pace between the keys, even with pacing set
+     */
+    void addChord(const std::vector<int>& keys, int modifiers = 0, bool pressTogether = false);
+
+    /**
+     * @brief Add a press and release for every character that has a key
+     * @return Number of characters skipped because they have no key
+     */
+    size_t addText(std::string_view text);
+
+    const std::vector<InputEvent>& getEvents() const { return _events; }
+    size_t size() const { return _events.size(); }
+    bool empty() const { return _events.empty(); }
+
+    /**
+     * @brief Get the number of separate submissions a backend needs for this batch
+     */
+    size_t getRunCount() const;
+
+private:
+    uint16_t _keyPacingMs = 0;
+    std::vector<InputEvent> _events;
+
+    void add(int vk, bool keyUp, bool paced);
+    void addModifiers(int modifiers, bool keyUp);
+};
@@ -0,0 +1,108 @@
+#include "KeyCodes.h"
+#include <array>
+#include <cstdint>
+
+namespace {
+
+struct KeyName {
+    std::string_view name;
+    int vk;
+    int modifier;
+};
+
+constexpr KeyName kKeyNames[] = {
+    { "ctrl", 0, MOD_CONTROL }, { "control", 0, MOD_CONTROL }, { "alt", 0, MOD_ALT }, { "shift", 0, MOD_SHIFT },
+    { "f1", VK_F1, 0 }, { "f2", VK_F2, 0 }, { "f3", VK_F3, 0 }, { "f4", VK_F4, 0 },
+    { "f5", VK_F5, 0 }, { "f6", VK_F6, 0 }, { "f7", VK_F7, 0 }, { "f8", VK_F8, 0 },
+    { "f9", VK_F9, 0 }, { "f10", VK_F10, 0 }, { "f11", VK_F11, 0 }, { "f12", VK_F12, 0 },
+    { "enter", VK_RETURN, 0 }, { "return", VK_RETURN, 0 }, { "space", VK_SPACE, 0 }, { "tab", VK_TAB, 0 },
+    { "escape", VK_ESCAPE, 0 }, { "esc", VK_ESCAPE, 0 }, { "backspace", VK_BACK, 0 }, { "delete", VK_DELETE, 0 },
+    { "insert", VK_INSERT, 0 }, { "home", VK_HOME, 0 }, { "end", VK_END, 0 }, { "pageup", VK_PRIOR, 0 },
+    { "pagedown", VK_NEXT, 0 }, { "up", VK_UP, 0 }, { "down", VK_DOWN, 0 }, { "left", VK_LEFT, 0 },
+    { "right", VK_RIGHT, 0 },
+    { "a", 'A', 0 }, { "b", 'B', 0 }, { "c", 'C', 0 }, { "d", 'D', 0 }, { "e", 'E', 0 }, { "f", 'F', 0 },
+    { "g", 'G', 0 }, { "h", 'H', 0 }, { "i", 'I', 0 }, { "j", 'J', 0 }, { "k", 'K', 0 }, { "l", 'L', 0 },
+    { "m", 'M', 0 }, { "n", 'N', 0 }, { "o", 'O', 0 }, { "p", 'P', 0 }, { "q", 'Q', 0 }, { "r", 'R', 0 },
+    { "s", 'S', 0 }, { "t", 'T', 0 }, { "u", 'U', 0 }, { "v", 'V', 0 }, { "w", 'W', 0 }, { "x", 'X', 0 },
+    { "y", 'Y', 0 }, { "z", 'Z', 0 },
+    { "0", '0', 0 }, { "1", '1', 0 }, { "2", '2', 0 }, { "3", '3', 0 }, { "4", '4', 0 },
+    { "5", '5', 0 }, { "6", '6', 0 }, { "7", '7', 0 }, { "8", '8', 0 }, { "9", '9', 0 },
+};
+
+constexpr size_t kTableSize = 256; // Power of two, well above the name count so a seed is found quickly
+constexpr uint8_t kEmpty = 0xFF;
+
+inline uint32_t hashName(std::string_view name, uint32_t seed) {
+    uint32_t h = seed ^ static_cast<uint32_t>(name.size());
+    for (unsigned char c : name) {
+        h = (h ^ c) * 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+struct PerfectTable {
+    uint32_t seed = 0;
+    std::array<uint8_t, kTableSize> slots{};
+
+    PerfectTable() {
+        // Try seeds until every name lands in its own slot
+        for (uint32_t candidate = 2166136261u; ; candidate += 0x9e3779b9u) {
+            slots.fill(kEmpty);
+            bool collision = false;
+            for (size_t i = 0; i < sizeof(kKeyNames) / sizeof(kKeyNames[0]) && !collision; ++i) {
+                uint8_t& slot = slots[hashName(kKeyNames[i].name, candidate) & (kTableSize - 1)];
+                collision = slot != kEmpty;
+                slot = static_cast<uint8_t>(i);
+            }
+            if (!collision) {
+                seed = candidate;
+                return;
+            }
+        }
+    }
+};
+
+} // namespace
+
+bool lookupKeyName(std::string_view name, int& vk, int& modifier) {
+    static const PerfectTable table;
+    uint8_t index = table.slots[hashName(name, table.seed) & (kTableSize - 1)];
+    if (index == kEmpty || kKeyNames[index].name != name) {
+        return false;
+    }
+    vk = kKeyNames[index].vk;
+    modifier = kKeyNames[index].modifier;
+    return true;
+}
+
+int charToVirtualKey(char c) {
+    if (c >= 'A' && c <= 'Z') {
+        return c;
+    }
+    if (c >= 'a' && c <= 'z') {
+        return c - 32; // Convert to uppercase
+    }
+    if (c >= '0' && c <= '9') {
+        return c;
+    }
+
+    // Special characters
+    switch (c) {
+        case ' ': return VK_SPACE;
+        case '\t': return VK_TAB;
+        case '\r':
+        case '\n': return VK_RETURN;
+        case '.': return VK_DECIMAL;
+        case ',': return VK_OEM_COMMA;
+        case ';': return VK_OEM_1;
+        case '/': return VK_OEM_2;
+        case '`': return VK_OEM_3;
+        case '[': return VK_OEM_4;
+        case '\\': return VK_OEM_5;
+        case ']': return VK_OEM_6;
+        case '\'': return VK_OEM_7;
+        case '-': return VK_OEM_MINUS;
+        case '=': return VK_OEM_PLUS;
+        default: return 0;
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+/**
+ * @file KeyCodes.h
+ * @brief Virtual key codes and modifier flags used by actions, on every platform.
+ *
+ * On Windows these come from <windows.h>. Elsewhere (headless benchmark hosts) the same
+ * numeric values are defined here, so parsed actions are identical on both.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+
+// Modifier flags (RegisterHotKey values)
+#define MOD_ALT     0x0001
+#define MOD_CONTROL 0x0002
+#define MOD_SHIFT   0x0004
+
+#define VK_BACK     0x08
+#define VK_TAB      0x09
+#define VK_RETURN   0x0D
+#define VK_SHIFT    0x10
+#define VK_CONTROL  0x11
+#define VK_MENU     0x12
+#define VK_ESCAPE   0x1B
+#define VK_SPACE    0x20
+#define VK_PRIOR    0x21
+#define VK_NEXT     0x22
+#define VK_END      0x23
+#define VK_HOME     0x24
+#define VK_LEFT     0x25
+#define VK_UP       0x26
+#define VK_RIGHT    0x27
+#define VK_DOWN     0x28
+#define VK_INSERT   0x2D
+#define VK_DELETE   0x2E
+#define VK_F1       0x70
+#define VK_F2       0x71
+#define VK_F3       0x72
+#define VK_F4       0x73
+#define VK_F5       0x74
+#define VK_F6       0x75
+#define VK_F7       0x76
+#define VK_F8       0x77
+#define VK_F9       0x78
+#define VK_F10      0x79
+#define VK_F11      0x7A
+#define VK_F12      0x7B
+#define VK_DECIMAL  0x6E
+#define VK_OEM_1      0xBA
+#define VK_OEM_PLUS   0xBB
+#define VK_OEM_COMMA  0xBC
+#define VK_OEM_MINUS  0xBD
+#define VK_OEM_2      0xBF
+#define VK_OEM_3      0xC0
+#define VK_OEM_4      0xDB
+#define VK_OEM_5      0xDC
+#define VK_OEM_6      0xDD
+#define VK_OEM_7      0xDE
+
+#endif
+
+#include <string_view>
+
+/**
+ * @brief Resolve a lowercase key name from action values ("f1", "enter", "a", "ctrl", ...)
+ *
+ * Uses a collision-free hash table built once on first use: one hash, one slot, one compare.
+ * @param name Lowercase key name without spaces
+ * @param vk Output virtual key code (0 for modifier names)
+ * @param modifier Output MOD_* flag for "ctrl"/"control"/"alt"/"shift" (0 otherwise)
+ * @return true if the name is known
+ */
+bool lookupKeyName(std::string_view name, int& vk, int& modifier);
+
+/**
+ * @brief Map a typed character to the virtual key that produces it (letters map unshifted)
+ * @return Virtual key code, or 0 if the character has no key
+ */
+int charToVirtualKey(char c);
@@ -0,0 +1,149 @@
+#include "LogChannel.h"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+struct SpeechForm {
+    std::string_view suffix; // Text between the speaker and ", '"
+    LogChannel channel;
+};
+
+// Checked against the text before the first ", '"; the speaker is whatever precedes the suffix
+constexpr SpeechForm kSpeechForms[] = {
+    { " tells you", LogChannel::Tell },
+    { " tells the group", LogChannel::Group },
+    { " tell your party", LogChannel::Group },
+    { " tells the raid", LogChannel::Group },
+    { " tell your raid", LogChannel::Group },
+    { " tells the guild", LogChannel::Guild },
+    { " say to your guild", LogChannel::Guild },
+    { " says out of character", LogChannel::Chat },
+    { " say out of character", LogChannel::Chat },
+    { " says", LogChannel::Say },
+    { " say", LogChannel::Say },
+    { " shouts", LogChannel::Chat },
+    { " shout", LogChannel::Chat },
+    { " auctions", LogChannel::Chat },
+    { " auction", LogChannel::Chat },
+};
+
+// Any of these in the body marks a combat line
+constexpr std::string_view kCombatMarkers[] = {
+    " points of damage",
+    " point of damage",
+    " tries to ",
+    "You have been slain",
+    " has been slain by ",
+    " was hit by non-melee",
+    "You have taken ",
+    " has taken ",
+};
+
+// Longest speaker prefix the speech check scans before giving up
+constexpr size_t kMaxSpeechPrefix = 96;
+
+bool endsWith(std::string_view text, std::string_view suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+size_t logBodyOffset(std::string_view line) {
+    // EQ lines start with "[Sun Oct 18 12:00:00 2026] "
+    if (!line.empty() && line[0] == '[') {
+        size_t close = line.substr(0, 40).find("] ");
+        if (close != std::string_view::npos) {
+            return close + 2;
+        }
+    }
+    return 0;
+}
+
+ChannelInfo classifyLogLine(std::string_view line) {
+    ChannelInfo info;
+    info.bodyOffset = logBodyOffset(line);
+    std::string_view body = line.substr(info.bodyOffset);
+
+    size_t quote = body.substr(0, kMaxSpeechPrefix).find(", '");
+    if (quote != std::string_view::npos) {
+        std::string_view prefix = body.substr(0, quote);
+        if (prefix.compare(0, 9, "You told ") == 0) {
+            info.channel = LogChannel::Tell;
+            info.speakerOffset = info.bodyOffset;
+            info.speakerLength = 3;
+            return info;
+        }
+        for (const auto& form : kSpeechForms) {
+            if (endsWith(prefix, form.suffix) && prefix.size() > form.suffix.size()) {
+                info.channel = form.channel;
+                info.speakerOffset = info.bodyOffset;
+                info.speakerLength = prefix.size() - form.suffix.size();
+                return info;
+            }
+        }
+        // Numbered chat channels: "X tells general:2, '...'"
+        size_t tells = prefix.find(" tells ");
+        size_t told = prefix.find(" tell ");
+        size_t verb = std::min(tells, told);
+        if (verb != std::string_view::npos && prefix.find(':', verb) != std::string_view::npos) {
+            info.channel = LogChannel::Chat;
+            info.speakerOffset = info.bodyOffset;
+            info.speakerLength = verb;
+            return info;
+        }
+    }
+
+    for (const auto& marker : kCombatMarkers) {
+        if (body.find(marker) != std::string_view::npos) {
+            info.channel = LogChannel::Combat;
+            return info;
+        }
+    }
+    return info;
+}
+
+const char* logChannelName(LogChannel channel) {
+    switch (channel) {
+        case LogChannel::Tell: return "tell";
+        case LogChannel::Group: return "group";
+        case LogChannel::Guild: return "guild";
+        case LogChannel::Say: return "say";
+        case LogChannel::Chat: return "chat";
+        case LogChannel::Combat: return "combat";
+        case LogChannel::System: return "system";
+    }
+    return "system";
+}
+
+bool parseLogChannels(const std::string& names, uint32_t& mask, std::string& unknown) {
+    mask = 0;
+    bool ok = true;
+    size_t start = 0;
+    while (start <= names.size()) {
+        size_t comma = names.find(',', start);
+        std::string name = names.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t") + 1);
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (!name.empty()) {
+            bool found = false;
+            for (size_t c = 0; c < kLogChannelCount; ++c) {
+                if (name == logChannelName(static_cast<LogChannel>(c))) {
+                    mask |= 1u << c;
+                    found = true;
+                    break;
+                }
+            }
+            if (!found && ok) {
+                unknown = name;
+                ok = false;
+            }
+        }
+        if (comma == std::string::npos) {
+            break;
+        }
+        start = comma + 1;
+    }
+    return ok;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Structural class of an EQ log line
+ */
+enum class LogChannel : uint8_t {
+    Tell,   // "X tells you, '...'", "You told X, '...'"
+    Group,  // Group and raid chat
+    Guild,  // Guild chat
+    Say,    // Local say
+    Chat,   // Other speech: shout, ooc, auction, numbered chat channels
+    Combat, // Melee, spell damage, misses and deaths
+    System  // Everything else
+};
+
+constexpr size_t kLogChannelCount = 7;
+
+/**
+ * @struct ChannelInfo
+ * @brief Channel of a line plus where its speaker and body start
+ */
+struct ChannelInfo {
+    LogChannel channel = LogChannel::System;
+    size_t bodyOffset = 0;    // First byte after the "[timestamp] " prefix
+    size_t speakerOffset = 0; // Speaker span for speech channels (speakerLength 0 otherwise)
+    size_t speakerLength = 0;
+
+    std::string_view speaker(std::string_view line) const { return line.substr(speakerOffset, speakerLength); }
+};
+
+/**
+ * @brief Offset of the text after the "[timestamp] " header (0 if the line has none)
+ */
+size_t logBodyOffset(std::string_view line);
+
+/**
+ * @brief Classify a log line from its first bytes and a few fixed phrases
+ *
+ * Runs a handful of bounded substring checks per line; no regex is involved.
+ * @param line Raw log line
+ * @return Channel, body offset and speaker span
+ */
+ChannelInfo classifyLogLine(std::string_view line);
+
+/**
+ * @brief Get the config name of a channel ("tell", "group", ...)
+ */
+const char* logChannelName(LogChannel channel);
+
+/**
+ * @brief Parse a comma-separated channel list into a bit mask (bit n = channel n)
+ * @param names Channel names, e.g. "tell, group"
+ * @param mask Output mask
+ * @param unknown Output first unknown name, if any
+ * @return true if every name was recognized, false otherwise (mask holds the recognized ones)
+ */
+bool parseLogChannels(const std::string& names, uint32_t& mask, std::string& unknown);
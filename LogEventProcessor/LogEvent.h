@@ -3,6 +3,7 @@
 #include <string>
 #include <chrono>
 #include <memory>
+#include "LogChannel.h"
 
 /**
  * @struct LogEvent
@@ -12,9 +13,11 @@ struct LogEvent {
     std::string data;
     std::chrono::system_clock::time_point timestamp;
     size_t lineNumber;
+    ChannelInfo channelInfo; // Classified once when the event is created
     
     LogEvent(const std::string& logData, size_t lineNum) 
-        : data(logData), lineNumber(lineNum), timestamp(std::chrono::system_clock::now()) {}
+        : data(logData), lineNumber(lineNum), timestamp(std::chrono::system_clock::now()),
+          channelInfo(classifyLogLine(data)) {}
     
     LogEvent() : lineNumber(0), timestamp(std::chrono::system_clock::now()) {}
 };
@@ -0,0 +1,124 @@
+#include "MatchEngine.h"
+
+// MSVC's std::regex throws error_complexity past this many steps instead of backtracking
+// indefinitely; it is compile-time only, so <regex> must not be included by any other source file.
+// The recursion limit (_REGEX_MAX_STACK_COUNT) keeps its default: it guards the thread's real stack.
+#ifndef _REGEX_MAX_COMPLEXITY_COUNT
+#define _REGEX_MAX_COMPLEXITY_COUNT 1000000L
+#endif
+
+#include <regex>
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+class StdRegexPattern : public CompiledPattern {
+public:
+    explicit StdRegexPattern(std::regex re) : _re(std::move(re)) {}
+
+    SearchResult search(std::string_view text, MatchCaptures* captures, size_t maxGroup) const override {
+        try {
+            return searchUnguarded(text, captures, maxGroup) ? SearchResult::Match : SearchResult::NoMatch;
+        } catch (const std::regex_error& e) {
+            if (e.code() == std::regex_constants::error_complexity || e.code() == std::regex_constants::error_stack) {
+                return SearchResult::BudgetExceeded;
+            }
+            return SearchResult::NoMatch;
+        }
+    }
+
+    size_t captureCount() const override { return _re.mark_count(); }
+
+private:
+    std::regex _re;
+
+    bool searchUnguarded(std::string_view text, MatchCaptures* captures, size_t maxGroup) const {
+        const char* begin = text.data();
+        const char* end = text.data() + text.size();
+        if (!captures) {
+            return std::regex_search(begin, end, _re);
+        }
+        std::cmatch matches;
+        if (!std::regex_search(begin, end, matches, _re)) {
+            return false;
+        }
+        // std::regex always tracks every group; only the requested ones are copied out
+        size_t groups = maxGroup < matches.size() ? maxGroup + 1 : matches.size();
+        captures->assign(groups, MatchSpan());
+        for (size_t i = 0; i < groups; ++i) {
+            if (matches[i].matched) {
+                (*captures)[i].offset = static_cast<size_t>(matches[i].first - begin);
+                (*captures)[i].length = static_cast<size_t>(matches[i].length());
+            }
+        }
+        return true;
+    }
+};
+
+class StdRegexEngine : public MatchEngine {
+public:
+    const char* name() const override { return "std"; }
+
+    std::string version() const override {
+        // std::regex behavior is tied to the standard library it was built with
+#if defined(_MSC_VER)
+        return "std msvc " + std::to_string(_MSC_VER);
+#elif defined(__VERSION__)
+        return std::string("std ") + __VERSION__;
+#else
+        return name();
+#endif
+    }
+
+    std::unique_ptr<CompiledPattern> compile(const std::string& pattern, bool caseInsensitive,
+                                             std::string& error) const override {
+        auto flags = std::regex_constants::ECMAScript | std::regex_constants::optimize;
+        if (caseInsensitive) {
+            flags |= std::regex_constants::icase;
+        }
+        try {
+            return std::make_unique<StdRegexPattern>(std::regex(pattern, flags));
+        } catch (const std::regex_error& e) {
+            error = e.what();
+            return nullptr;
+        }
+    }
+};
+
+} // namespace
+
+const MatchEngine& defaultMatchEngine() {
+    static const StdRegexEngine engine;
+    return engine;
+}
+
+const MatchEngine* findMatchEngine(const std::string& name) {
+    std::string key = name;
+    std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+    if (key.empty() || key == "std" || key == "std::regex") {
+        return &defaultMatchEngine();
+    }
+#ifdef LEP_HAVE_PCRE2
+    if (key == "pcre2" || key == "pcre") {
+        return &pcre2MatchEngine();
+    }
+#endif
+#ifdef LEP_HAVE_RE2
+    if (key == "re2") {
+        return &re2MatchEngine();
+    }
+#endif
+    return nullptr;
+}
+
+std::vector<std::string> availableMatchEngines() {
+    std::vector<std::string> names{ defaultMatchEngine().name() };
+#ifdef LEP_HAVE_PCRE2
+    names.push_back(pcre2MatchEngine().name());
+#endif
+#ifdef LEP_HAVE_RE2
+    names.push_back(re2MatchEngine().name());
+#endif
+    return names;
+}
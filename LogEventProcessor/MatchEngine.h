@@ -0,0 +1,163 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+/**
+ * @struct MatchSpan
+ * @brief Byte range of a capture group inside the searched text
+ */
+struct MatchSpan {
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    size_t offset = npos;
+    size_t length = 0;
+
+    bool matched() const { return offset != npos; }
+    std::string_view view(std::string_view text) const {
+        return matched() ? text.substr(offset, length) : std::string_view();
+    }
+};
+
+/**
+ * @brief Capture spans of a match; index 0 is the whole match
+ */
+using MatchCaptures = std::vector<MatchSpan>;
+
+/**
+ * @brief Outcome of a pattern search
+ */
+enum class SearchResult {
+    NoMatch,
+    Match,
+    BudgetExceeded // The engine gave up after its step budget; callers treat it as no match
+};
+
+/**
+ * @class CompiledPattern
+ * @brief A pattern compiled by a MatchEngine. search() must be safe to call concurrently.
+ */
+class CompiledPattern {
+public:
+    virtual ~CompiledPattern() = default;
+
+    /**
+     * @brief Search for the pattern anywhere in the text
+     * @param text Text to search
+     * @param captures Output capture spans, or nullptr for a match-only search
+     * @param maxGroup Highest capture group to extract; captures is resized to min(maxGroup, captureCount()) + 1.
+     *                 Engines may skip submatch tracking for groups above it.
+     * @return Match, NoMatch, or BudgetExceeded when the search was cut off by the match budget
+     */
+    virtual SearchResult search(std::string_view text, MatchCaptures* captures, size_t maxGroup) const = 0;
+
+    /**
+     * @brief Number of capture groups in the pattern (excluding the whole match)
+     */
+    virtual size_t captureCount() const = 0;
+
+    /**
+     * @brief Group number of a named capture group
+     * @param name Group name
+     * @return Group number, or -1 if the name is unknown or the engine has no named groups
+     */
+    virtual int groupIndex(const std::string& name) const { (void)name; return -1; }
+
+    /**
+     * @brief Limit the backtracking steps a single search may take; call before concurrent searches start
+     * @param steps Step limit (0 = engine default). Engines without a step counter ignore it.
+     */
+    virtual void setMatchBudget(uint64_t steps) { (void)steps; }
+};
+
+/**
+ * @class MatchEngine
+ * @brief Regex backend able to compile patterns into CompiledPattern instances
+ */
+class MatchEngine {
+public:
+    virtual ~MatchEngine() = default;
+
+    /**
+     * @brief Engine name as used in config.yaml ("std", "pcre2", "re2")
+     */
+    virtual const char* name() const = 0;
+
+    /**
+     * @brief Whether the engine backtracks (and so can take exponential time on hostile patterns)
+     */
+    virtual bool backtracks() const { return true; }
+
+    /**
+     * @brief Describe the limit that made a search return BudgetExceeded, for log messages
+     * @param steps Step limit given to setMatchBudget
+     */
+    virtual std::string budgetLimit(uint64_t steps) const {
+        (void)steps;
+        return std::string(name()) + "'s built-in complexity limit";
+    }
+
+    /**
+     * @brief Compile a pattern
+     * @param pattern Regex pattern
+     * @param caseInsensitive Whether matching ignores case
+     * @param error Output error message when compilation fails
+     * @return Compiled pattern or nullptr on error
+     */
+    virtual std::unique_ptr<CompiledPattern> compile(const std::string& pattern, bool caseInsensitive,
+                                                     std::string& error) const = 0;
+
+    /**
+     * @brief Library version string; cached compiled patterns are only reused by the same version
+     */
+    virtual std::string version() const { return name(); }
+
+    /**
+     * @brief Serialize a pattern compiled by this engine for the on-disk rule cache
+     * @param pattern Pattern returned by this engine's compile()
+     * @param out Output bytes
+     * @return true if the engine has a serialized form, false otherwise (the rule is recompiled on load)
+     */
+    virtual bool serialize(const CompiledPattern& pattern, std::string& out) const {
+        (void)pattern; (void)out;
+        return false;
+    }
+
+    /**
+     * @brief Rebuild a pattern from bytes written by serialize()
+     * @param data Serialized bytes (may point into a memory-mapped file)
+     * @return Compiled pattern or nullptr if the bytes cannot be used
+     */
+    virtual std::unique_ptr<CompiledPattern> deserialize(std::string_view data) const {
+        (void)data;
+        return nullptr;
+    }
+};
+
+/**
+ * @brief Look up a compiled-in engine by name
+ * @param name Engine name; empty selects the default engine
+ * @return Engine or nullptr if the engine was not compiled in
+ */
+const MatchEngine* findMatchEngine(const std::string& name);
+
+/**
+ * @brief The default engine (std::regex)
+ */
+const MatchEngine& defaultMatchEngine();
+
+/**
+ * @brief Names of all engines compiled into this build
+ */
+std::vector<std::string> availableMatchEngines();
+
+#ifdef LEP_HAVE_PCRE2
+const MatchEngine& pcre2MatchEngine();
+#endif
+
+#ifdef LEP_HAVE_RE2
+const MatchEngine& re2MatchEngine();
+#endif
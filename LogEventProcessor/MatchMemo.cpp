@@ -0,0 +1,173 @@
+#include "MatchMemo.h"
+#include "RegexMatcher.h"
+#include <cstring>
+
+namespace {
+
+constexpr uint64_t kUnmatchedOffset = 0xFFFFFFFFull;
+
+inline uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+} // namespace
+
+MatchMemo::MatchMemo(size_t entries) : _sets(1) {
+    while (_sets * kWays < entries) {
+        _sets <<= 1;
+    }
+    _entries.reset(new Entry[_sets * kWays]);
+}
+
+MatchMemo::~MatchMemo() {
+}
+
+uint64_t MatchMemo::hashBody(std::string_view body, uint32_t channel) {
+    // Eight bytes per step; lines are short, so this beats a byte-wise hash by a wide margin
+    uint64_t h = 0x9e3779b97f4a7c15ull ^ (body.size() * 0x100000001b3ull) ^ channel;
+    const char* p = body.data();
+    size_t n = body.size();
+    while (n >= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        h = (h ^ mix(word)) * 0x9e3779b97f4a7c15ull;
+        p += 8;
+        n -= 8;
+    }
+    if (n > 0) {
+        uint64_t word = 0;
+        std::memcpy(&word, p, n);
+        h = (h ^ mix(word ^ n)) * 0x9e3779b97f4a7c15ull;
+    }
+    return mix(h);
+}
+
+bool MatchMemo::shouldProbe() {
+    if (_bypassRemaining.load(std::memory_order_relaxed) > 0) {
+        _bypassRemaining.fetch_sub(1, std::memory_order_relaxed);
+        _bypassed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void MatchMemo::recordLookup(bool hit) {
+    _lookups.fetch_add(1, std::memory_order_relaxed);
+    if (hit) {
+        _hits.fetch_add(1, std::memory_order_relaxed);
+        _windowHits.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (_windowLookups.fetch_add(1, std::memory_order_relaxed) + 1 == kWindowLookups) {
+        size_t windowHits = _windowHits.exchange(0, std::memory_order_relaxed);
+        _windowLookups.store(0, std::memory_order_relaxed);
+        if (windowHits < kMinHitsPerWindow) {
+            _bypassRemaining.store(kBypassLines, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool MatchMemo::lookup(uint64_t key, uint64_t generation, size_t bodyOffset, std::vector<RuleMatch>& out) {
+    Entry* set = &_entries[(key & (_sets - 1)) * kWays];
+    for (size_t way = 0; way < kWays; ++way) {
+        Entry& entry = set[way];
+        uint32_t before = entry.sequence.load(std::memory_order_acquire);
+        if ((before & 1) != 0 ||
+            entry.words[0].load(std::memory_order_relaxed) != key ||
+            entry.words[1].load(std::memory_order_relaxed) != generation) {
+            continue;
+        }
+        uint64_t words[kWords];
+        for (size_t w = 2; w < kWords; ++w) {
+            words[w] = entry.words[w].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.sequence.load(std::memory_order_relaxed) != before) {
+            continue;
+        }
+
+        size_t matchCount = static_cast<size_t>(words[2] & 0xFF);
+        out.resize(matchCount);
+        size_t w = 3;
+        for (size_t m = 0; m < matchCount; ++m) {
+            out[m].index = static_cast<size_t>(words[w] & 0xFFFFFFFFull);
+            size_t spans = static_cast<size_t>(words[w] >> 32);
+            ++w;
+            out[m].captures.resize(spans);
+            for (size_t s = 0; s < spans; ++s, ++w) {
+                uint64_t offset = words[w] >> 32;
+                out[m].captures[s].offset = offset == kUnmatchedOffset ? MatchSpan::npos : static_cast<size_t>(offset) + bodyOffset;
+                out[m].captures[s].length = static_cast<size_t>(words[w] & 0xFFFFFFFFull);
+            }
+        }
+        entry.lastUse.store(_clock.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+        recordLookup(true);
+        return true;
+    }
+    recordLookup(false);
+    return false;
+}
+
+void MatchMemo::store(uint64_t key, uint64_t generation, size_t bodyOffset, const std::vector<RuleMatch>& matches) {
+    // Encode first so an uncacheable result never claims an entry
+    uint64_t words[kWords] = {};
+    words[0] = key;
+    words[1] = generation;
+    if (matches.size() > 0xFF) {
+        return;
+    }
+    words[2] = matches.size();
+    size_t w = 3;
+    for (const auto& match : matches) {
+        if (w + 1 + match.captures.size() > kWords || match.index > 0xFFFFFFFFull) {
+            return;
+        }
+        words[w++] = static_cast<uint64_t>(match.index) | (static_cast<uint64_t>(match.captures.size()) << 32);
+        for (const auto& span : match.captures) {
+            uint64_t offset = kUnmatchedOffset;
+            if (span.matched()) {
+                // A span in the timestamp header would not carry over to another line with the same body
+                if (span.offset < bodyOffset || span.offset - bodyOffset >= kUnmatchedOffset || span.length > 0xFFFFFFFFull) {
+                    return;
+                }
+                offset = span.offset - bodyOffset;
+            }
+            words[w++] = (offset << 32) | static_cast<uint64_t>(span.matched() ? span.length : 0);
+        }
+    }
+
+    Entry* set = &_entries[(key & (_sets - 1)) * kWays];
+    Entry* victim = &set[0];
+    for (size_t way = 0; way < kWays; ++way) {
+        if (set[way].words[0].load(std::memory_order_relaxed) == key) {
+            victim = &set[way];
+            break;
+        }
+        if (static_cast<int32_t>(set[way].lastUse.load(std::memory_order_relaxed) -
+                                 victim->lastUse.load(std::memory_order_relaxed)) < 0) {
+            victim = &set[way];
+        }
+    }
+
+    uint32_t sequence = victim->sequence.load(std::memory_order_relaxed);
+    if ((sequence & 1) != 0 ||
+        !victim->sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire)) {
+        return; // Another writer owns the entry; caching is best effort
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < w; ++i) {
+        victim->words[i].store(words[i], std::memory_order_relaxed);
+    }
+    victim->lastUse.store(_clock.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+    victim->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void MatchMemo::getStats(size_t& hits, size_t& lookups, size_t& bypassed) const {
+    hits = _hits.load(std::memory_order_relaxed);
+    lookups = _lookups.load(std::memory_order_relaxed);
+    bypassed = _bypassed.load(std::memory_order_relaxed);
+}
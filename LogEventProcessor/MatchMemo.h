@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+struct RuleMatch;
+
+/**
+ * @class MatchMemo
+ * @brief Lock-free cache of match results for repeated log lines.
+ *
+ * Keyed by a 64-bit hash of the line body (the text after the timestamp) and its channel; an
+ * entry holds the matched rule indexes and their capture spans relative to the body. Entries
+ * carry the rule-set generation they were computed under, so bumping the generation
+ * invalidates them all at once.
+ *
+ * The table is 2-way set-associative. Each entry is a seqlock: a writer claims it by making
+ * the sequence odd and skips caching if another writer holds it; a reader that sees the
+ * sequence change treats the read as a miss. Results with too many matches or spans to fit
+ * an entry are not cached.
+ *
+ * When the hit rate over a window of lookups is low, lookups are bypassed for a while so
+ * a log without repeats pays for neither hashing nor stores.
+ */
+class MatchMemo {
+public:
+    /**
+     * @param entries Number of entries (rounded up to a power of two, at least 2)
+     */
+    explicit MatchMemo(size_t entries);
+    ~MatchMemo();
+
+    MatchMemo(const MatchMemo&) = delete;
+    MatchMemo& operator=(const MatchMemo&) = delete;
+
+    /**
+     * @brief Hash a line body for lookup and store
+     * @param body Text after the timestamp header
+     * @param channel Line channel, mixed into the key
+     */
+    static uint64_t hashBody(std::string_view body, uint32_t channel);
+
+    /**
+     * @brief Decide whether this line should use the cache (false while bypassing after a low hit rate)
+     */
+    bool shouldProbe();
+
+    /**
+     * @brief Look up a line's matches
+     * @param key hashBody of the line
+     * @param generation Current rule-set generation
+     * @param bodyOffset Offset of the body in this line, added back to the cached spans
+     * @param out Output matches in config order (filled on a hit)
+     * @return true on a hit
+     */
+    bool lookup(uint64_t key, uint64_t generation, size_t bodyOffset, std::vector<RuleMatch>& out);
+
+    /**
+     * @brief Cache a line's matches
+     * @param key hashBody of the line
+     * @param generation Rule-set generation read before the line was matched
+     * @param bodyOffset Offset of the body in this line; spans starting before it are not cacheable
+     * @param matches Matches in config order
+     */
+    void store(uint64_t key, uint64_t generation, size_t bodyOffset, const std::vector<RuleMatch>& matches);
+
+    /**
+     * @brief Get lookup statistics
+     * @param hits Output lookups answered from the cache
+     * @param lookups Output lookups made
+     * @param bypassed Output lines that skipped the cache because of a low hit rate
+     */
+    void getStats(size_t& hits, size_t& lookups, size_t& bypassed) const;
+
+    size_t capacity() const { return _sets * kWays; }
+
+private:
+    static constexpr size_t kWays = 2;
+    static constexpr size_t kWords = 16; // key, generation, count word, then rule and span words
+
+    struct alignas(64) Entry {
+        std::atomic<uint32_t> sequence{0};  // Odd while a writer is filling the entry
+        std::atomic<uint32_t> lastUse{0};   // Replacement stamp; the older way of a set is evicted
+        std::atomic<uint64_t> words[kWords] = {};
+    };
+
+    std::unique_ptr<Entry[]> _entries;
+    size_t _sets;
+    std::atomic<uint32_t> _clock{0};
+
+    std::atomic<size_t> _hits{0};
+    std::atomic<size_t> _lookups{0};
+    std::atomic<size_t> _bypassed{0};
+    std::atomic<size_t> _windowHits{0};
+    std::atomic<size_t> _windowLookups{0};
+    std::atomic<int64_t> _bypassRemaining{0};
+
+    // Each window of lookups below the minimum hit rate bypasses the cache for kBypassLines lines
+    static constexpr size_t kWindowLookups = 4096;
+    static constexpr size_t kMinHitsPerWindow = kWindowLookups / 16;
+    static constexpr int64_t kBypassLines = 65536;
+
+    void recordLookup(bool hit);
+};
@@ -0,0 +1,268 @@
+#include "PatternLint.h"
+#include <cctype>
+
+namespace {
+
+// One open group while scanning the pattern
+struct GroupFrame {
+    size_t offset = 0;            // Offset of '('
+    bool atomic = false;          // (?> ... ) never backtracks into itself
+    bool repeatInside = false;    // Some element inside repeats a varying number of times
+    bool alternation = false;
+    bool atBranchStart = true;
+    std::vector<std::string> branchHeads; // First atom of each branch
+};
+
+// The atom a quantifier would apply to
+struct Atom {
+    bool valid = false;
+    bool isGroup = false;
+    GroupFrame group;             // Closed group when isGroup
+    size_t offset = 0;
+};
+
+bool isBroadHead(const std::string& head) {
+    return head == "." || head == "\\w" || head == "\\W" || head == "\\S" || head == "\\D" ||
+           head == "\\s" || head == "\\d" || head.rfind("[", 0) == 0;
+}
+
+bool headsOverlap(const std::vector<std::string>& heads) {
+    for (size_t a = 0; a < heads.size(); ++a) {
+        for (size_t b = a + 1; b < heads.size(); ++b) {
+            if (heads[a].empty() || heads[b].empty()) continue;
+            if (heads[a] == heads[b] || isBroadHead(heads[a]) || isBroadHead(heads[b])) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Length of the escape starting at pattern[i] == '\\'
+size_t escapeLength(const std::string& pattern, size_t i) {
+    if (i + 1 >= pattern.size()) return 1;
+    char c = pattern[i + 1];
+    if ((c == 'x' || c == 'p' || c == 'P' || c == 'g' || c == 'k') && i + 2 < pattern.size() && pattern[i + 2] == '{') {
+        size_t close = pattern.find('}', i + 3);
+        return close == std::string::npos ? pattern.size() - i : close - i + 1;
+    }
+    return 2;
+}
+
+// Length of the character class starting at pattern[i] == '['
+size_t classLength(const std::string& pattern, size_t i) {
+    size_t j = i + 1;
+    if (j < pattern.size() && pattern[j] == '^') j++;
+    if (j < pattern.size() && pattern[j] == ']') j++; // Leading ']' is literal
+    while (j < pattern.size() && pattern[j] != ']') {
+        if (pattern[j] == '\\') {
+            j += 2;
+        } else if (pattern[j] == '[' && j + 1 < pattern.size() && pattern[j + 1] == ':') {
+            size_t close = pattern.find(":]", j + 2);
+            j = close == std::string::npos ? j + 1 : close + 2;
+        } else {
+            j++;
+        }
+    }
+    return (j < pattern.size() ? j + 1 : pattern.size()) - i;
+}
+
+bool isDateWord(const std::string& word) {
+    static const char* const kWords[] = { "mon", "tue", "wed", "thu", "fri", "sat", "sun",
+                                          "jan", "feb", "mar", "apr", "may", "jun",
+                                          "jul", "aug", "sep", "oct", "nov", "dec" };
+    for (const char* date : kWords) {
+        if (word == date) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+bool mayReadTimestampHeader(const std::string& text, bool literal) {
+    enum class Atom { Other, Digit, Colon };
+    Atom previous = Atom::Other;
+    size_t digitRun = 0;
+    std::string word;
+    for (size_t i = 0; i <= text.size();) {
+        char c = i < text.size() ? text[i] : '\0';
+        if (std::isalpha(static_cast<unsigned char>(c))) {
+            word.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+            previous = Atom::Other;
+            digitRun = 0;
+            ++i;
+            continue;
+        }
+        if (isDateWord(word)) return true;
+        word.clear();
+        if (i == text.size()) break;
+
+        Atom atom = Atom::Other;
+        size_t length = 1;
+        if (literal) {
+            if (c == '[' || c == ']') return true;
+        } else if (c == '\\') {
+            length = escapeLength(text, i);
+            char escaped = i + 1 < text.size() ? text[i + 1] : '\0';
+            if (escaped == '[' || escaped == ']' || escaped == 'A') return true;
+            if (escaped == 'd') atom = Atom::Digit;
+        } else if (c == '[') {
+            length = classLength(text, i);
+            std::string members = text.substr(i, length);
+            if (members.find("0-9") != std::string::npos || members.find("\\d") != std::string::npos) atom = Atom::Digit;
+        } else if (c == '^') {
+            return true; // Outside a class this anchors at the line start, which is the header
+        } else if (c == '{' || c == '+' || c == '*' || c == '?') {
+            // A quantifier repeats the previous atom, so "\d{2}:" still puts digits next to ':'
+            size_t close = c == '{' ? text.find('}', i) : std::string::npos;
+            i = close == std::string::npos ? i + 1 : close + 1;
+            continue;
+        }
+        if (std::isdigit(static_cast<unsigned char>(c))) atom = Atom::Digit;
+        if (c == ':') atom = Atom::Colon;
+
+        if ((atom == Atom::Colon && previous == Atom::Digit) || (atom == Atom::Digit && previous == Atom::Colon)) {
+            return true;
+        }
+        digitRun = atom == Atom::Digit ? digitRun + 1 : 0;
+        if (digitRun >= 4) return true;
+        previous = atom;
+        i += length;
+    }
+    return false;
+}
+
+std::vector<std::string> findBacktrackingHazards(const std::string& pattern) {
+    std::vector<std::string> findings;
+    std::vector<GroupFrame> stack(1); // stack[0] is the whole pattern
+    Atom last;
+
+    auto noteAtom = [&](const std::string& text, size_t offset) {
+        GroupFrame& top = stack.back();
+        if (top.atBranchStart) {
+            top.branchHeads.push_back(text);
+            top.atBranchStart = false;
+        }
+        last = Atom();
+        last.valid = true;
+        last.offset = offset;
+    };
+
+    size_t i = 0;
+    while (i < pattern.size()) {
+        char c = pattern[i];
+        if (c == '\\') {
+            size_t length = escapeLength(pattern, i);
+            noteAtom(pattern.substr(i, length), i);
+            i += length;
+        } else if (c == '[') {
+            size_t length = classLength(pattern, i);
+            noteAtom(pattern.substr(i, length), i);
+            i += length;
+        } else if (c == '(') {
+            GroupFrame frame;
+            frame.offset = i;
+            size_t j = i + 1;
+            if (j < pattern.size() && pattern[j] == '*') {
+                // PCRE verb such as (*UTF); not a group
+                size_t close = pattern.find(')', j);
+                i = close == std::string::npos ? pattern.size() : close + 1;
+                continue;
+            }
+            if (j < pattern.size() && pattern[j] == '?') {
+                j++;
+                if (j < pattern.size() && pattern[j] == '>') {
+                    frame.atomic = true;
+                    j++;
+                } else if (j < pattern.size() && (pattern[j] == ':' || pattern[j] == '=' || pattern[j] == '!')) {
+                    j++;
+                } else if (j < pattern.size() && (pattern[j] == '<' || pattern[j] == 'P')) {
+                    // (?<name>, (?P<name>, (?<=, (?<!
+                    size_t close = pattern.find_first_of(">=!", j + 1);
+                    j = close == std::string::npos ? pattern.size() : close + 1;
+                } else {
+                    // Inline flags: (?i) applies to the enclosing group, (?i:...) opens one
+                    size_t end = pattern.find_first_of(":)", j);
+                    if (end != std::string::npos && pattern[end] == ')') {
+                        i = end + 1;
+                        continue;
+                    }
+                    j = end == std::string::npos ? pattern.size() : end + 1;
+                }
+            }
+            if (stack.back().atBranchStart) {
+                // The group itself is the branch head; its own first atom decides overlap
+                stack.back().branchHeads.push_back(std::string());
+                stack.back().atBranchStart = false;
+            }
+            stack.push_back(frame);
+            last = Atom();
+            i = j;
+        } else if (c == ')') {
+            if (stack.size() > 1) {
+                GroupFrame closed = stack.back();
+                stack.pop_back();
+                if (closed.repeatInside && !closed.atomic) {
+                    stack.back().repeatInside = true;
+                }
+                // A group at the head of a branch overlaps like its own first head
+                GroupFrame& parent = stack.back();
+                if (!parent.branchHeads.empty() && parent.branchHeads.back().empty() && !closed.branchHeads.empty()) {
+                    parent.branchHeads.back() = closed.branchHeads.front();
+                }
+                last = Atom();
+                last.valid = true;
+                last.isGroup = true;
+                last.group = closed;
+                last.offset = closed.offset;
+            }
+            i++;
+        } else if (c == '|') {
+            stack.back().alternation = true;
+            stack.back().atBranchStart = true;
+            last = Atom();
+            i++;
+        } else if (c == '*' || c == '+' || c == '?' || c == '{') {
+            bool unbounded = c == '*' || c == '+';
+            bool variable = unbounded; // Repeats a varying number of times ({1,3} counts, {3} and ? do not)
+            size_t end = i + 1;
+            if (c == '{') {
+                size_t close = pattern.find('}', i);
+                std::string body = close == std::string::npos ? std::string() : pattern.substr(i + 1, close - i - 1);
+                bool isQuantifier = !body.empty() && std::isdigit(static_cast<unsigned char>(body[0]));
+                if (!isQuantifier) {
+                    // Literal '{'
+                    noteAtom("{", i);
+                    i++;
+                    continue;
+                }
+                size_t comma = body.find(',');
+                unbounded = body.back() == ',';
+                variable = comma != std::string::npos && (unbounded || body.substr(0, comma) != body.substr(comma + 1));
+                end = close + 1;
+            }
+            bool possessive = end < pattern.size() && pattern[end] == '+';
+            if (end < pattern.size() && (pattern[end] == '?' || pattern[end] == '+')) end++;
+
+            if (last.valid && unbounded && !possessive && last.isGroup && !last.group.atomic) {
+                std::string group = pattern.substr(last.offset, end - last.offset);
+                if (last.group.repeatInside) {
+                    findings.push_back("nested quantifier '" + group + "' at offset " + std::to_string(last.offset) +
+                                       " can backtrack exponentially");
+                } else if (last.group.alternation && headsOverlap(last.group.branchHeads)) {
+                    findings.push_back("repeated alternation '" + group + "' at offset " + std::to_string(last.offset) +
+                                       " has branches that can match the same text");
+                }
+            }
+            if (last.valid && variable && !possessive) {
+                stack.back().repeatInside = true;
+            }
+            last = Atom();
+            i = end;
+        } else {
+            noteAtom(std::string(1, c), i);
+            i++;
+        }
+    }
+    return findings;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Flag regex constructs that can make a backtracking engine take exponential time.
+ *
+ * Detects quantified groups that themselves contain an unbounded quantifier ("(a+)+", "(\w+\s?)*")
+ * and quantified alternations whose branches can start with the same character ("(a|ab)*", "(\w|\d)+").
+ * Atomic groups and possessive quantifiers are not flagged. The check is conservative: a flagged
+ * pattern is not necessarily exploitable, but an unflagged one has no nested or ambiguous repetition.
+ * @param pattern Regex pattern as written in the configuration
+ * @return One human-readable finding per hazard (empty if none)
+ */
+std::vector<std::string> findBacktrackingHazards(const std::string& pattern);
+
+/**
+ * @brief Check whether a pattern's result can depend on the "[Mon Sep 13 12:52:05 2025] " header.
+ *
+ * Flags an anchor at the start of the line, an escaped bracket, and anything that looks like
+ * part of a timestamp: a digit next to ':', four digits in a row, or a weekday or month name
+ * as a word of its own. Conservative like findBacktrackingHazards: a flagged pattern may
+ * only ever match the body, but an unflagged one cannot tell two headers apart.
+ * @param text Regex pattern, or a plain substring when literal is true
+ * @param literal true when text is matched as-is (a group's gate literal)
+ */
+bool mayReadTimestampHeader(const std::string& text, bool literal);
@@ -0,0 +1,210 @@
+#include "MatchEngine.h"
+#include <algorithm>
+#include <mutex>
+
+#ifdef LEP_HAVE_PCRE2
+
+#define PCRE2_CODE_UNIT_WIDTH 8
+#include <pcre2.h>
+
+namespace {
+
+// Match data is per thread so concurrent workers never share an ovector
+struct ThreadMatchData {
+    pcre2_match_data* data = nullptr;
+    uint32_t pairs = 0;
+
+    ~ThreadMatchData() {
+        if (data) pcre2_match_data_free(data);
+    }
+
+    pcre2_match_data* acquire(uint32_t wantedPairs) {
+        if (!data || pairs < wantedPairs) {
+            if (data) pcre2_match_data_free(data);
+            data = pcre2_match_data_create(wantedPairs, nullptr);
+            pairs = data ? wantedPairs : 0;
+        }
+        return data;
+    }
+};
+
+// JIT stack per thread, since one may not serve two searches at once. Deep but legitimate
+// patterns can outgrow the 32 KB machine-stack default, so it may grow to 1 MB.
+struct ThreadJitStack {
+    pcre2_jit_stack* stack = pcre2_jit_stack_create(32 * 1024, 1024 * 1024, nullptr);
+
+    ~ThreadJitStack() {
+        if (stack) pcre2_jit_stack_free(stack);
+    }
+};
+
+pcre2_jit_stack* threadJitStack(void*) {
+    thread_local ThreadJitStack tls;
+    return tls.stack;
+}
+
+class Pcre2Pattern : public CompiledPattern {
+public:
+    /**
+     * @param code Compiled code (owned)
+     * @param jitNow true to JIT-compile immediately, false to defer it to the first search
+     */
+    Pcre2Pattern(pcre2_code* code, bool jitNow) : _code(code), _jit(false), _captureCount(0) {
+        pcre2_pattern_info(_code, PCRE2_INFO_CAPTURECOUNT, &_captureCount);
+        _matchContext = pcre2_match_context_create(nullptr);
+        if (_matchContext) {
+            pcre2_jit_stack_assign(_matchContext, threadJitStack, nullptr);
+        }
+        if (jitNow) {
+            std::call_once(_jitOnce, [this]() { jitCompile(); });
+        }
+    }
+
+    ~Pcre2Pattern() override {
+        if (_matchContext) pcre2_match_context_free(_matchContext);
+        pcre2_code_free(_code);
+    }
+
+    SearchResult search(std::string_view text, MatchCaptures* captures, size_t maxGroup) const override {
+        std::call_once(_jitOnce, [this]() { jitCompile(); });
+        // The ovector only needs room for the groups the caller will read
+        uint32_t groups = captures ? static_cast<uint32_t>(std::min<size_t>(maxGroup, _captureCount)) + 1 : 1;
+        thread_local ThreadMatchData tls;
+        pcre2_match_data* md = tls.acquire(groups);
+        if (!md) return SearchResult::NoMatch;
+
+        auto subject = reinterpret_cast<PCRE2_SPTR>(text.data());
+        int rc = _jit ? pcre2_jit_match(_code, subject, text.size(), 0, 0, md, _matchContext)
+                      : pcre2_match(_code, subject, text.size(), 0, 0, md, _matchContext);
+        if (rc == PCRE2_ERROR_JIT_STACKLIMIT) {
+            // Out of JIT stack is not out of budget: the interpreter keeps its backtracking
+            // state on the heap and still enforces the match limit
+            rc = pcre2_match(_code, subject, text.size(), 0, PCRE2_NO_JIT, md, _matchContext);
+        }
+        if (rc < 0) {
+            bool overBudget = rc == PCRE2_ERROR_MATCHLIMIT || rc == PCRE2_ERROR_DEPTHLIMIT ||
+                              rc == PCRE2_ERROR_HEAPLIMIT;
+            return overBudget ? SearchResult::BudgetExceeded : SearchResult::NoMatch;
+        }
+        if (captures) {
+            // rc == 0 means the match succeeded but the ovector was too small for every group
+            uint32_t filled = rc == 0 ? groups : std::min<uint32_t>(static_cast<uint32_t>(rc), groups);
+            PCRE2_SIZE* ovector = pcre2_get_ovector_pointer(md);
+            captures->assign(groups, MatchSpan());
+            for (uint32_t i = 0; i < filled; ++i) {
+                if (ovector[2 * i] != PCRE2_UNSET) {
+                    (*captures)[i].offset = ovector[2 * i];
+                    (*captures)[i].length = ovector[2 * i + 1] - ovector[2 * i];
+                }
+            }
+        }
+        return SearchResult::Match;
+    }
+
+    size_t captureCount() const override { return _captureCount; }
+
+    int groupIndex(const std::string& name) const override {
+        int number = pcre2_substring_number_from_name(_code, reinterpret_cast<PCRE2_SPTR>(name.c_str()));
+        return number > 0 ? number : -1;
+    }
+
+    const pcre2_code* code() const { return _code; }
+
+    void setMatchBudget(uint64_t steps) override {
+        if (steps == 0) {
+            return;
+        }
+        if (!_matchContext) {
+            return;
+        }
+        // The match limit counts backtracking steps in both the interpreter and JIT
+        uint32_t limit = steps > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(steps);
+        pcre2_set_match_limit(_matchContext, limit);
+    }
+
+private:
+    pcre2_code* _code;
+    pcre2_match_context* _matchContext = nullptr;
+    mutable bool _jit;
+    mutable std::once_flag _jitOnce;
+    uint32_t _captureCount;
+
+    void jitCompile() const {
+        _jit = pcre2_jit_compile(_code, PCRE2_JIT_COMPLETE) == 0;
+    }
+};
+
+class Pcre2Engine : public MatchEngine {
+public:
+    const char* name() const override { return "pcre2"; }
+
+    std::string budgetLimit(uint64_t steps) const override {
+        std::string limit = steps > 0 ? "the " + std::to_string(steps) + "-step match limit" : "pcre2's default match limit";
+        return limit + " (or its heap limit)";
+    }
+
+    std::unique_ptr<CompiledPattern> compile(const std::string& pattern, bool caseInsensitive,
+                                             std::string& error) const override {
+        int errorCode = 0;
+        PCRE2_SIZE errorOffset = 0;
+        // Byte mode, like std::regex: EverQuest logs are not guaranteed to be valid UTF-8 (names
+        // and chat can be Latin-1), and UTF mode would need every line validated first
+        uint32_t options = 0;
+        if (caseInsensitive) {
+            options |= PCRE2_CASELESS;
+        }
+        pcre2_code* code = pcre2_compile(reinterpret_cast<PCRE2_SPTR>(pattern.c_str()), pattern.size(),
+                                         options, &errorCode, &errorOffset, nullptr);
+        if (!code) {
+            PCRE2_UCHAR buffer[256];
+            pcre2_get_error_message(errorCode, buffer, sizeof(buffer));
+            error = std::string(reinterpret_cast<const char*>(buffer)) + " at offset " + std::to_string(errorOffset);
+            return nullptr;
+        }
+        return std::make_unique<Pcre2Pattern>(code, true);
+    }
+
+    std::string version() const override {
+        char buffer[64] = {0};
+        pcre2_config(PCRE2_CONFIG_VERSION, buffer);
+        return std::string("pcre2 ") + buffer;
+    }
+
+    bool serialize(const CompiledPattern& pattern, std::string& out) const override {
+        const auto* compiled = dynamic_cast<const Pcre2Pattern*>(&pattern);
+        if (!compiled) {
+            return false;
+        }
+        const pcre2_code* codes[] = { compiled->code() };
+        uint8_t* bytes = nullptr;
+        PCRE2_SIZE size = 0;
+        if (pcre2_serialize_encode(codes, 1, &bytes, &size, nullptr) < 0) {
+            return false;
+        }
+        out.assign(reinterpret_cast<const char*>(bytes), size);
+        pcre2_serialize_free(bytes);
+        return true;
+    }
+
+    std::unique_ptr<CompiledPattern> deserialize(std::string_view data) const override {
+        // The bytecode is portable across runs of the same PCRE2 build; JIT code is not, so it is
+        // rebuilt on the rule's first search instead of at load
+        if (data.empty() || pcre2_serialize_get_number_of_codes(reinterpret_cast<const uint8_t*>(data.data())) != 1) {
+            return nullptr;
+        }
+        pcre2_code* code = nullptr;
+        if (pcre2_serialize_decode(&code, 1, reinterpret_cast<const uint8_t*>(data.data()), nullptr) != 1) {
+            return nullptr;
+        }
+        return std::make_unique<Pcre2Pattern>(code, false);
+    }
+};
+
+} // namespace
+
+const MatchEngine& pcre2MatchEngine() {
+    static const Pcre2Engine engine;
+    return engine;
+}
+
+#endif // LEP_HAVE_PCRE2
@@ -0,0 +1,65 @@
+#include "RateLimit.h"
+#include <algorithm>
+#include <cctype>
+
+bool parseRateLimitPolicy(const std::string& text, RateLimitPolicy& policy) {
+    std::string value;
+    for (char c : text) {
+        if (!std::isspace(static_cast<unsigned char>(c))) {
+            value += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+    }
+    if (value == "drop") {
+        policy = RateLimitPolicy::Drop;
+    } else if (value == "coalesce") {
+        policy = RateLimitPolicy::Coalesce;
+    } else if (value == "delay") {
+        policy = RateLimitPolicy::Delay;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void TokenBucket::configure(int perMinute, int burst) {
+    bool wasUnlimited = isUnlimited();
+    _perMinute = std::max(0, perMinute);
+    _burst = std::max(1, burst);
+    _tokens = wasUnlimited ? _burst : std::min(_tokens, _burst);
+}
+
+void TokenBucket::refill(Clock::time_point now) {
+    if (_refilledAt == Clock::time_point{}) {
+        _refilledAt = now;
+        return;
+    }
+    if (now <= _refilledAt) {
+        return;
+    }
+    double minutes = std::chrono::duration<double, std::ratio<60>>(now - _refilledAt).count();
+    _tokens = std::min(_burst, _tokens + minutes * _perMinute);
+    _refilledAt = now;
+}
+
+bool TokenBucket::isAvailable(Clock::time_point now) {
+    if (isUnlimited()) {
+        return true;
+    }
+    refill(now);
+    return _tokens >= 1.0;
+}
+
+void TokenBucket::take() {
+    if (!isUnlimited()) {
+        _tokens -= 1.0;
+    }
+}
+
+TokenBucket::Clock::duration TokenBucket::timeUntilAvailable(Clock::time_point now) {
+    if (isAvailable(now)) {
+        return Clock::duration::zero();
+    }
+    std::chrono::duration<double, std::ratio<60>> wait((1.0 - _tokens) / _perMinute);
+    // Round up so the wake-up finds the token there
+    return std::chrono::duration_cast<Clock::duration>(wait) + std::chrono::milliseconds(1);
+}
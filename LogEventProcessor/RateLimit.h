@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief What happens to a sequence that arrives while its rate limit is exhausted
+ */
+enum class RateLimitPolicy : uint8_t {
+    Drop,     // Discard it
+    Coalesce, // Wait, but keep only the newest waiting sequence of each rule
+    Delay     // Wait in arrival order
+};
+
+/**
+ * @brief Parse "drop", "coalesce" or "delay" (case-insensitive)
+ * @return false (leaving policy unchanged) for anything else
+ */
+bool parseRateLimitPolicy(const std::string& text, RateLimitPolicy& policy);
+
+/**
+ * @struct RateLimitSettings
+ * @brief Token-bucket limits on action sequences started by the scheduler
+ *
+ * A rate of 0 leaves that bucket unlimited. Every action sequence goes to every target
+ * window, so the global bucket is also the limit per window.
+ */
+struct RateLimitSettings {
+    int globalPerMinute = 0;  // Sequences per minute over all rules
+    int globalBurst = 10;     // Sequences the global bucket can start back to back
+    int rulePerMinute = 0;    // Sequences per minute of each rule
+    int ruleBurst = 3;
+    RateLimitPolicy policy = RateLimitPolicy::Delay;
+    std::chrono::milliseconds maxStaleness{3000}; // A waiting sequence whose log line is older than this is dropped
+    size_t maxBacklog = 64;                       // Waiting sequences; the oldest is dropped beyond this
+
+    bool enabled() const { return globalPerMinute > 0 || rulePerMinute > 0; }
+};
+
+/**
+ * @struct RateLimitStats
+ * @brief Counters of sequences held back by rate limits
+ */
+struct RateLimitStats {
+    size_t delayed = 0;   // Sequences that had to wait for a token
+    size_t dropped = 0;   // Discarded by the drop policy or a full backlog
+    size_t coalesced = 0; // Replaced by a newer sequence of the same rule while waiting
+    size_t expired = 0;   // Waited past maxStaleness
+    size_t backlog = 0;   // Waiting now
+};
+
+/**
+ * @class TokenBucket
+ * @brief Refills at a fixed rate up to its burst size; each admitted sequence takes one token
+ *
+ * Not thread-safe: the action scheduler owns its buckets and only touches them on its thread.
+ */
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Set the rate and burst; the bucket starts (or stays) full up to the new burst
+     * @param perMinute Tokens added per minute (0 = unlimited)
+     * @param burst Bucket size
+     */
+    void configure(int perMinute, int burst);
+
+    bool isUnlimited() const { return _perMinute <= 0; }
+
+    /**
+     * @brief Check whether a token is available at now
+     */
+    bool isAvailable(Clock::time_point now);
+
+    /**
+     * @brief Take a token (call after isAvailable returned true)
+     */
+    void take();
+
+    /**
+     * @brief Time until the next token is available (zero if one is)
+     */
+    Clock::duration timeUntilAvailable(Clock::time_point now);
+
+private:
+    int _perMinute = 0;
+    double _burst = 1.0;
+    double _tokens = 1.0;
+    Clock::time_point _refilledAt{};
+
+    void refill(Clock::time_point now);
+};
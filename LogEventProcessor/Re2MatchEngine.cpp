@@ -0,0 +1,82 @@
+#include "MatchEngine.h"
+#include <algorithm>
+
+#ifdef LEP_HAVE_RE2
+
+#include <re2/re2.h>
+
+namespace {
+
+class Re2Pattern : public CompiledPattern {
+public:
+    explicit Re2Pattern(std::unique_ptr<re2::RE2> re) : _re(std::move(re)) {}
+
+    SearchResult search(std::string_view text, MatchCaptures* captures, size_t maxGroup) const override {
+        // RE2 runs in linear time, so there is no step budget to exceed
+        return searchLinear(text, captures, maxGroup) ? SearchResult::Match : SearchResult::NoMatch;
+    }
+
+    size_t captureCount() const override { return static_cast<size_t>(_re->NumberOfCapturingGroups()); }
+
+    int groupIndex(const std::string& name) const override {
+        const auto& groups = _re->NamedCapturingGroups();
+        auto it = groups.find(name);
+        return it != groups.end() ? it->second : -1;
+    }
+
+private:
+    std::unique_ptr<re2::RE2> _re;
+
+    bool searchLinear(std::string_view text, MatchCaptures* captures, size_t maxGroup) const {
+        re2::StringPiece input(text.data(), text.size());
+        if (!captures) {
+            // No submatches lets RE2 answer from its DFA
+            return _re->Match(input, 0, input.size(), re2::RE2::UNANCHORED, nullptr, 0);
+        }
+        // Fewer submatches let RE2 pick a cheaper engine (one-pass / bit-state) over the NFA
+        const int groups = static_cast<int>(std::min<size_t>(maxGroup, captureCount())) + 1;
+        std::vector<re2::StringPiece> pieces(static_cast<size_t>(groups));
+        if (!_re->Match(input, 0, input.size(), re2::RE2::UNANCHORED, pieces.data(), groups)) {
+            return false;
+        }
+        captures->assign(pieces.size(), MatchSpan());
+        for (size_t i = 0; i < pieces.size(); ++i) {
+            if (pieces[i].data() != nullptr) {
+                (*captures)[i].offset = static_cast<size_t>(pieces[i].data() - text.data());
+                (*captures)[i].length = pieces[i].size();
+            }
+        }
+        return true;
+    }
+};
+
+class Re2Engine : public MatchEngine {
+public:
+    const char* name() const override { return "re2"; }
+
+    bool backtracks() const override { return false; }
+
+    std::unique_ptr<CompiledPattern> compile(const std::string& pattern, bool caseInsensitive,
+                                             std::string& error) const override {
+        re2::RE2::Options options;
+        options.set_log_errors(false);
+        options.set_case_sensitive(!caseInsensitive);
+        // Bytes, like the other engines: a Latin-1 byte in a log line must still match \S or .
+        options.set_encoding(re2::RE2::Options::EncodingLatin1);
+        auto re = std::make_unique<re2::RE2>(pattern, options);
+        if (!re->ok()) {
+            error = re->error();
+            return nullptr;
+        }
+        return std::make_unique<Re2Pattern>(std::move(re));
+    }
+};
+
+} // namespace
+
+const MatchEngine& re2MatchEngine() {
+    static const Re2Engine engine;
+    return engine;
+}
+
+#endif // LEP_HAVE_RE2
@@ -1,10 +1,24 @@
 #include "RegexMatcher.h"
+#include "RuleCache.h"
+#include "PatternLint.h"
+#include "MatchMemo.h"
 #include <iostream>
 #include <algorithm>
+#include <numeric>
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <chrono>
+#include <iomanip>
+#include <ctime>
+#include <thread>
 
-RegexMatcher::RegexMatcher() : _matchCount(0) {
+RegexMatcher::RegexMatcher()
+    : _defaultEngine(&defaultMatchEngine()), _matchCount(0), _adaptiveOrder(false), _firstMatch(false),
+      _matchLimit(kDefaultMatchLimit), _searchBudgetMs(0), _searchBudgetTicks(0), _quarantineStrikes(kDefaultQuarantineStrikes) {
     // Set default action callback
-    _actionCallback = [this](const LogEventPtr& event, const RegexRule& rule, const std::smatch& matches) {
+    _actionCallback = [this](const LogEventPtr& event, const RegexRule& rule, const MatchCaptures& matches) {
         defaultAction(event, rule, matches);
     };
 }
@@ -13,44 +27,163 @@ RegexMatcher::~RegexMatcher() {
 }
 
 void RegexMatcher::addRule(const RegexRule& rule) {
-    _rules.push_back(rule);
-    compilePatterns();
+    addRules(&rule, 1);
 }
 
 void RegexMatcher::addRule(const std::string& name, const std::string& pattern, 
                           const std::string& description, bool enabled) {
-    _rules.emplace_back(name, pattern, description, enabled, 0);
-    compilePatterns();
+    addRule(RegexRule(name, pattern, description, enabled, 0));
 }
 
 void RegexMatcher::addRule(const std::string& name, const std::string& pattern,
                           const std::string& description, bool enabled, int cooldownMs) {
-    _rules.emplace_back(name, pattern, description, enabled, cooldownMs);
-    compilePatterns();
+    addRule(RegexRule(name, pattern, description, enabled, cooldownMs));
 }
 
-bool RegexMatcher::removeRule(const std::string& name) {
-    auto it = std::find_if(_rules.begin(), _rules.end(), 
-                          [&name](const RegexRule& rule) { return rule.name == name; });
+void RegexMatcher::addRules(const RegexRule* rules, size_t count) {
+    if (!rules || count == 0) {
+        return;
+    }
+    size_t first = _rules.size();
+    if (count > 1) {
+        _rules.reserve(first + count);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        _rules.push_back(rules[i]);
+        _rules.back().id = _nextRuleId++;
+        _ruleIndex.emplace(rules[i].name, first + i);
+    }
+    extendRuleLayout(first);
+    compileFrom(first);
+    if (_adaptiveOrder) {
+        updateEvaluationOrder();
+    }
+}
+
+void RegexMatcher::addRules(const std::vector<RegexRule>& rules) {
+    addRules(rules.data(), rules.size());
+}
+
+size_t RegexMatcher::addRulesCached(const std::vector<RegexRule>& rules, const std::string& cachePath) {
+    if (rules.empty()) {
+        return 0;
+    }
+    uint64_t key = RuleCache::computeKey(rules.data(), rules.size(), *_defaultEngine);
+    RuleCache cache;
+    bool hit = cache.open(cachePath, key, rules.size());
     
-    if (it != _rules.end()) {
-        size_t index = std::distance(_rules.begin(), it);
-        _rules.erase(it);
+    size_t first = _rules.size();
+    _rules.reserve(first + rules.size());
+    for (size_t i = 0; i < rules.size(); ++i) {
+        _rules.push_back(rules[i]);
+        _rules.back().id = _nextRuleId++;
+        _ruleIndex.emplace(rules[i].name, first + i);
+    }
+    extendRuleLayout(first);
+    size_t loaded = compileFrom(first, hit ? &cache : nullptr);
+    cache.close();
+    if (_adaptiveOrder) {
+        updateEvaluationOrder();
+    }
+    
+    if (hit) {
+        std::cout << "[CACHE] Loaded " << loaded << " of " << rules.size() << " compiled rules from: " << cachePath << std::endl;
+        return loaded;
+    }
+    
+    std::vector<std::string> engines(rules.size());
+    std::vector<std::string> blobs(rules.size());
+    size_t serialized = 0;
+    for (size_t i = 0; i < rules.size(); ++i) {
+        const CompiledRule& compiled = _compiledPatterns[first + i];
+        if (compiled.pattern) {
+            engines[i] = compiled.engine->name();
+            if (compiled.engine->serialize(*compiled.pattern, blobs[i])) {
+                serialized++;
+            }
+        }
+    }
+    // Nothing to gain from a cache of empty entries (every rule on an engine without a serialized form)
+    if (serialized > 0 && RuleCache::write(cachePath, key, engines, blobs)) {
+        std::cout << "[CACHE] Rebuilt rule cache (" << serialized << " of " << rules.size()
+                  << " patterns serializable): " << cachePath << std::endl;
+    }
+    return 0;
+}
+
+bool RegexMatcher::removeRule(const std::string& name) {
+    size_t index = findRuleIndex(name);
+    if (index < _rules.size()) {
+        _rules.erase(_rules.begin() + index);
         _compiledPatterns.erase(_compiledPatterns.begin() + index);
+        rebuildRuleIndex();
+        rebuildRuleLayout();
         return true;
     }
     return false;
 }
 
 bool RegexMatcher::setRuleEnabled(const std::string& name, bool enabled) {
-    auto it = std::find_if(_rules.begin(), _rules.end(), 
-                          [&name](const RegexRule& rule) { return rule.name == name; });
-    
-    if (it != _rules.end()) {
-        it->enabled = enabled;
+    size_t index = findRuleIndex(name);
+    if (index >= _rules.size()) {
+        return false;
+    }
+    if (!enabled) {
+        std::unique_lock<std::shared_mutex> lock(_patternMutex);
+        if (_rules[index].enabled && index < _compiledPatterns.size()) {
+            _compiledPatterns[index].disabledSince = std::chrono::steady_clock::now();
+        }
+        _rules[index].enabled = false;
+        invalidateMatchMemo();
         return true;
     }
-    return false;
+    
+    // Compile outside the lock so matching continues meanwhile; only the swap is exclusive
+    CompiledRule compiled;
+    bool needsCompile = index < _compiledPatterns.size() && !_compiledPatterns[index].pattern;
+    if (needsCompile) {
+        std::string diagnostics;
+        compiled = compileRule(_rules[index], diagnostics);
+        if (!diagnostics.empty()) {
+            std::cerr << diagnostics;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(_patternMutex);
+    if (needsCompile && !_compiledPatterns[index].pattern) {
+        _compiledPatterns[index].pattern = std::move(compiled.pattern);
+        _compiledPatterns[index].engine = compiled.engine;
+    }
+    _rules[index].enabled = true;
+    invalidateMatchMemo();
+    return true;
+}
+
+size_t RegexMatcher::evictIdleRules(std::chrono::steady_clock::duration idleTime) {
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::unique_ptr<CompiledPattern>> evicted;
+    {
+        std::unique_lock<std::shared_mutex> lock(_patternMutex);
+        for (size_t i = 0; i < _compiledPatterns.size() && i < _rules.size(); ++i) {
+            CompiledRule& compiled = _compiledPatterns[i];
+            if (!_rules[i].enabled && compiled.pattern && now - compiled.disabledSince >= idleTime) {
+                evicted.push_back(std::move(compiled.pattern));
+            }
+        }
+    }
+    // Patterns are freed after the lock is released
+    if (!evicted.empty()) {
+        std::cout << "[RULES] Evicted " << evicted.size() << " idle disabled rules" << std::endl;
+    }
+    return evicted.size();
+}
+
+size_t RegexMatcher::getCompiledRuleCount() const {
+    std::shared_lock<std::shared_mutex> lock(_patternMutex);
+    size_t count = 0;
+    for (const auto& compiled : _compiledPatterns) {
+        if (compiled.pattern) count++;
+    }
+    return count;
 }
 
 bool RegexMatcher::processEvent(const LogEventPtr& event) {
@@ -58,24 +191,823 @@ bool RegexMatcher::processEvent(const LogEventPtr& event) {
         return false;
     }
     
-    bool anyMatch = false;
+    FoldedLine line(event->data);
+    std::vector<RuleMatch> matched;
+    // The callback may read any group, so this path always extracts every capture
+    collectMatches(line, event->channelInfo.channel, matched, true);
     
-    for (size_t i = 0; i < _rules.size(); ++i) {
+    for (const auto& match : matched) {
+        if (_actionCallback) {
+            _actionCallback(event, _rules[match.index], match.captures);
+        }
+        _matchCount++;
+    }
+    
+    return !matched.empty();
+}
+
+size_t RegexMatcher::matchRules(const FoldedLine& line, std::vector<RuleMatch>& out) const {
+    return collectMatches(line, classifyLogLine(line.original()).channel, out, false);
+}
+
+size_t RegexMatcher::matchRules(const FoldedLine& line, LogChannel channel, std::vector<RuleMatch>& out) const {
+    return collectMatches(line, channel, out, false);
+}
+
+size_t RegexMatcher::collectMatches(const FoldedLine& line, LogChannel channel, std::vector<RuleMatch>& out,
+                                    bool allGroups) const {
+    out.clear();
+    std::shared_lock<std::shared_mutex> lock(_patternMutex);
+    auto plans = currentPlans();
+    if (!plans) {
+        return 0;
+    }
+    _channelLines[static_cast<size_t>(channel)].fetch_add(1, std::memory_order_relaxed);
+    
+    // Repeated lines are answered from the memo; the generation is read before matching so a
+    // rule change during the search leaves the stored result already stale
+    MatchMemo* memo = (!allGroups && _memo && !_memoBlocked && _memo->shouldProbe()) ? _memo.get() : nullptr;
+    uint64_t memoKey = 0;
+    uint64_t generation = 0;
+    size_t bodyOffset = 0;
+    size_t searched = 0;
+    thread_local std::vector<uint8_t> gateStates;
+    if (!_groups.empty()) {
+        gateStates.assign(_groups.size(), 0);
+    }
+    if (memo) {
+        bodyOffset = logBodyOffset(line.original());
+        memoKey = MatchMemo::hashBody(line.original().substr(bodyOffset), static_cast<uint32_t>(channel));
+        generation = _generation.load(std::memory_order_acquire);
+        if (memo->lookup(memoKey, generation, bodyOffset, out)) {
+            // Rules that can read the timestamp header are never cached; search them on this line,
+            // except past the segment where a cached stop rule ended the search
+            size_t cached = out.size();
+            uint32_t lastSegment = std::numeric_limits<uint32_t>::max();
+            for (const auto& match : out) {
+                if (stopsProcessing(match.index)) {
+                    lastSegment = std::min(lastSegment, _stopSegments[match.index]);
+                }
+            }
+            for (size_t i : _headerRules) {
+                if (_stopSegments[i] > lastSegment) {
+                    break;
+                }
+                uint32_t channels = _rules[i].channels;
+                if (!_rules[i].enabled || (channels != 0 && !(channels & (1u << static_cast<uint32_t>(channel))))) {
+                    continue;
+                }
+                size_t group = _ruleGroups[i];
+                if (group != kNoGroup && !gatePasses(group, line, gateStates)) {
+                    continue;
+                }
+                int demand = _rules[i].captureDemand;
+                out.emplace_back();
+                searched++;
+                if (searchRule(i, line, out.back().captures, demand < 0 ? MatchSpan::npos : static_cast<size_t>(demand))) {
+                    out.back().index = i;
+                } else {
+                    out.pop_back();
+                }
+            }
+            if (out.size() > cached) {
+                std::sort(out.begin(), out.end(), [](const RuleMatch& a, const RuleMatch& b) { return a.index < b.index; });
+            }
+            _linesSearched.fetch_add(1, std::memory_order_relaxed);
+            _rulesSearched.fetch_add(searched, std::memory_order_relaxed);
+            return out.size();
+        }
+    }
+    // Rules scoped to other channels are not in this plan at all
+    const EvaluationPlan& plan = plans->byChannel[static_cast<size_t>(channel)];
+    const std::vector<size_t>& runEnd = plan.runEnd;
+    size_t count = plan.order.size();
+    // Once a stop rule matches, only the rest of its segment (rules before it in config order) is searched
+    bool stopAfterSegment = false;
+    uint32_t stopSegment = 0;
+    
+    for (size_t n = 0; n < count; ++n) {
+        size_t i = plan.order[n];
+        if (i >= _rules.size()) {
+            continue;
+        }
+        if (stopAfterSegment && _stopSegments[i] != stopSegment) {
+            break;
+        }
+        size_t group = _ruleGroups[i];
+        if (group != kNoGroup && !gatePasses(group, line, gateStates)) {
+            // No rule in this run can match; jump past it
+            n = runEnd[n] - 1;
+            continue;
+        }
         if (!_rules[i].enabled) {
             continue;
         }
-        
-        std::smatch matches;
-        if (std::regex_search(event->data, matches, _compiledPatterns[i])) {
-            if (_actionCallback) {
-                _actionCallback(event, _rules[i], matches);
+        int demand = _rules[i].captureDemand;
+        size_t maxGroup = (allGroups || demand < 0) ? MatchSpan::npos : static_cast<size_t>(demand);
+        out.emplace_back();
+        searched++;
+        if (searchRule(i, line, out.back().captures, maxGroup)) {
+            out.back().index = i;
+            if (stopsProcessing(i)) {
+                stopAfterSegment = true;
+                stopSegment = _stopSegments[i];
+            }
+        } else {
+            out.pop_back();
+        }
+    }
+    _linesSearched.fetch_add(1, std::memory_order_relaxed);
+    _rulesSearched.fetch_add(searched, std::memory_order_relaxed);
+    
+    if (plans->adaptive && out.size() > 1) {
+        // Actions still run in config order whatever order the rules were searched in
+        std::sort(out.begin(), out.end(), [](const RuleMatch& a, const RuleMatch& b) { return a.index < b.index; });
+    }
+    if (memo && _headerRules.empty()) {
+        memo->store(memoKey, generation, bodyOffset, out);
+    } else if (memo) {
+        thread_local std::vector<RuleMatch> bodyMatches;
+        bodyMatches.clear();
+        for (const auto& match : out) {
+            if (!_readsHeader[match.index]) {
+                bodyMatches.push_back(match);
+            }
+        }
+        memo->store(memoKey, generation, bodyOffset, bodyMatches);
+    }
+    return out.size();
+}
+
+bool RegexMatcher::matchRule(size_t index, const FoldedLine& line, MatchCaptures& captures) const {
+    if (index >= _rules.size()) {
+        return false;
+    }
+    int demand = _rules[index].captureDemand;
+    std::shared_lock<std::shared_mutex> lock(_patternMutex);
+    return searchRule(index, line, captures, demand < 0 ? MatchSpan::npos : static_cast<size_t>(demand));
+}
+
+bool RegexMatcher::searchRule(size_t index, const FoldedLine& line, MatchCaptures& captures, size_t maxGroup) const {
+    if (index >= _compiledPatterns.size() || !_compiledPatterns[index].pattern) {
+        return false;
+    }
+    const CompiledRule& compiled = _compiledPatterns[index];
+    SearchCounters& counters = *compiled.counters;
+    if (counters.quarantined.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    size_t evaluation;
+    if (maxGroup == 0) {
+        evaluation = counters.matchOnly.fetch_add(1, std::memory_order_relaxed);
+        captures.clear();
+    } else {
+        evaluation = counters.withCaptures.fetch_add(1, std::memory_order_relaxed);
+    }
+    MatchCaptures* out = maxGroup == 0 ? nullptr : &captures;
+    
+    SearchResult result;
+    uint64_t ticks = 0;
+    if (LEP_RULE_STATS || evaluation % kProfileSampleInterval == 0) {
+        uint64_t start = ruleClockTicks();
+        result = compiled.pattern->search(line.folded(), out, maxGroup);
+        ticks = ruleClockTicks() - start;
+        counters.timedTicks.fetch_add(ticks, std::memory_order_relaxed);
+#if LEP_RULE_STATS
+        uint64_t slowest = counters.maxTicks.load(std::memory_order_relaxed);
+        while (ticks > slowest &&
+               !counters.maxTicks.compare_exchange_weak(slowest, ticks, std::memory_order_relaxed)) {
+        }
+#else
+        counters.timedSamples.fetch_add(1, std::memory_order_relaxed);
+#endif
+    } else {
+        result = compiled.pattern->search(line.folded(), out, maxGroup);
+    }
+    
+    if (result == SearchResult::BudgetExceeded) {
+        const MatchEngine* engine = _compiledPatterns[index].engine;
+        recordBudgetStrike(index, "search hit " + (engine ? engine->budgetLimit(_matchLimit) : std::string("the match limit")));
+    } else if (_searchBudgetTicks > 0 && ticks > _searchBudgetTicks) {
+        // A preempted or suspended thread also looks slow; only a repeat on the same line is a strike
+        uint64_t start = ruleClockTicks();
+        compiled.pattern->search(line.folded(), out, maxGroup);
+        uint64_t retimed = ruleClockTicks() - start;
+        if (retimed > _searchBudgetTicks) {
+            recordBudgetStrike(index, "search took " + std::to_string(static_cast<uint64_t>(std::min(ticks, retimed) * ruleClockNsPerTick() / 1e6)) +
+                                      " ms twice (budget " + std::to_string(_searchBudgetMs) + " ms)");
+        }
+    }
+    if (result == SearchResult::Match) {
+        counters.hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void RegexMatcher::recordBudgetStrike(size_t index, const std::string& reason) const {
+    SearchCounters& counters = *_compiledPatterns[index].counters;
+    std::lock_guard<std::mutex> lock(_quarantineMutex);
+    auto now = std::chrono::steady_clock::now();
+    while (!counters.strikes.empty() && now - counters.strikes.front() > kStrikeWindow) {
+        counters.strikes.pop_front();
+    }
+    counters.strikes.push_back(now);
+    size_t strikes = counters.strikes.size();
+    std::cerr << "[REDOS] Rule '" << _rules[index].name << "': " << reason << " (strike " << strikes;
+    if (_quarantineStrikes > 0) {
+        std::cerr << " of " << _quarantineStrikes << " within " << kStrikeWindow.count() << " s";
+    }
+    std::cerr << ")" << std::endl;
+    if (_quarantineStrikes == 0 || strikes < _quarantineStrikes) {
+        return;
+    }
+    
+    if (!counters.quarantined.load(std::memory_order_relaxed)) {
+        counters.quarantineReason = std::to_string(strikes) + " searches over budget; last: " + reason;
+        counters.quarantined.store(true, std::memory_order_relaxed);
+        invalidateMatchMemo();
+        std::cerr << "[REDOS] Rule '" << _rules[index].name << "' quarantined (disabled): "
+                  << counters.quarantineReason << std::endl;
+    }
+}
+
+void RegexMatcher::setSearchBudget(uint64_t matchLimit, uint32_t budgetMs, uint32_t quarantineStrikes) {
+    _matchLimit = matchLimit;
+    _searchBudgetMs = budgetMs;
+    _searchBudgetTicks = budgetMs > 0 ? static_cast<uint64_t>(budgetMs * 1e6 / ruleClockNsPerTick()) : 0;
+    _quarantineStrikes = quarantineStrikes;
+    for (auto& compiled : _compiledPatterns) {
+        if (compiled.pattern) {
+            compiled.pattern->setMatchBudget(_matchLimit);
+        }
+    }
+}
+
+bool RegexMatcher::isRuleQuarantined(size_t index) const {
+    return index < _compiledPatterns.size() && _compiledPatterns[index].counters->quarantined.load(std::memory_order_relaxed);
+}
+
+std::string RegexMatcher::getQuarantineReason(size_t index) const {
+    if (!isRuleQuarantined(index)) {
+        return std::string();
+    }
+    std::lock_guard<std::mutex> lock(_quarantineMutex);
+    return _compiledPatterns[index].counters->quarantineReason;
+}
+
+size_t RegexMatcher::getQuarantinedCount() const {
+    size_t count = 0;
+    for (size_t i = 0; i < _compiledPatterns.size(); ++i) {
+        if (isRuleQuarantined(i)) count++;
+    }
+    return count;
+}
+
+bool RegexMatcher::releaseQuarantine(const std::string& name) {
+    size_t index = findRuleIndex(name);
+    if (index >= _compiledPatterns.size()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(_quarantineMutex);
+    SearchCounters& counters = *_compiledPatterns[index].counters;
+    counters.strikes.clear();
+    counters.quarantineReason.clear();
+    counters.quarantined.store(false, std::memory_order_relaxed);
+    invalidateMatchMemo();
+    return true;
+}
+
+bool RegexMatcher::setCaptureDemand(const std::string& name, int highestGroup) {
+    size_t index = findRuleIndex(name);
+    if (index < _rules.size()) {
+        _rules[index].captureDemand = highestGroup;
+        invalidateMatchMemo();
+        return true;
+    }
+    return false;
+}
+
+int RegexMatcher::getCaptureIndex(const std::string& ruleName, const std::string& groupName) const {
+    size_t index = findRuleIndex(ruleName);
+    if (index >= _compiledPatterns.size()) {
+        return -1;
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(_patternMutex);
+        if (_compiledPatterns[index].pattern) {
+            return _compiledPatterns[index].pattern->groupIndex(groupName);
+        }
+    }
+    // A disabled rule is not compiled yet; compile a throwaway copy to resolve the name
+    std::string diagnostics;
+    CompiledRule compiled = compileRule(_rules[index], diagnostics);
+    return compiled.pattern ? compiled.pattern->groupIndex(groupName) : -1;
+}
+
+void RegexMatcher::getRuleSearchCounts(size_t index, size_t& matchOnly, size_t& withCaptures) const {
+    matchOnly = 0;
+    withCaptures = 0;
+    if (index < _compiledPatterns.size()) {
+        matchOnly = _compiledPatterns[index].counters->matchOnly.load(std::memory_order_relaxed);
+        withCaptures = _compiledPatterns[index].counters->withCaptures.load(std::memory_order_relaxed);
+    }
+}
+
+RuleProfile RegexMatcher::getRuleProfile(size_t index) const {
+    RuleProfile profile;
+    if (index >= _rules.size()) {
+        return profile;
+    }
+    auto learned = _learnedProfiles.find(_rules[index].name);
+    if (learned != _learnedProfiles.end()) {
+        profile = learned->second;
+    }
+    if (index < _compiledPatterns.size()) {
+        const SearchCounters& counters = *_compiledPatterns[index].counters;
+        size_t evaluations = counters.matchOnly.load(std::memory_order_relaxed) +
+                             counters.withCaptures.load(std::memory_order_relaxed);
+        profile.evaluations += evaluations;
+        profile.hits += counters.hits.load(std::memory_order_relaxed);
+        profile.timedNs += static_cast<uint64_t>(counters.timedTicks.load(std::memory_order_relaxed) * ruleClockNsPerTick());
+#if LEP_RULE_STATS
+        profile.timedSamples += evaluations;
+#else
+        profile.timedSamples += counters.timedSamples.load(std::memory_order_relaxed);
+#endif
+    }
+    return profile;
+}
+
+RuleStats RegexMatcher::getRuleStats(size_t index) const {
+    RuleStats stats;
+    if (index >= _rules.size() || index >= _compiledPatterns.size()) {
+        return stats;
+    }
+    const SearchCounters& counters = *_compiledPatterns[index].counters;
+    stats.name = _rules[index].name;
+    stats.evaluations = counters.matchOnly.load(std::memory_order_relaxed) +
+                        counters.withCaptures.load(std::memory_order_relaxed);
+    stats.matches = counters.hits.load(std::memory_order_relaxed);
+#if LEP_RULE_STATS
+    double nsPerTick = ruleClockNsPerTick();
+    stats.totalNs = counters.timedTicks.load(std::memory_order_relaxed) * nsPerTick;
+    stats.maxNs = counters.maxTicks.load(std::memory_order_relaxed) * nsPerTick;
+    stats.cooldownSuppressions = counters.cooldownSuppressions.load(std::memory_order_relaxed);
+#endif
+    return stats;
+}
+
+std::vector<RuleStats> RegexMatcher::getAllRuleStats() const {
+    std::vector<RuleStats> all;
+    all.reserve(_rules.size());
+    for (size_t i = 0; i < _rules.size(); ++i) {
+        all.push_back(getRuleStats(i));
+    }
+    return all;
+}
+
+void RegexMatcher::recordCooldownSuppression(size_t index) {
+#if LEP_RULE_STATS
+    if (index < _compiledPatterns.size()) {
+        _compiledPatterns[index].counters->cooldownSuppressions.fetch_add(1, std::memory_order_relaxed);
+    }
+#else
+    (void)index;
+#endif
+}
+
+void RegexMatcher::recordCooldownSuppression(const std::string& name) {
+#if LEP_RULE_STATS
+    recordCooldownSuppression(findRuleIndex(name));
+#else
+    (void)name;
+#endif
+}
+
+void RegexMatcher::printRuleStats(std::ostream& out) const {
+#if LEP_RULE_STATS
+    std::vector<RuleStats> all = getAllRuleStats();
+    double totalNs = 0.0;
+    for (const auto& stats : all) {
+        totalNs += stats.totalNs;
+    }
+    std::stable_sort(all.begin(), all.end(), [](const RuleStats& a, const RuleStats& b) { return a.totalNs > b.totalNs; });
+    
+    out << "[STATS] " << all.size() << " rules, " << std::fixed << std::setprecision(1) << totalNs / 1e6 << " ms searching, "
+        << getAverageRulesEvaluated() << " rules searched per line" << std::endl;
+    out << std::left << std::setw(32) << "rule" << std::right << std::setw(12) << "evals" << std::setw(10) << "matches"
+        << std::setw(12) << "total_ms" << std::setw(8) << "share" << std::setw(10) << "avg_ns" << std::setw(12) << "max_us"
+        << std::setw(10) << "cooldown" << std::endl;
+    for (const auto& stats : all) {
+        out << std::left << std::setw(32) << stats.name << std::right << std::setw(12) << stats.evaluations
+            << std::setw(10) << stats.matches
+            << std::setw(12) << std::setprecision(2) << stats.totalNs / 1e6
+            << std::setw(7) << std::setprecision(1) << (totalNs > 0.0 ? 100.0 * stats.totalNs / totalNs : 0.0) << "%"
+            << std::setw(10) << std::setprecision(0) << stats.avgNs()
+            << std::setw(12) << std::setprecision(1) << stats.maxNs / 1e3
+            << std::setw(10) << stats.cooldownSuppressions << std::endl;
+    }
+    size_t memoHits, memoLookups, memoBypassed;
+    if (getMatchCacheStats(memoHits, memoLookups, memoBypassed)) {
+        out << "[STATS] Match cache: " << memoHits << " hits of " << memoLookups << " lookups ("
+            << (memoLookups ? 100.0 * memoHits / memoLookups : 0.0) << "%), " << memoBypassed
+            << " lines bypassed" << std::endl;
+    }
+    out << "[STATS] Lines by channel:";
+    for (size_t c = 0; c < kLogChannelCount; ++c) {
+        out << ' ' << logChannelName(static_cast<LogChannel>(c)) << ' ' << _channelLines[c].load(std::memory_order_relaxed);
+    }
+    out << std::endl;
+    for (const auto& group : _groups) {
+        size_t evaluations = group.counters->evaluations.load(std::memory_order_relaxed);
+        size_t passes = group.counters->passes.load(std::memory_order_relaxed);
+        out << "[STATS] Group " << group.group.name << ": gate passed " << passes << " of " << evaluations << " lines" << std::endl;
+    }
+    out << std::defaultfloat;
+#else
+    out << "[STATS] Rule stats are compiled out (LEP_DISABLE_RULE_STATS)" << std::endl;
+#endif
+}
+
+bool RegexMatcher::appendRuleStatsCsv(const std::string& path) const {
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent, ec);
+    }
+    bool isNew = !std::filesystem::exists(path, ec);
+    
+    std::ofstream file(path, std::ios::app);
+    if (!file.is_open()) {
+        std::cerr << "Could not write rule stats to: " << path << std::endl;
+        return false;
+    }
+    if (isNew) {
+        file << "timestamp,rule,evaluations,matches,total_ns,avg_ns,max_ns,cooldown_suppressions" << std::endl;
+    }
+    
+    std::time_t now = std::time(nullptr);
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    char timestamp[32];
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &local);
+    
+    file << std::fixed << std::setprecision(0);
+    for (const auto& stats : getAllRuleStats()) {
+        // Rule names are free text; quote them for CSV
+        std::string name = stats.name;
+        for (size_t pos = name.find('"'); pos != std::string::npos; pos = name.find('"', pos + 2)) {
+            name.insert(pos, 1, '"');
+        }
+        file << timestamp << ",\"" << name << "\"," << stats.evaluations << ',' << stats.matches << ','
+             << stats.totalNs << ',' << stats.avgNs() << ',' << stats.maxNs << ',' << stats.cooldownSuppressions << '\n';
+    }
+    return file.good();
+}
+
+void RegexMatcher::setFirstMatch(bool enabled) {
+    _firstMatch = enabled;
+    rebuildRuleLayout();
+    updateEvaluationOrder();
+}
+
+double RegexMatcher::getAverageRulesEvaluated() const {
+    size_t lines = _linesSearched.load(std::memory_order_relaxed);
+    return lines ? static_cast<double>(_rulesSearched.load(std::memory_order_relaxed)) / lines : 0.0;
+}
+
+void RegexMatcher::rebuildRuleLayout() {
+    _stopSegments.clear();
+    _ruleGroups.clear();
+    _readsHeader.clear();
+    _headerRules.clear();
+    _memoBlocked = false;
+    extendRuleLayout(0);
+}
+
+void RegexMatcher::extendRuleLayout(size_t first) {
+    invalidateMatchMemo();
+    _stopSegments.resize(_rules.size());
+    _ruleGroups.resize(_rules.size(), kNoGroup);
+    _readsHeader.resize(_rules.size(), 0);
+    uint32_t segment = first == 0 ? 0 : _stopSegments[first - 1] + (stopsProcessing(first - 1) ? 1 : 0);
+    for (size_t i = first; i < _rules.size(); ++i) {
+        _stopSegments[i] = segment;
+        if (stopsProcessing(i)) {
+            segment++;
+        }
+        if (!_rules[i].group.empty()) {
+            auto it = _groupIndex.find(_rules[i].group);
+            if (it != _groupIndex.end()) {
+                _ruleGroups[i] = it->second;
+            }
+        }
+        // The memo keys lines by body; a rule (or a gate above it) that can tell two
+        // timestamps apart has to be searched on every line
+        bool readsHeader = mayReadTimestampHeader(_rules[i].pattern, false);
+        for (size_t g = _ruleGroups[i]; !readsHeader && g != kNoGroup; g = _groups[g].parent) {
+            readsHeader = mayReadTimestampHeader(_groups[g].group.gateLiteral, true) ||
+                          mayReadTimestampHeader(_groups[g].group.gatePattern, false);
+        }
+        if (readsHeader) {
+            _readsHeader[i] = 1;
+            _headerRules.push_back(i);
+            // Its match would decide which rules after it are searched, so no result is safe to reuse
+            _memoBlocked = _memoBlocked || stopsProcessing(i);
+        }
+    }
+    resetEvaluationOrder();
+}
+
+std::vector<size_t> RegexMatcher::computeRunEnds(const std::vector<size_t>& order) const {
+    std::vector<size_t> runEnd(order.size());
+    for (size_t n = order.size(); n-- > 0;) {
+        size_t group = _ruleGroups[order[n]];
+        bool sameAsNext = n + 1 < order.size() && group != kNoGroup && _ruleGroups[order[n + 1]] == group;
+        runEnd[n] = sameAsNext ? runEnd[n + 1] : n + 1;
+    }
+    return runEnd;
+}
+
+size_t RegexMatcher::addRuleGroups(const std::vector<RuleGroup>& groups) {
+    size_t first = _groups.size();
+    for (const auto& group : groups) {
+        if (group.name.empty() || _groupIndex.count(group.name)) {
+            std::cerr << "Rule group '" << group.name << "' is unnamed or defined twice; ignoring it" << std::endl;
+            continue;
+        }
+        CompiledGroup compiled;
+        compiled.group = group;
+        compiled.literal = group.gateLiteral;
+        asciiToLower(compiled.literal.data(), compiled.literal.size(), &compiled.literal[0]);
+        if (!group.gatePattern.empty()) {
+            const MatchEngine* engine = group.engine.empty() ? _defaultEngine : findMatchEngine(group.engine);
+            if (!engine) {
+                engine = _defaultEngine;
             }
-            _matchCount++;
-            anyMatch = true;
+            std::string error;
+            compiled.gate = engine->compile(lowerPatternLiterals(group.gatePattern), false, error);
+            if (compiled.gate) {
+                compiled.gate->setMatchBudget(_matchLimit);
+            } else {
+                std::cerr << "Error compiling gate pattern '" << group.gatePattern << "' for rule group '"
+                          << group.name << "' (" << engine->name() << "): " << error << std::endl;
+            }
+        }
+        _groupIndex.emplace(group.name, _groups.size());
+        _groups.push_back(std::move(compiled));
+    }
+    
+    // Parents are resolved after the batch so a child may be listed before its parent
+    for (size_t g = first; g < _groups.size(); ++g) {
+        const std::string& parentName = _groups[g].group.parent;
+        if (parentName.empty()) {
+            continue;
+        }
+        auto it = _groupIndex.find(parentName);
+        if (it == _groupIndex.end()) {
+            std::cerr << "Rule group '" << _groups[g].group.name << "': unknown parent '" << parentName
+                      << "'; treating it as top-level" << std::endl;
+            continue;
         }
+        // Walk up from the proposed parent; reaching g again would close a cycle
+        size_t ancestor = it->second;
+        size_t depth = 0;
+        while (ancestor != kNoGroup && ancestor != g && depth++ < _groups.size()) {
+            ancestor = _groups[ancestor].parent;
+        }
+        if (ancestor == g) {
+            std::cerr << "Rule group '" << _groups[g].group.name << "': parent '" << parentName
+                      << "' forms a cycle; treating it as top-level" << std::endl;
+            continue;
+        }
+        _groups[g].parent = it->second;
+    }
+    
+    rebuildRuleLayout();
+    if (_adaptiveOrder) {
+        updateEvaluationOrder();
+    }
+    return _groups.size() - first;
+}
+
+bool RegexMatcher::gatePasses(size_t group, const FoldedLine& line, std::vector<uint8_t>& states) const {
+    if (states[group] != 0) {
+        return states[group] == 1;
+    }
+    const CompiledGroup& compiled = _groups[group];
+    bool pass = compiled.parent == kNoGroup || gatePasses(compiled.parent, line, states);
+    if (pass) {
+        compiled.counters->evaluations.fetch_add(1, std::memory_order_relaxed);
+        if (!compiled.literal.empty()) {
+            pass = line.folded().find(compiled.literal) != std::string_view::npos;
+        }
+        if (pass && compiled.gate) {
+            pass = compiled.gate->search(line.folded(), nullptr, 0) == SearchResult::Match;
+        }
+        if (pass) {
+            compiled.counters->passes.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    states[group] = pass ? 1 : 2;
+    return pass;
+}
+
+void RegexMatcher::setMatchCacheEntries(size_t entries) {
+    _memo = entries > 0 ? std::make_unique<MatchMemo>(entries) : nullptr;
+}
+
+bool RegexMatcher::getMatchCacheStats(size_t& hits, size_t& lookups, size_t& bypassed) const {
+    hits = lookups = bypassed = 0;
+    if (!_memo) {
+        return false;
+    }
+    _memo->getStats(hits, lookups, bypassed);
+    return true;
+}
+
+void RegexMatcher::setAdaptiveOrder(bool enabled) {
+    _adaptiveOrder = enabled;
+    updateEvaluationOrder();
+}
+
+bool RegexMatcher::updateEvaluationOrder() {
+    if (!_adaptiveOrder) {
+        auto current = std::atomic_load(&_evaluationOrder);
+        bool hadOrder = current && current->adaptive;
+        resetEvaluationOrder();
+        return hadOrder;
     }
     
-    return anyMatch;
+    std::vector<RuleProfile> profiles(_rules.size());
+    for (size_t i = 0; i < _rules.size(); ++i) {
+        profiles[i] = getRuleProfile(i);
+    }
+    auto profiled = [&](size_t i) {
+        return profiles[i].evaluations >= kMinProfiledEvaluations && profiles[i].timedSamples > 0;
+    };
+    
+    std::vector<size_t> order(_rules.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        // Never move a rule across a stop-processing rule
+        if (_stopSegments[a] != _stopSegments[b]) return _stopSegments[a] < _stopSegments[b];
+        // Keep each group's rules together so one failed gate skips them all (ungrouped rules first)
+        if (_ruleGroups[a] != _ruleGroups[b]) return _ruleGroups[a] + 1 < _ruleGroups[b] + 1;
+        bool pa = profiled(a);
+        bool pb = profiled(b);
+        if (pa != pb) return pa;
+        if (!pa) return false;
+        // Expected hits per nanosecond of search; ties go to the cheaper rule
+        double costA = std::max(profiles[a].nsPerEvaluation(), 1.0);
+        double costB = std::max(profiles[b].nsPerEvaluation(), 1.0);
+        double scoreA = profiles[a].hitRate() / costA;
+        double scoreB = profiles[b].hitRate() / costB;
+        if (scoreA != scoreB) return scoreA > scoreB;
+        return costA < costB;
+    });
+    
+    auto current = std::atomic_load(&_evaluationOrder);
+    if (current && current->adaptive && current->order == order) {
+        return false;
+    }
+    installEvaluationOrder(std::move(order), true);
+    return true;
+}
+
+void RegexMatcher::installEvaluationOrder(std::vector<size_t> order, bool adaptive) {
+    std::atomic_store(&_evaluationOrder, buildEvaluationPlans(std::move(order), adaptive));
+}
+
+std::shared_ptr<const RegexMatcher::EvaluationPlans> RegexMatcher::buildEvaluationPlans(std::vector<size_t> order,
+                                                                                        bool adaptive) const {
+    auto plans = std::make_shared<EvaluationPlans>();
+    for (size_t c = 0; c < kLogChannelCount; ++c) {
+        EvaluationPlan& plan = plans->byChannel[c];
+        for (size_t i : order) {
+            uint32_t channels = _rules[i].channels;
+            if (channels == 0 || (channels & (1u << c))) {
+                plan.order.push_back(i);
+            }
+        }
+        plan.runEnd = computeRunEnds(plan.order);
+    }
+    plans->order = std::move(order);
+    plans->adaptive = adaptive;
+    return plans;
+}
+
+std::shared_ptr<const RegexMatcher::EvaluationPlans> RegexMatcher::currentPlans() const {
+    auto plans = std::atomic_load(&_evaluationOrder);
+    if (plans || _rules.empty()) {
+        return plans;
+    }
+    std::vector<size_t> configOrder(_rules.size());
+    std::iota(configOrder.begin(), configOrder.end(), 0);
+    auto built = buildEvaluationPlans(std::move(configOrder), false);
+    // Threads racing here build the same plan; the first one published is used by all
+    std::shared_ptr<const EvaluationPlans> expected;
+    if (std::atomic_compare_exchange_strong(&_evaluationOrder, &expected, built)) {
+        return built;
+    }
+    return expected;
+}
+
+std::vector<size_t> RegexMatcher::getEvaluationOrder() const {
+    auto plan = std::atomic_load(&_evaluationOrder);
+    if (plan) {
+        return plan->order;
+    }
+    std::vector<size_t> configOrder(_rules.size());
+    std::iota(configOrder.begin(), configOrder.end(), 0);
+    return configOrder;
+}
+
+void RegexMatcher::resetEvaluationOrder() {
+    std::atomic_store(&_evaluationOrder, std::shared_ptr<const EvaluationPlans>());
+}
+
+bool RegexMatcher::saveRuleProfiles(const std::string& path) const {
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent, ec);
+    }
+    
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Could not write rule profiles to: " << path << std::endl;
+        return false;
+    }
+    file << "# name\tevaluations\thits\ttimed_ns\ttimed_samples" << std::endl;
+    for (size_t i = 0; i < _rules.size(); ++i) {
+        RuleProfile profile = getRuleProfile(i);
+        file << _rules[i].name << '\t' << profile.evaluations << '\t' << profile.hits << '\t'
+             << profile.timedNs << '\t' << profile.timedSamples << '\n';
+    }
+    return file.good();
+}
+
+bool RegexMatcher::loadRuleProfiles(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    _learnedProfiles.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string name;
+        RuleProfile profile;
+        if (!std::getline(fields, name, '\t') ||
+            !(fields >> profile.evaluations >> profile.hits >> profile.timedNs >> profile.timedSamples)) {
+            continue;
+        }
+        // Keep the learned ratios but let this run's observations move the order
+        if (profile.evaluations > kMaxLearnedEvaluations) {
+            double scale = static_cast<double>(kMaxLearnedEvaluations) / profile.evaluations;
+            profile.evaluations = kMaxLearnedEvaluations;
+            profile.hits = static_cast<size_t>(profile.hits * scale);
+            profile.timedNs = static_cast<uint64_t>(profile.timedNs * scale);
+            profile.timedSamples = static_cast<size_t>(profile.timedSamples * scale);
+        }
+        _learnedProfiles[name] = profile;
+    }
+    
+    std::cout << "Loaded " << _learnedProfiles.size() << " rule profiles from: " << path << std::endl;
+    updateEvaluationOrder();
+    return true;
+}
+
+bool RegexMatcher::setDefaultEngine(const std::string& name) {
+    const MatchEngine* engine = findMatchEngine(name);
+    if (!engine) {
+        std::cerr << "Regex engine '" << name << "' is not available in this build; keeping '"
+                  << _defaultEngine->name() << "'" << std::endl;
+        return false;
+    }
+    if (engine != _defaultEngine) {
+        _defaultEngine = engine;
+        compilePatterns();
+    }
+    return true;
+}
+
+const char* RegexMatcher::getRuleEngineName(size_t index) const {
+    std::shared_lock<std::shared_mutex> lock(_patternMutex);
+    if (index < _compiledPatterns.size() && _compiledPatterns[index].pattern) {
+        return _compiledPatterns[index].engine->name();
+    }
+    return nullptr;
 }
 
 void RegexMatcher::setActionCallback(ActionCallback callback) {
@@ -90,33 +1022,152 @@ const RegexRule* RegexMatcher::getRule(size_t index) const {
 }
 
 const RegexRule* RegexMatcher::getRuleByName(const std::string& name) const {
-    for (const auto& r : _rules) {
-        if (r.name == name) return &r;
+    return getRule(findRuleIndex(name));
+}
+
+size_t RegexMatcher::findRuleIndex(const std::string& name) const {
+    auto it = _ruleIndex.find(name);
+    return it != _ruleIndex.end() ? it->second : _rules.size();
+}
+
+void RegexMatcher::rebuildRuleIndex() {
+    _ruleIndex.clear();
+    for (size_t i = 0; i < _rules.size(); ++i) {
+        _ruleIndex.emplace(_rules[i].name, i);
     }
-    return nullptr;
 }
 
 void RegexMatcher::clearRules() {
     _rules.clear();
     _compiledPatterns.clear();
+    _ruleIndex.clear();
+    _stopSegments.clear();
+    _ruleGroups.clear();
+    _groups.clear();
+    _groupIndex.clear();
+    _readsHeader.clear();
+    _headerRules.clear();
+    _memoBlocked = false;
+    invalidateMatchMemo();
+    resetEvaluationOrder();
 }
 
 void RegexMatcher::compilePatterns() {
+    invalidateMatchMemo();
     _compiledPatterns.clear();
+    resetEvaluationOrder();
+    compileFrom(0);
+    if (_adaptiveOrder) {
+        updateEvaluationOrder();
+    }
+}
+
+size_t RegexMatcher::compileFrom(size_t first, const RuleCache* cache) {
+    if (first >= _rules.size()) {
+        return 0;
+    }
+    size_t count = _rules.size() - first;
+    std::vector<CompiledRule> compiled(count);
+    std::vector<std::string> diagnostics(count);
+    std::atomic<size_t> fromCache{0};
+    auto compileOne = [&](size_t i) {
+        if (!_rules[first + i].enabled) {
+            // Disabled rules stay uncompiled until setRuleEnabled turns them on
+            compiled[i].disabledSince = std::chrono::steady_clock::now();
+            return;
+        }
+        std::string_view engineName;
+        std::string_view cached = cache ? cache->entry(i, engineName) : std::string_view();
+        bool used = false;
+        compiled[i] = compileRule(_rules[first + i], diagnostics[i], cached, &used);
+        if (used) {
+            fromCache.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+    
+    size_t threads = 1;
+    if (count >= kParallelCompileThreshold) {
+        size_t cores = std::thread::hardware_concurrency();
+        threads = std::max<size_t>(1, std::min(cores ? cores : 4, count / (kParallelCompileThreshold / 4)));
+    }
     
-    for (const auto& rule : _rules) {
-        try {
-            _compiledPatterns.emplace_back(rule.pattern, std::regex_constants::ECMAScript | std::regex_constants::optimize | std::regex_constants::icase);
-        } catch (const std::regex_error& e) {
-            std::cerr << "Error compiling regex pattern '" << rule.pattern 
-                     << "' for rule '" << rule.name << "': " << e.what() << std::endl;
-            // Add an empty regex as placeholder
-            _compiledPatterns.emplace_back("");
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            compileOne(i);
+        }
+    } else {
+        // Workers pull rules from a shared cursor so a few slow patterns don't idle the other cores
+        std::atomic<size_t> next{0};
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&]() {
+                for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+                    compileOne(i);
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+    
+    if (count > 1) {
+        _compiledPatterns.reserve(_rules.size());
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (!diagnostics[i].empty()) {
+            std::cerr << diagnostics[i];
+        }
+        _compiledPatterns.push_back(std::move(compiled[i]));
+    }
+    return fromCache.load();
+}
+
+RegexMatcher::CompiledRule RegexMatcher::compileRule(const RegexRule& rule, std::string& diagnostics,
+                                                     std::string_view cached, bool* fromCache) const {
+    CompiledRule compiled;
+    compiled.engine = _defaultEngine;
+    if (!rule.engine.empty()) {
+        const MatchEngine* engine = findMatchEngine(rule.engine);
+        if (engine) {
+            compiled.engine = engine;
+        } else {
+            diagnostics += "Regex engine '" + rule.engine + "' for rule '" + rule.name +
+                           "' is not available in this build; using '" + _defaultEngine->name() + "'\n";
+        }
+    }
+    
+    if (compiled.engine->backtracks()) {
+        for (const auto& hazard : findBacktrackingHazards(rule.pattern)) {
+            diagnostics += "[REDOS] Rule '" + rule.name + "' (" + compiled.engine->name() + "): " + hazard +
+                           "; consider engine: re2\n";
+        }
+    }
+    
+    if (!cached.empty()) {
+        // The cache key covers the pattern and engine version, so the bytes are this rule's pattern
+        compiled.pattern = compiled.engine->deserialize(cached);
+        if (compiled.pattern && fromCache) {
+            *fromCache = true;
+        }
+    }
+    if (!compiled.pattern) {
+        // Lines are folded to lowercase once per event, so rules compile case-sensitively
+        std::string error;
+        compiled.pattern = compiled.engine->compile(lowerPatternLiterals(rule.pattern), false, error);
+        if (!compiled.pattern) {
+            // Leave the pattern empty so the rule never matches
+            diagnostics += "Error compiling regex pattern '" + rule.pattern + "' for rule '" + rule.name +
+                           "' (" + compiled.engine->name() + "): " + error + "\n";
+            return compiled;
         }
     }
+    compiled.pattern->setMatchBudget(_matchLimit);
+    return compiled;
 }
 
-void RegexMatcher::defaultAction(const LogEventPtr& event, const RegexRule& rule, const std::smatch& matches) {
+void RegexMatcher::defaultAction(const LogEventPtr& event, const RegexRule& rule, const MatchCaptures& matches) {
     std::cout << "[MATCH] Rule: " << rule.name;
     if (!rule.description.empty()) {
         std::cout << " (" << rule.description << ")";
@@ -127,7 +1178,7 @@ void RegexMatcher::defaultAction(const LogEventPtr& event, const RegexRule& rule
     if (matches.size() > 1) {
         std::cout << "  Capture groups:";
         for (size_t i = 1; i < matches.size(); ++i) {
-            std::cout << " [" << i << "]=" << matches[i].str();
+            std::cout << " [" << i << "]=" << matches[i].view(event->data);
         }
         std::cout << std::endl;
     }
@@ -2,10 +2,24 @@
 
 #include <string>
 #include <vector>
-#include <regex>
 #include <functional>
 #include <memory>
+#include <atomic>
+#include <map>
+#include <unordered_map>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <chrono>
+#include <deque>
 #include "LogEvent.h"
+#include "MatchEngine.h"
+#include "CaseFold.h"
+#include "RuleStats.h"
+#include "LogChannel.h"
+
+class RuleCache;
+class MatchMemo;
 
 /**
  * @struct RegexRule
@@ -17,10 +31,56 @@ struct RegexRule {
     std::string description;
     bool enabled;
     int cooldownMs; // Minimum milliseconds between matches for this rule
+    std::string engine; // Regex engine for this rule ("std", "pcre2", "re2"); empty uses the matcher default
+    int captureDemand;  // Highest capture group the rule's actions read: -1 = all, 0 = none (match-only search)
+    bool stopProcessing; // A match ends evaluation; rules after this one in config order are not searched
+    std::string group;   // Rule group whose gate must pass before this rule is searched; empty for none
+    uint32_t channels;   // Bit n set = searched on LogChannel n lines; 0 = every channel
+    uint32_t id;         // Dense id assigned by RegexMatcher when the rule is added; never reused by that matcher
     
     RegexRule(const std::string& ruleName, const std::string& regexPattern, 
-              const std::string& ruleDescription = "", bool isEnabled = true, int cooldown = 0)
-        : name(ruleName), pattern(regexPattern), description(ruleDescription), enabled(isEnabled), cooldownMs(cooldown) {}
+              const std::string& ruleDescription = "", bool isEnabled = true, int cooldown = 0,
+              const std::string& ruleEngine = "", bool stop = false)
+        : name(ruleName), pattern(regexPattern), description(ruleDescription), enabled(isEnabled), cooldownMs(cooldown),
+          engine(ruleEngine), captureDemand(-1), stopProcessing(stop), channels(0), id(0) {}
+};
+
+/**
+ * @struct RuleGroup
+ * @brief A gate shared by a family of rules; the rules are only searched on lines that pass it
+ *
+ * Groups nest through parent, forming a decision tree: a group's gate is only tested when its
+ * parent's passed, and each gate is tested at most once per line.
+ */
+struct RuleGroup {
+    std::string name;
+    std::string gateLiteral; // Substring the line must contain (ASCII case-insensitive)
+    std::string gatePattern; // Regex the line must match (case-insensitive); both gates apply when set
+    std::string parent;      // Enclosing group; empty for a top-level group
+    std::string engine;      // Engine for gatePattern; empty uses the matcher default
+};
+
+/**
+ * @struct RuleProfile
+ * @brief Observed hit rate and search cost of one rule
+ */
+struct RuleProfile {
+    size_t evaluations = 0;  // Searches run
+    size_t hits = 0;         // Searches that matched
+    uint64_t timedNs = 0;    // Total time of the sampled searches
+    size_t timedSamples = 0; // Searches that were timed (a per-rule sample)
+    
+    double hitRate() const { return evaluations ? static_cast<double>(hits) / evaluations : 0.0; }
+    double nsPerEvaluation() const { return timedSamples ? static_cast<double>(timedNs) / timedSamples : 0.0; }
+};
+
+/**
+ * @struct RuleMatch
+ * @brief A matched rule index and its capture spans
+ */
+struct RuleMatch {
+    size_t index;
+    MatchCaptures captures;
 };
 
 /**
@@ -29,16 +89,39 @@ struct RegexRule {
  */
 class RegexMatcher {
 public:
-    using ActionCallback = std::function<void(const LogEventPtr&, const RegexRule&, const std::smatch&)>;
+    using ActionCallback = std::function<void(const LogEventPtr&, const RegexRule&, const MatchCaptures&)>;
     
     RegexMatcher();
     ~RegexMatcher();
     
     /**
-     * @brief Add a regex rule
+     * @brief Add a regex rule; only the new rule is compiled
      * @param rule The regex rule to add
      */
     void addRule(const RegexRule& rule);
+
+    /**
+     * @brief Add a batch of rules with a single compile pass
+     *
+     * Large batches are compiled in parallel across cores; rule order and diagnostics stay in input order.
+     * @param rules First rule
+     * @param count Number of rules
+     */
+    void addRules(const RegexRule* rules, size_t count);
+    void addRules(const std::vector<RegexRule>& rules);
+
+    /**
+     * @brief Add a batch of rules through the on-disk compiled rule cache
+     *
+     * When the cache was built from the same rules and engine versions, patterns whose engine
+     * has a serialized form (pcre2) are loaded from the mapped file instead of compiled; the
+     * rest are compiled as usual. On a miss the batch is compiled and the cache rewritten,
+     * unless none of its patterns has a serialized form.
+     * @param rules Rules to add
+     * @param cachePath Cache file path
+     * @return Number of patterns loaded from the cache
+     */
+    size_t addRulesCached(const std::vector<RegexRule>& rules, const std::string& cachePath);
     
     /**
      * @brief Add a regex rule with parameters
@@ -54,6 +137,22 @@ public:
     void addRule(const std::string& name, const std::string& pattern,
                 const std::string& description, bool enabled, int cooldownMs);
     
+    /**
+     * @brief Add rule groups; add them before the rules that name them
+     *
+     * Parents may be defined anywhere in the batch. An unknown parent or a parent cycle is
+     * reported and the group becomes top-level; a group whose gate fails to compile is kept
+     * with only its literal gate.
+     * @param groups Groups to add
+     * @return Number of groups added
+     */
+    size_t addRuleGroups(const std::vector<RuleGroup>& groups);
+
+    /**
+     * @brief Get the number of rule groups
+     */
+    size_t getRuleGroupCount() const { return _groups.size(); }
+    
     /**
      * @brief Remove a rule by name
      * @param name Rule name to remove
@@ -63,11 +162,26 @@ public:
     
     /**
      * @brief Enable or disable a rule
+     *
+     * Disabled rules are stored uncompiled; enabling one compiles it on the spot. Safe to call
+     * while other threads are matching.
      * @param name Rule name
      * @param enabled Whether to enable the rule
      * @return true if rule was found and updated, false otherwise
      */
     bool setRuleEnabled(const std::string& name, bool enabled);
+
+    /**
+     * @brief Free the compiled patterns of rules that have been disabled for at least idleTime
+     * @param idleTime Minimum time since the rule was disabled
+     * @return Number of patterns freed
+     */
+    size_t evictIdleRules(std::chrono::steady_clock::duration idleTime);
+
+    /**
+     * @brief Number of rules that currently hold a compiled pattern
+     */
+    size_t getCompiledRuleCount() const;
     
     /**
      * @brief Process a log event against all rules
@@ -75,6 +189,241 @@ public:
      * @return true if any rule matched, false otherwise
      */
     bool processEvent(const LogEventPtr& event);
+
+    /**
+     * @brief Search a single rule's compiled pattern.
+     *
+     * Rules are compiled case-sensitively against their lowercased pattern and searched in the
+     * line's folded copy; capture spans index line.original() directly.
+     * Only the groups named by the rule's captureDemand are extracted; rules whose actions read
+     * no capture use a match-only search and leave captures empty.
+     * @param index Rule index
+     * @param line Line folded once by the caller and shared across rules
+     * @param captures Output capture spans
+     * @return true if the rule compiled and matched, false otherwise
+     */
+    bool matchRule(size_t index, const FoldedLine& line, MatchCaptures& captures) const;
+
+    /**
+     * @brief Search every enabled rule in evaluation order.
+     *
+     * Rules are searched in the adaptive order when one is active, but results are returned
+     * sorted by rule index so callers still act on matches in config order. A matching rule with
+     * stopProcessing (every rule in first-match mode) ends the search; the rules before it in
+     * config order are still searched, so the result is the same whatever the evaluation order.
+     * Only rules scoped to the line's channel (and unscoped rules) are searched; this overload
+     * classifies the line itself.
+     * @param line Line folded once by the caller
+     * @param out Output matches in config order (cleared first)
+     * @return Number of matched rules
+     */
+    size_t matchRules(const FoldedLine& line, std::vector<RuleMatch>& out) const;
+
+    /**
+     * @brief Search the rules bucketed under a channel, for callers that already classified the line
+     * @param line Line folded once by the caller
+     * @param channel Channel of the line (LogEvent::channelInfo)
+     * @param out Output matches in config order (cleared first)
+     * @return Number of matched rules
+     */
+    size_t matchRules(const FoldedLine& line, LogChannel channel, std::vector<RuleMatch>& out) const;
+
+    /**
+     * @brief Stop at the first matching rule in config order
+     * @param enabled true for first-match-wins, false to honor only per-rule stopProcessing
+     */
+    void setFirstMatch(bool enabled);
+
+    /**
+     * @brief Check whether first-match-wins mode is enabled
+     */
+    bool isFirstMatch() const { return _firstMatch; }
+
+    /**
+     * @brief Average number of rules searched per line since the last reset
+     */
+    double getAverageRulesEvaluated() const;
+
+    /**
+     * @brief Get the observed profile of a rule, including statistics learned in earlier runs
+     * @param index Rule index
+     * @return Profile (all zero for an invalid index)
+     */
+    RuleProfile getRuleProfile(size_t index) const;
+
+    /**
+     * @brief Enable or disable the adaptive evaluation order
+     * @param enabled true to order rules by observed hit rate and cost, false for config order
+     */
+    void setAdaptiveOrder(bool enabled);
+
+    /**
+     * @brief Check whether the adaptive evaluation order is enabled
+     */
+    bool isAdaptiveOrder() const { return _adaptiveOrder; }
+
+    /**
+     * @brief Recompute the evaluation order from the current rule profiles
+     *
+     * Rules with a higher hit rate per nanosecond of search are evaluated first; rules without
+     * enough samples keep their config order after the profiled ones. Stop-processing rules are
+     * barriers: rules are only reordered between them.
+     * @return true if the order changed, false otherwise
+     */
+    bool updateEvaluationOrder();
+
+    /**
+     * @brief Get the current evaluation order
+     * @return Rule indexes in the order they are searched
+     */
+    std::vector<size_t> getEvaluationOrder() const;
+
+    /**
+     * @brief Persist rule profiles so the next start begins from the learned order
+     * @param path Profile file path (parent directories are created)
+     * @return true if the file was written, false otherwise
+     */
+    bool saveRuleProfiles(const std::string& path) const;
+
+    /**
+     * @brief Load rule profiles written by saveRuleProfiles and apply the learned order
+     * @param path Profile file path
+     * @return true if the file was read, false otherwise
+     */
+    bool loadRuleProfiles(const std::string& path);
+
+    /**
+     * @brief Get this run's cost accounting for a rule
+     * @param index Rule index
+     * @return Snapshot; time and cooldown fields stay zero when built with LEP_DISABLE_RULE_STATS
+     */
+    RuleStats getRuleStats(size_t index) const;
+
+    /**
+     * @brief Get cost accounting for every rule in config order
+     */
+    std::vector<RuleStats> getAllRuleStats() const;
+
+    /**
+     * @brief Count a match whose actions were skipped because the rule is cooling down
+     * @param index Rule index
+     */
+    void recordCooldownSuppression(size_t index);
+    void recordCooldownSuppression(const std::string& name);
+
+    /**
+     * @brief Configure the ReDoS guard
+     *
+     * A search that hits the engine's step limit, or runs longer than the time budget twice in a
+     * row on the same line, is a strike; a rule with quarantineStrikes strikes within the strike
+     * window is disabled with a logged reason so one hostile pattern cannot keep stalling the
+     * workers and the ordered dispatcher behind them.
+     * @param matchLimit Backtracking step limit per search (pcre2; 0 = engine default)
+     * @param budgetMs Wall-clock budget per search in milliseconds (0 = off)
+     * @param quarantineStrikes Strikes before a rule is quarantined (0 = never quarantine)
+     */
+    void setSearchBudget(uint64_t matchLimit, uint32_t budgetMs, uint32_t quarantineStrikes);
+
+    /**
+     * @brief Check whether a rule was quarantined by the ReDoS guard
+     * @param index Rule index
+     */
+    bool isRuleQuarantined(size_t index) const;
+
+    /**
+     * @brief Why a rule was quarantined
+     * @param index Rule index
+     * @return Reason, or an empty string if the rule is not quarantined
+     */
+    std::string getQuarantineReason(size_t index) const;
+
+    /**
+     * @brief Number of quarantined rules
+     */
+    size_t getQuarantinedCount() const;
+
+    /**
+     * @brief Put a quarantined rule back into service and clear its strikes
+     * @param name Rule name
+     * @return true if the rule was found, false otherwise
+     */
+    bool releaseQuarantine(const std::string& name);
+
+    /**
+     * @brief Size the match-result cache for repeated lines
+     *
+     * matchRules answers a line whose body (text after the timestamp) and channel were seen
+     * since the last rule change from the cache. Any change to the rules invalidates it.
+     * Rules that may read the timestamp (see mayReadTimestampHeader) are left out of cached
+     * results and searched on every line; if one of them stops processing, the cache is unused.
+     * @param entries Number of cached lines (0 disables the cache)
+     */
+    void setMatchCacheEntries(size_t entries);
+
+    /**
+     * @brief Get match-result cache statistics
+     * @param hits Output lines answered from the cache
+     * @param lookups Output lines looked up
+     * @param bypassed Output lines that skipped the cache while its hit rate was low
+     * @return false if the cache is disabled
+     */
+    bool getMatchCacheStats(size_t& hits, size_t& lookups, size_t& bypassed) const;
+
+    /**
+     * @brief Print a per-rule cost table, costliest rules first
+     * @param out Output stream
+     */
+    void printRuleStats(std::ostream& out) const;
+
+    /**
+     * @brief Append one timestamped row per rule to a CSV file (header written when the file is new)
+     * @param path CSV file path (parent directories are created)
+     * @return true if the rows were written, false otherwise
+     */
+    bool appendRuleStatsCsv(const std::string& path) const;
+
+    /**
+     * @brief Record the highest capture group a rule's actions consume
+     * @param name Rule name
+     * @param highestGroup -1 for all groups, 0 for none, n for groups 0..n
+     * @return true if the rule was found, false otherwise
+     */
+    bool setCaptureDemand(const std::string& name, int highestGroup);
+
+    /**
+     * @brief Look up the group number of a named capture in a rule's compiled pattern
+     * @param ruleName Rule name
+     * @param groupName Capture group name
+     * @return Group number, or -1 if the rule or group is unknown
+     */
+    int getCaptureIndex(const std::string& ruleName, const std::string& groupName) const;
+
+    /**
+     * @brief Get how often a rule was searched match-only versus with capture extraction
+     * @param index Rule index
+     * @param matchOnly Output count of match-only searches
+     * @param withCaptures Output count of searches that extracted captures
+     */
+    void getRuleSearchCounts(size_t index, size_t& matchOnly, size_t& withCaptures) const;
+
+    /**
+     * @brief Set the engine used for rules that do not name one
+     * @param name Engine name ("std", "pcre2", "re2")
+     * @return true if the engine is available in this build, false otherwise (default is unchanged)
+     */
+    bool setDefaultEngine(const std::string& name);
+
+    /**
+     * @brief Get the name of the default engine
+     */
+    const char* getDefaultEngineName() const { return _defaultEngine->name(); }
+
+    /**
+     * @brief Get the name of the engine a rule was compiled with
+     * @param index Rule index
+     * @return Engine name or nullptr if the rule did not compile
+     */
+    const char* getRuleEngineName(size_t index) const;
     
     /**
      * @brief Set the action callback for when rules match
@@ -87,6 +436,11 @@ public:
      * @return Number of rules
      */
     size_t getRuleCount() const { return _rules.size(); }
+
+    /**
+     * @brief Get one past the highest rule id handed out (ids of removed rules are not reused)
+     */
+    uint32_t getRuleIdCount() const { return _nextRuleId; }
     
     /**
      * @brief Get rule information
@@ -110,24 +464,218 @@ public:
     /**
      * @brief Reset match statistics
      */
-    void resetMatchCount() { _matchCount = 0; }
+    void resetMatchCount() { _matchCount = 0; _linesSearched = 0; _rulesSearched = 0; }
 
 private:
     std::vector<RegexRule> _rules;
-    std::vector<std::regex> _compiledPatterns;
+    // One cache line per rule so workers updating different rules do not false-share
+    struct alignas(64) SearchCounters {
+        std::atomic<size_t> matchOnly{0};
+        std::atomic<size_t> withCaptures{0};
+        std::atomic<size_t> hits{0};
+        std::atomic<uint64_t> timedTicks{0};   // ruleClockTicks spent in timed searches
+        std::atomic<size_t> timedSamples{0};   // Only counted when sampling (stats compiled out)
+#if LEP_RULE_STATS
+        std::atomic<uint64_t> maxTicks{0};
+        std::atomic<size_t> cooldownSuppressions{0};
+#endif
+        std::deque<std::chrono::steady_clock::time_point> strikes; // Within kStrikeWindow; guarded by _quarantineMutex
+        std::atomic<bool> quarantined{false};
+        std::string quarantineReason; // Guarded by _quarantineMutex
+    };
+
+    struct CompiledRule {
+        std::unique_ptr<CompiledPattern> pattern; // Null for disabled rules not compiled yet (or evicted)
+        const MatchEngine* engine = nullptr;
+        std::unique_ptr<SearchCounters> counters = std::make_unique<SearchCounters>();
+        std::chrono::steady_clock::time_point disabledSince;
+    };
+
+    std::vector<CompiledRule> _compiledPatterns;
+    
+    struct alignas(64) GateCounters {
+        std::atomic<size_t> evaluations{0};
+        std::atomic<size_t> passes{0};
+    };
+
+    struct CompiledGroup {
+        RuleGroup group;
+        std::string literal;                   // gateLiteral lowercased to match the folded line
+        std::unique_ptr<CompiledPattern> gate; // Null when the group has no (valid) gate pattern
+        size_t parent = kNoGroup;
+        std::unique_ptr<GateCounters> counters = std::make_unique<GateCounters>();
+    };
+
+    // A search order and, for each position, the position after its run of same-group rules,
+    // so a failed gate skips the whole run in one step
+    struct EvaluationPlan {
+        std::vector<size_t> order;
+        std::vector<size_t> runEnd;
+    };
+
+    // The full evaluation order and, per channel, the part of it that channel's lines can match
+    struct EvaluationPlans {
+        std::vector<size_t> order;
+        bool adaptive = false; // false = config order, so matches need no sorting
+        EvaluationPlan byChannel[kLogChannelCount];
+    };
+
+    static constexpr size_t kNoGroup = static_cast<size_t>(-1);
+    std::vector<CompiledGroup> _groups;
+    std::unordered_map<std::string, size_t> _groupIndex;
+    std::vector<size_t> _ruleGroups; // Group of each rule, kNoGroup when ungrouped
+    std::unordered_map<std::string, size_t> _ruleIndex; // First rule with each name
+    uint32_t _nextRuleId = 0;
+    const MatchEngine* _defaultEngine;
     ActionCallback _actionCallback;
     size_t _matchCount;
+    bool _adaptiveOrder;
+    bool _firstMatch;
+    // Segment of each rule: stop-processing rules close a segment, and rules never move across one
+    std::vector<uint32_t> _stopSegments;
+    mutable std::atomic<size_t> _linesSearched{0};
+    mutable std::atomic<size_t> _rulesSearched{0};
+    // Swapped atomically so worker threads never see a partial order. Null means config order,
+    // left for the next search to build so adding rules one at a time stays linear
+    mutable std::shared_ptr<const EvaluationPlans> _evaluationOrder;
+    mutable std::atomic<size_t> _channelLines[kLogChannelCount] = {};
+    std::unique_ptr<MatchMemo> _memo;
+    std::vector<uint8_t> _readsHeader;  // 1 for rules whose result can depend on the timestamp header
+    std::vector<size_t> _headerRules;   // Those rules in config order; the memo never caches them
+    bool _memoBlocked = false;          // A stop rule reads the header, so the memo is not used
+    // Bumped on every change that can alter a line's matches; cached results from older generations miss
+    mutable std::atomic<uint64_t> _generation{1};
+    std::map<std::string, RuleProfile> _learnedProfiles; // Loaded from a previous run, keyed by rule name
+    
+    // Without rule stats one search in this many is timed per rule; with them every search is
+    static constexpr size_t kProfileSampleInterval = 16;
+    // Minimum evaluations before a rule's profile is trusted for ordering
+    static constexpr size_t kMinProfiledEvaluations = 256;
+    // Learned evaluations are scaled down to this on load so the order can still adapt
+    static constexpr size_t kMaxLearnedEvaluations = 1000000;
+    // Batches at least this large are compiled on several threads
+    static constexpr size_t kParallelCompileThreshold = 64;
+    
+    uint64_t _matchLimit;
+    uint32_t _searchBudgetMs;
+    uint64_t _searchBudgetTicks;
+    uint32_t _quarantineStrikes;
+    mutable std::mutex _quarantineMutex;
+    // Matching holds it shared once per line; enabling or evicting a rule swaps its pattern under it exclusively
+    mutable std::shared_mutex _patternMutex;
+    static constexpr uint64_t kDefaultMatchLimit = 1000000;
+    static constexpr uint32_t kDefaultQuarantineStrikes = 3;
+    // Strikes older than this are forgotten, so rare stalls over a long uptime never add up
+    static constexpr std::chrono::seconds kStrikeWindow{60};
     
     /**
      * @brief Compile all regex patterns
      */
     void compilePatterns();
+
+    /**
+     * @brief Compile rules [first, end) into _compiledPatterns, in parallel for large ranges
+     * @param first Index of the first rule without a compiled pattern
+     * @param cache Optional open cache whose entries are indexed from first
+     * @return Number of patterns taken from the cache
+     */
+    size_t compileFrom(size_t first, const RuleCache* cache = nullptr);
+
+    /**
+     * @brief Compile one rule with its configured engine
+     * @param rule Rule to compile
+     * @param diagnostics Output warnings and errors (empty on a clean compile)
+     * @param cached Serialized pattern from the rule cache to try before compiling
+     * @param fromCache Set to true if the cached pattern was used
+     * @return Compiled rule; pattern is null if compilation failed
+     */
+    CompiledRule compileRule(const RegexRule& rule, std::string& diagnostics,
+                             std::string_view cached = std::string_view(), bool* fromCache = nullptr) const;
+
+    /**
+     * @brief Look up a rule index by name
+     * @return Rule index, or getRuleCount() if no rule has the name
+     */
+    size_t findRuleIndex(const std::string& name) const;
+
+    /**
+     * @brief Rebuild the name index after rules are removed
+     */
+    void rebuildRuleIndex();
+
+    /**
+     * @brief Search a compiled rule, extracting groups 0..maxGroup
+     */
+    bool searchRule(size_t index, const FoldedLine& line, MatchCaptures& captures, size_t maxGroup) const;
+
+    /**
+     * @brief Count a search that went over budget and quarantine the rule at the strike limit
+     */
+    void recordBudgetStrike(size_t index, const std::string& reason) const;
+
+    /**
+     * @brief Search enabled rules in evaluation order and return matches in config order
+     * @param allGroups true to extract every group, false to honor each rule's captureDemand
+     */
+    size_t collectMatches(const FoldedLine& line, LogChannel channel, std::vector<RuleMatch>& out, bool allGroups) const;
+
+    /**
+     * @brief Invalidate cached match results
+     */
+    void invalidateMatchMemo() const { _generation.fetch_add(1, std::memory_order_release); }
+
+    /**
+     * @brief Go back to config order after the rule list changes (built by the next search)
+     */
+    void resetEvaluationOrder();
+
+    /**
+     * @brief Bucket an evaluation order by channel and publish it to the matching threads
+     */
+    void installEvaluationOrder(std::vector<size_t> order, bool adaptive);
+
+    /**
+     * @brief Bucket an evaluation order by channel
+     */
+    std::shared_ptr<const EvaluationPlans> buildEvaluationPlans(std::vector<size_t> order, bool adaptive) const;
+
+    /**
+     * @brief Get the published plans, building and publishing config order if none is
+     */
+    std::shared_ptr<const EvaluationPlans> currentPlans() const;
+
+    /**
+     * @brief Recompute stop segments and rule groups and reset to config order after rules
+     * are removed, or groups or the first-match mode change
+     */
+    void rebuildRuleLayout();
+
+    /**
+     * @brief Lay out rules [first, end) after the ones already laid out and reset to config order
+     */
+    void extendRuleLayout(size_t first);
+
+    /**
+     * @brief Compute EvaluationPlan::runEnd for a search order
+     */
+    std::vector<size_t> computeRunEnds(const std::vector<size_t>& order) const;
+
+    /**
+     * @brief Test a group's gate and its ancestors', memoized per line in states
+     * @param states Per-group state for the current line: 0 = untested, 1 = passed, 2 = failed
+     */
+    bool gatePasses(size_t group, const FoldedLine& line, std::vector<uint8_t>& states) const;
+
+    /**
+     * @brief Check whether a match on this rule ends the search
+     */
+    bool stopsProcessing(size_t index) const { return _firstMatch || _rules[index].stopProcessing; }
     
     /**
      * @brief Default action callback - prints match information
      * @param event The matched event
      * @param rule The matched rule
-     * @param matches Regex match results
+     * @param matches Capture spans into event->data
      */
-    void defaultAction(const LogEventPtr& event, const RegexRule& rule, const std::smatch& matches);
+    void defaultAction(const LogEventPtr& event, const RegexRule& rule, const MatchCaptures& matches);
 };
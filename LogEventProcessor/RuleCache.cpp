@@ -0,0 +1,240 @@
+#include "RuleCache.h"
+#include "RegexMatcher.h"
+#include "MatchEngine.h"
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Bump when the file layout, lowerPatternLiterals output or an engine's compile options change
+constexpr uint32_t kCacheFormatVersion = 4;
+constexpr char kCacheMagic[8] = {'L', 'E', 'P', 'R', 'U', 'L', 'E', 'S'};
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t ruleCount;
+    uint64_t key;
+    uint64_t fileSize;
+};
+
+struct CacheEntry {
+    uint64_t blobOffset;
+    uint32_t blobSize;
+    char engine[12]; // NUL-padded engine name
+    uint64_t checksum; // FNV-1a of the blob
+};
+
+uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t fnv1a(uint64_t hash, const std::string& text) {
+    // Length first so adjacent fields cannot run together
+    uint64_t length = text.size();
+    hash = fnv1a(hash, &length, sizeof(length));
+    return fnv1a(hash, text.data(), text.size());
+}
+
+uint64_t blobChecksum(std::string_view blob) {
+    return fnv1a(14695981039346656037ULL, blob.data(), blob.size());
+}
+
+size_t alignUp(size_t value) {
+    return (value + 7) & ~static_cast<size_t>(7);
+}
+
+} // namespace
+
+RuleCache::~RuleCache() {
+    close();
+}
+
+uint64_t RuleCache::computeKey(const RegexRule* rules, size_t count, const MatchEngine& defaultEngine) {
+    uint64_t hash = 14695981039346656037ULL;
+    hash = fnv1a(hash, &kCacheFormatVersion, sizeof(kCacheFormatVersion));
+    hash = fnv1a(hash, defaultEngine.version());
+    for (size_t i = 0; i < count; ++i) {
+        const RegexRule& rule = rules[i];
+        const MatchEngine* engine = rule.engine.empty() ? &defaultEngine : findMatchEngine(rule.engine);
+        hash = fnv1a(hash, rule.name);
+        hash = fnv1a(hash, rule.pattern);
+        // Disabled rules may be compiled lazily and leave their entry empty
+        hash = fnv1a(hash, &rule.enabled, sizeof(rule.enabled));
+        hash = fnv1a(hash, engine ? engine->version() : std::string("unavailable"));
+    }
+    return hash;
+}
+
+bool RuleCache::open(const std::string& path, uint64_t key, size_t ruleCount) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(CacheHeader))) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    _fileHandle = file;
+    _mappingHandle = mapping;
+    _data = static_cast<const char*>(view);
+    _size = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(CacheHeader))) {
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    _data = static_cast<const char*>(view);
+    _size = static_cast<size_t>(st.st_size);
+#endif
+
+    CacheHeader header;
+    std::memcpy(&header, _data, sizeof(header));
+    size_t tableEnd = sizeof(CacheHeader) + static_cast<size_t>(header.ruleCount) * sizeof(CacheEntry);
+    if (std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 || header.version != kCacheFormatVersion ||
+        header.key != key || header.ruleCount != ruleCount || header.fileSize != _size || tableEnd > _size) {
+        close();
+        return false;
+    }
+
+    _entries.resize(ruleCount);
+    for (size_t i = 0; i < ruleCount; ++i) {
+        CacheEntry entry;
+        std::memcpy(&entry, _data + sizeof(CacheHeader) + i * sizeof(CacheEntry), sizeof(entry));
+        if (entry.blobOffset > _size || entry.blobSize > _size - entry.blobOffset) {
+            close();
+            return false;
+        }
+        _entries[i].engine = std::string_view(entry.engine, strnlen(entry.engine, sizeof(entry.engine)));
+        _entries[i].blob = std::string_view(_data + entry.blobOffset, entry.blobSize);
+        _entries[i].checksum = entry.checksum;
+    }
+    return true;
+}
+
+std::string_view RuleCache::entry(size_t index, std::string_view& engineName) const {
+    if (index >= _entries.size()) {
+        engineName = std::string_view();
+        return std::string_view();
+    }
+    engineName = _entries[index].engine;
+    // Engines decode these bytes without validating them, so a damaged blob is never handed over
+    if (blobChecksum(_entries[index].blob) != _entries[index].checksum) {
+        return std::string_view();
+    }
+    return _entries[index].blob;
+}
+
+void RuleCache::close() {
+    _entries.clear();
+#ifdef _WIN32
+    if (_data) UnmapViewOfFile(_data);
+    if (_mappingHandle) CloseHandle(static_cast<HANDLE>(_mappingHandle));
+    if (_fileHandle) CloseHandle(static_cast<HANDLE>(_fileHandle));
+#else
+    if (_data) munmap(const_cast<char*>(_data), _size);
+#endif
+    _data = nullptr;
+    _size = 0;
+    _fileHandle = nullptr;
+    _mappingHandle = nullptr;
+}
+
+bool RuleCache::write(const std::string& path, uint64_t key, const std::vector<std::string>& engines,
+                      const std::vector<std::string>& blobs) {
+    if (engines.size() != blobs.size()) {
+        return false;
+    }
+    std::vector<CacheEntry> table(blobs.size());
+    size_t offset = alignUp(sizeof(CacheHeader) + table.size() * sizeof(CacheEntry));
+    for (size_t i = 0; i < blobs.size(); ++i) {
+        std::memset(&table[i], 0, sizeof(CacheEntry));
+        table[i].blobOffset = offset;
+        table[i].blobSize = static_cast<uint32_t>(blobs[i].size());
+        std::strncpy(table[i].engine, engines[i].c_str(), sizeof(table[i].engine) - 1);
+        table[i].checksum = blobChecksum(blobs[i]);
+        offset = alignUp(offset + blobs[i].size());
+    }
+
+    CacheHeader header;
+    std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+    header.version = kCacheFormatVersion;
+    header.ruleCount = static_cast<uint32_t>(blobs.size());
+    header.key = key;
+    header.fileSize = offset;
+
+    std::error_code ec;
+    std::filesystem::path target(path);
+    if (target.has_parent_path()) {
+        std::filesystem::create_directories(target.parent_path(), ec);
+    }
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Could not write rule cache: " << temporary << std::endl;
+            return false;
+        }
+        static const char padding[8] = {0};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(CacheEntry)));
+        size_t written = sizeof(header) + table.size() * sizeof(CacheEntry);
+        for (size_t i = 0; i < blobs.size(); ++i) {
+            file.write(padding, static_cast<std::streamsize>(table[i].blobOffset - written));
+            file.write(blobs[i].data(), static_cast<std::streamsize>(blobs[i].size()));
+            written = table[i].blobOffset + blobs[i].size();
+        }
+        file.write(padding, static_cast<std::streamsize>(offset - written));
+        if (!file.good()) {
+            std::cerr << "Could not write rule cache: " << temporary << std::endl;
+            return false;
+        }
+    }
+    // Renamed into place so a crash mid-write never leaves a torn cache behind
+    std::filesystem::rename(temporary, path, ec);
+    if (ec) {
+        std::filesystem::remove(temporary, ec);
+        return false;
+    }
+    return true;
+}
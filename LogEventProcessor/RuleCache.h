@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct RegexRule;
+class MatchEngine;
+
+/**
+ * @class RuleCache
+ * @brief Memory-mapped on-disk cache of compiled rule patterns.
+ *
+ * The file is keyed by a hash of the rule definitions (including whether each is enabled), the
+ * pattern lowering format and the versions of the engines involved, so any edit to a rule or an
+ * engine upgrade rebuilds it. Each entry holds the engine name, that engine's serialized pattern
+ * and a checksum of it; engines without a serialized form store an empty entry, and those rules
+ * (like any whose blob fails its checksum) are compiled as usual.
+ *
+ * Layout: header | entry table (offset, size, engine, checksum) | 8-byte aligned blobs.
+ */
+class RuleCache {
+public:
+    RuleCache() = default;
+    ~RuleCache();
+
+    RuleCache(const RuleCache&) = delete;
+    RuleCache& operator=(const RuleCache&) = delete;
+
+    /**
+     * @brief Hash everything a cached pattern depends on
+     * @param rules Rules in load order
+     * @param count Number of rules
+     * @param defaultEngine Engine used for rules that do not name one
+     * @return Cache key
+     */
+    static uint64_t computeKey(const RegexRule* rules, size_t count, const MatchEngine& defaultEngine);
+
+    /**
+     * @brief Map a cache file and validate it against a key
+     * @param path Cache file path
+     * @param key Expected key
+     * @param ruleCount Expected number of entries
+     * @return true if the file exists, is intact and was built from the same rules and engines
+     */
+    bool open(const std::string& path, uint64_t key, size_t ruleCount);
+
+    /**
+     * @brief Serialized pattern of one rule (points into the mapping; valid while the cache is open)
+     * @param index Rule index within the cached batch
+     * @param engineName Engine that wrote the entry
+     * @return Serialized bytes, empty if the engine has no serialized form or the bytes are damaged
+     */
+    std::string_view entry(size_t index, std::string_view& engineName) const;
+
+    /**
+     * @brief Unmap the file
+     */
+    void close();
+
+    /**
+     * @brief Write a cache file (to a temporary name, then renamed over the old file)
+     * @param path Cache file path (parent directories are created)
+     * @param key Cache key
+     * @param engines Engine name per rule
+     * @param blobs Serialized pattern per rule (empty when not serializable)
+     * @return true if the file was written, false otherwise
+     */
+    static bool write(const std::string& path, uint64_t key, const std::vector<std::string>& engines,
+                      const std::vector<std::string>& blobs);
+
+private:
+    struct Entry {
+        std::string_view engine;
+        std::string_view blob;
+        uint64_t checksum;
+    };
+
+    const char* _data = nullptr;
+    size_t _size = 0;
+    void* _fileHandle = nullptr;
+    void* _mappingHandle = nullptr;
+    std::vector<Entry> _entries;
+};
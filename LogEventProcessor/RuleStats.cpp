@@ -0,0 +1,60 @@
+#include "RuleStats.h"
+#include <chrono>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define LEP_HAVE_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define LEP_HAVE_TSC 1
+#endif
+
+namespace {
+
+uint64_t steadyNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+#ifdef LEP_HAVE_TSC
+// Reference point taken at startup; the calibration gets more precise the longer the process runs
+struct TscReference {
+    uint64_t ticks = __rdtsc();
+    uint64_t ns = steadyNs();
+};
+
+const TscReference& tscReference() {
+    static const TscReference reference;
+    return reference;
+}
+
+// Make sure the reference exists before the first search is timed
+[[maybe_unused]] const TscReference& g_tscReference = tscReference();
+#endif
+
+} // namespace
+
+uint64_t ruleClockTicks() {
+#ifdef LEP_HAVE_TSC
+    return __rdtsc();
+#else
+    return steadyNs();
+#endif
+}
+
+double ruleClockNsPerTick() {
+#ifdef LEP_HAVE_TSC
+    const TscReference& reference = tscReference();
+    uint64_t ns = steadyNs();
+    if (ns - reference.ns < 20000000ULL) {
+        // Too early for a stable ratio; wait out a short calibration window
+        std::this_thread::sleep_for(std::chrono::nanoseconds(20000000ULL - (ns - reference.ns)));
+        ns = steadyNs();
+    }
+    uint64_t ticks = __rdtsc();
+    return ticks > reference.ticks ? static_cast<double>(ns - reference.ns) / static_cast<double>(ticks - reference.ticks) : 1.0;
+#else
+    return 1.0;
+#endif
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Define LEP_DISABLE_RULE_STATS to compile out per-search timing, max tracking and cooldown
+// counters. The sampled profile used by the adaptive rule order is kept either way.
+#ifndef LEP_DISABLE_RULE_STATS
+#define LEP_RULE_STATS 1
+#else
+#define LEP_RULE_STATS 0
+#endif
+
+/**
+ * @struct RuleStats
+ * @brief Cost accounting snapshot for one rule
+ */
+struct RuleStats {
+    std::string name;
+    size_t evaluations = 0;          // Searches run
+    size_t matches = 0;              // Searches that matched
+    double totalNs = 0.0;            // Cumulative search time
+    double maxNs = 0.0;              // Slowest single search
+    size_t cooldownSuppressions = 0; // Matches whose actions were skipped by the rule's cooldown
+    
+    double avgNs() const { return evaluations ? totalNs / evaluations : 0.0; }
+};
+
+/**
+ * @brief Cheap monotonic tick counter for timing rule searches (TSC on x86/x64, steady_clock elsewhere)
+ * @return Current tick count
+ */
+uint64_t ruleClockTicks();
+
+/**
+ * @brief Nanoseconds per tick of ruleClockTicks, calibrated against steady_clock
+ * @return Conversion factor (1.0 when ticks are already nanoseconds)
+ */
+double ruleClockNsPerTick();
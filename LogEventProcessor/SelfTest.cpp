@@ -0,0 +1,439 @@
+#include "SelfTest.h"
+#include "ActionManager.h"
+#include "ActionSink.h"
+#include "EmailOutbox.h"
+#include "InputBatch.h"
+#include "RegexMatcher.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Prints one line per assertion and turns the tally into an exit code
+class Checks {
+public:
+    explicit Checks(const std::string& suite) : _suite(suite) {}
+
+    bool expect(bool ok, const std::string& what) {
+        std::cout << "[SELFTEST] " << (ok ? "ok   " : "FAIL ") << _suite << ": " << what << std::endl;
+        _total++;
+        _failed += ok ? 0 : 1;
+        return ok;
+    }
+
+    int finish() const {
+        std::cout << "[SELFTEST] " << _suite << ": " << (_total - _failed) << " of " << _total << " checks passed" << std::endl;
+        return _failed == 0 ? 0 : 1;
+    }
+
+private:
+    std::string _suite;
+    size_t _total = 0;
+    size_t _failed = 0;
+};
+
+bool waitFor(const std::function<bool()>& done, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+std::string describe(const RecordingActionSink::Call& call) {
+    using CallType = RecordingActionSink::CallType;
+    switch (call.type) {
+        case CallType::Keystroke:
+        case CallType::Chord: {
+            std::string text = call.type == CallType::Keystroke ? "keystroke" : "chord";
+            for (int key : call.keys) text += " " + std::to_string(key);
+            return call.modifiers ? text + " mods " + std::to_string(call.modifiers) : text;
+        }
+        case CallType::Text: return "text " + call.value;
+        case CallType::Command: return "command " + call.value;
+        case CallType::Sms: return "sms";
+        case CallType::Focus: return "focus " + std::to_string(call.target);
+    }
+    return "?";
+}
+
+struct BuffRun {
+    std::vector<RecordingActionSink::Call> calls;
+    size_t focusSwitches = 0;
+    double switchesPerSequence = 0.0;
+    bool drained = false;
+};
+
+// Fire a four-step sequence with a delay in the middle (two runs) for each event
+BuffRun runBuffSequences(size_t targets, size_t events) {
+    auto sinkOwner = std::make_unique<RecordingActionSink>(true, targets);
+    RecordingActionSink* sink = sinkOwner.get();
+    RegexMatcher matcher;
+    ActionManager actions(std::move(sinkOwner));
+    actions.setRegexMatcher(&matcher);
+    matcher.addRule(RegexRule("buff", "buff me"));
+    std::vector<ActionMapping> steps;
+    steps.emplace_back("buff", "keystroke", "ctrl+1");
+    steps.emplace_back("buff", "command", "/say buffing");
+    steps.emplace_back("buff", "keystroke", "f2");
+    steps.back().delayMs = 20;
+    steps.emplace_back("buff", "text", "done");
+    steps.emplace_back("buff", "sms", "");
+
+    // Per-action logging would bury the results
+    std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+    actions.addActionSequence("buff", steps);
+    for (size_t i = 0; i < events; ++i) {
+        actions.processEvent(std::make_shared<LogEvent>("[Sun Oct 18 12:00:00 2026] buff me", i + 1));
+    }
+    size_t expectedCalls = events * (4 * targets + 1);
+    BuffRun run;
+    run.drained = waitFor([&]() { return sink->getCallCount() >= expectedCalls && actions.getPendingStepCount() == 0; },
+                          std::chrono::seconds(5));
+    std::cout.rdbuf(coutBuffer);
+    std::cout.clear();
+    run.calls = sink->getCalls();
+    run.focusSwitches = sink->getFocusSwitchCount();
+    run.switchesPerSequence = actions.getFocusSwitchesPerSequence();
+    return run;
+}
+
+// "+17 +49 -49 -17": key down/up in order, with "~N" after an event that pauses N ms
+std::string describe(const InputBatch& batch) {
+    std::string text;
+    for (const auto& event : batch.getEvents()) {
+        if (!text.empty()) text += " ";
+        text += (event.keyUp ? "-" : "+") + std::to_string(event.vk);
+        if (event.pauseAfterMs > 0) text += "~" + std::to_string(event.pauseAfterMs);
+    }
+    return text;
+}
+
+// Records every delivery and fails the next failuresLeft of them
+class FakeTransport {
+public:
+    struct Delivery {
+        std::string kind;
+        std::string body;
+        std::chrono::steady_clock::time_point at;
+    };
+
+    std::atomic<int> failuresLeft{0};
+
+    EmailOutbox::Transport bind() {
+        return [this](const std::string& kind, const std::string& body) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _deliveries.push_back({ kind, body, std::chrono::steady_clock::now() });
+            return failuresLeft.fetch_sub(1) <= 0;
+        };
+    }
+
+    std::vector<Delivery> take() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::vector<Delivery> deliveries;
+        deliveries.swap(_deliveries);
+        return deliveries;
+    }
+
+private:
+    std::mutex _mutex;
+    std::vector<Delivery> _deliveries;
+};
+
+std::string readFile(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+} // namespace
+
+int SelfTest::targetBatching() {
+    Checks checks("targets");
+    const size_t targets = 3;
+    auto keystroke = [](int key, int modifiers) {
+        RecordingActionSink::Call call;
+        call.type = RecordingActionSink::CallType::Keystroke;
+        call.keys.push_back(key);
+        call.modifiers = modifiers;
+        return describe(call);
+    };
+    const std::vector<std::string> expected = { keystroke('1', MOD_CONTROL), "command /say buffing", keystroke(VK_F2, 0), "text done" };
+
+    BuffRun one = runBuffSequences(targets, 1);
+    checks.expect(one.drained, "one sequence ran to the end");
+    std::vector<std::vector<std::string>> perTarget(targets);
+    size_t focused = targets;
+    size_t outOfFocus = 0;
+    size_t sms = 0;
+    for (const auto& call : one.calls) {
+        if (call.type == RecordingActionSink::CallType::Focus) {
+            focused = call.target;
+        } else if (call.type == RecordingActionSink::CallType::Sms) {
+            sms++;
+        } else {
+            outOfFocus += call.target != focused ? 1 : 0;
+            if (call.target < targets) perTarget[call.target].push_back(describe(call));
+        }
+    }
+    for (size_t target = 0; target < targets; ++target) {
+        checks.expect(perTarget[target] == expected, "window " + std::to_string(target) + " got every step in config order");
+    }
+    checks.expect(outOfFocus == 0, "every step went to the focused window");
+    checks.expect(sms == 1, "sms sent once, not per window");
+    // One focus per window for each run: the three steps before the delay, then the text
+    checks.expect(one.focusSwitches == 2 * targets,
+                  "focus switches " + std::to_string(one.focusSwitches) + " == runs x windows (" + std::to_string(2 * targets) + ")");
+
+    const size_t events = 4;
+    BuffRun many = runBuffSequences(targets, events);
+    checks.expect(many.drained, std::to_string(events) + " overlapping sequences ran to the end");
+    checks.expect(many.focusSwitches == events * 2 * targets,
+                  "focus switches " + std::to_string(many.focusSwitches) + " == sequences x runs x windows (" +
+                  std::to_string(events * 2 * targets) + ")");
+    checks.expect(many.switchesPerSequence == 2.0 * targets, "status line reports " + std::to_string(many.switchesPerSequence) + " switches per sequence");
+
+    BuffRun single = runBuffSequences(1, events);
+    checks.expect(single.drained && single.focusSwitches == 1, "one window is focused once and never refocused");
+
+    // Several keystrokes rendered from captures in one run must each keep their own keys
+    std::vector<std::string> templated;
+    {
+        auto sinkOwner = std::make_unique<RecordingActionSink>(true, 2);
+        RecordingActionSink* sink = sinkOwner.get();
+        RegexMatcher matcher;
+        ActionManager actions(std::move(sinkOwner));
+        actions.setRegexMatcher(&matcher);
+        matcher.addRule(RegexRule("keys", "press (f\\d+) then (f\\d+)"));
+        std::vector<ActionMapping> steps;
+        steps.emplace_back("keys", "keystroke", "#{1}");
+        steps.emplace_back("keys", "keystroke", "#{2}");
+        steps.emplace_back("keys", "keystroke", "ctrl+#{1}");
+        std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+        actions.addActionSequence("keys", steps);
+        actions.processEvent(std::make_shared<LogEvent>("[Sun Oct 18 12:00:00 2026] press f3 then f4", 1));
+        waitFor([&]() { return sink->getCallCount() >= 8 && actions.getPendingStepCount() == 0; }, std::chrono::seconds(5));
+        std::cout.rdbuf(coutBuffer);
+        std::cout.clear();
+        for (const auto& call : sink->getCalls()) {
+            if (call.type != RecordingActionSink::CallType::Focus && call.target == 1) templated.push_back(describe(call));
+        }
+    }
+    const std::vector<std::string> rendered = { keystroke(VK_F3, 0), keystroke(VK_F4, 0), keystroke(VK_F3, MOD_CONTROL) };
+    checks.expect(templated == rendered, "keystrokes rendered from captures in one run keep their own keys");
+    return checks.finish();
+}
+
+int SelfTest::inputBatch() {
+    Checks checks("input");
+    auto key = [](int vk, bool keyUp) { return (keyUp ? "-" : "+") + std::to_string(vk); };
+    const std::string alt = std::to_string(VK_MENU);
+
+    InputBatch batch;
+    batch.addChord({ '1', '2' }, MOD_ALT);
+    checks.expect(describe(batch) == "+" + alt + " +49 +50 -50 -49 -" + alt,
+                  "chord presses modifier then keys in order and releases in reverse: " + describe(batch));
+    checks.expect(batch.getRunCount() == 1, "unpaced chord is one run");
+
+    batch.clear();
+    batch.addKeystroke('A', MOD_CONTROL | MOD_ALT | MOD_SHIFT);
+    const std::string modifiers = key(VK_CONTROL, false) + " " + key(VK_MENU, false) + " " + key(VK_SHIFT, false) +
+                                  " +65 -65 " + key(VK_SHIFT, true) + " " + key(VK_MENU, true) + " " + key(VK_CONTROL, true);
+    checks.expect(describe(batch) == modifiers, "keystroke presses Ctrl, Alt, Shift and releases them in reverse: " + describe(batch));
+
+    batch.clear();
+    checks.expect(batch.empty() && batch.getRunCount() == 0, "clear leaves an empty batch with no runs");
+
+    // With pacing, every key transition of a chord is a pacing point unless pressed together
+    batch.setKeyPacing(std::chrono::milliseconds(10));
+    batch.addChord({ '1', '2' }, MOD_ALT);
+    checks.expect(describe(batch) == "+" + alt + " +49~10 +50~10 -50~10 -49~10 -" + alt,
+                  "paced chord pauses after each key: " + describe(batch));
+    checks.expect(batch.getRunCount() == 5, "paced chord is " + std::to_string(batch.getRunCount()) + " runs (5)");
+
+    batch.clear();
+    batch.addChord({ '1', '2' }, MOD_ALT, true);
+    checks.expect(describe(batch) == "+" + alt + " +49 +50 -50 -49 -" + alt, "pressTogether chord has no pacing points");
+    checks.expect(batch.getRunCount() == 1, "pressTogether chord is one run with pacing set");
+
+    batch.clear();
+    batch.addKeystroke(VK_F2);
+    checks.expect(batch.getRunCount() == 2, "paced keystroke holds the key: 2 runs");
+
+    // Typed text: one run unpaced, a pause after every transition when paced
+    batch.clear();
+    size_t skipped = batch.addText("/g hi");
+    checks.expect(skipped == 0 && batch.size() == 10, "text '/g hi' is 10 events with nothing skipped");
+    checks.expect(batch.getRunCount() == 10, "paced text is one run per transition (10)");
+
+    batch.clear();
+    batch.setKeyPacing(std::chrono::milliseconds(0));
+    batch.addText("/g hi");
+    checks.expect(batch.getRunCount() == 1, "unpaced text is one run");
+
+    batch.clear();
+    skipped = batch.addText("hi! ~ok");
+    checks.expect(skipped == 2, "characters with no key are skipped (" + std::to_string(skipped) + " of '!' and '~')");
+    checks.expect(batch.size() == 10, "the other 5 characters are typed (" + std::to_string(batch.size() / 2) + ")");
+    return checks.finish();
+}
+
+int SelfTest::outbox() {
+    using std::chrono::milliseconds;
+    Checks checks("outbox");
+    const auto journal = std::filesystem::temp_directory_path() / "lep_selftest_outbox.log";
+    std::error_code ec;
+    std::filesystem::remove(journal, ec);
+    FakeTransport transport;
+    OutboxSettings settings;
+    settings.batchWindow = milliseconds(50);
+    settings.retryBase = milliseconds(20);
+    settings.retryMax = milliseconds(80);
+    settings.maxAttempts = 3;
+    auto stats = [](EmailOutbox& outbox) { return outbox.getStats(); };
+
+    // Sender output would bury the results
+    std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+    std::streambuf* cerrBuffer = std::cerr.rdbuf(nullptr);
+
+    // Messages within the batch window go out as one body per kind
+    std::vector<FakeTransport::Delivery> batched;
+    bool batchedDrained = false;
+    size_t batchCount = 0;
+    uintmax_t journalAfterDrain = 0;
+    {
+        EmailOutbox outbox(transport.bind());
+        outbox.configure(settings);
+        outbox.open(journal.string());
+        outbox.enqueue("sms", "tell 1");
+        outbox.enqueue("ack", "ack 1");
+        outbox.enqueue("sms", "tell 2");
+        outbox.enqueue("sms", "tell 3");
+        batchedDrained = waitFor([&]() { return stats(outbox).delivered == 4; }, std::chrono::seconds(5));
+        batchCount = stats(outbox).batches;
+        journalAfterDrain = std::filesystem::file_size(journal, ec);
+        batched = transport.take();
+    }
+
+    // A failed delivery is retried with a doubling delay
+    std::vector<FakeTransport::Delivery> retried;
+    OutboxStats retryStats;
+    {
+        transport.failuresLeft = 2;
+        EmailOutbox outbox(transport.bind());
+        outbox.configure(settings);
+        outbox.open(journal.string());
+        outbox.enqueue("sms", "retry me");
+        waitFor([&]() { return stats(outbox).delivered == 1; }, std::chrono::seconds(5));
+        retryStats = stats(outbox);
+        retried = transport.take();
+    }
+
+    // ...and given up after maxAttempts
+    OutboxStats doomedStats;
+    {
+        transport.failuresLeft = 1000;
+        EmailOutbox outbox(transport.bind());
+        outbox.configure(settings);
+        outbox.open(journal.string());
+        outbox.enqueue("sms", "doomed");
+        waitFor([&]() { return stats(outbox).failed == 1; }, std::chrono::seconds(5));
+        doomedStats = stats(outbox);
+        transport.take();
+    }
+
+    // A message the transport never took survives a restart
+    std::vector<FakeTransport::Delivery> survived;
+    size_t recovered = 0;
+    {
+        transport.failuresLeft = 1000;
+        OutboxSettings slowRetry = settings;
+        slowRetry.retryBase = milliseconds(60000);
+        EmailOutbox outbox(transport.bind());
+        outbox.configure(slowRetry);
+        outbox.open(journal.string());
+        outbox.enqueue("sms", "survivor\nsecond line");
+        waitFor([&]() { return stats(outbox).retries == 1; }, std::chrono::seconds(5));
+    }
+    {
+        transport.failuresLeft = 0;
+        transport.take();
+        EmailOutbox outbox(transport.bind());
+        outbox.configure(settings);
+        outbox.open(journal.string());
+        recovered = stats(outbox).enqueued;
+        waitFor([&]() { return stats(outbox).delivered == 1; }, std::chrono::seconds(5));
+        survived = transport.take();
+    }
+
+    // A journal left by a killed process: recovered messages are renumbered ahead of ones queued before open
+    std::string reopened;
+    std::vector<FakeTransport::Delivery> replayed;
+    {
+        std::ofstream(journal, std::ios::binary) << "E 7 sms 100 old one\nE 9 ack 100 old two\nD 7\n";
+        OutboxSettings hold = settings;
+        hold.batchWindow = milliseconds(60000);
+        EmailOutbox outbox(transport.bind());
+        outbox.configure(hold);
+        outbox.enqueue("sms", "fresh");
+        outbox.open(journal.string());
+        reopened = readFile(journal);
+    }
+    {
+        EmailOutbox outbox(transport.bind());
+        outbox.configure(settings);
+        outbox.open(journal.string());
+        waitFor([&]() { return stats(outbox).delivered == 2; }, std::chrono::seconds(5));
+        replayed = transport.take();
+    }
+    std::cout.rdbuf(coutBuffer);
+    std::cerr.rdbuf(cerrBuffer);
+    std::cout.clear();
+    std::cerr.clear();
+
+    auto delivered = [](const std::vector<FakeTransport::Delivery>& deliveries, const std::string& kind, const std::string& body) {
+        return std::any_of(deliveries.begin(), deliveries.end(),
+                           [&](const FakeTransport::Delivery& d) { return d.kind == kind && d.body == body; });
+    };
+    checks.expect(batchedDrained && batched.size() == 2 && batchCount == 2,
+                  std::to_string(batched.size()) + " deliveries for 4 messages of 2 kinds (2)");
+    checks.expect(delivered(batched, "sms", "tell 1\ntell 2\ntell 3"), "sms messages joined one per line in order");
+    checks.expect(delivered(batched, "ack", "ack 1"), "ack delivered on its own");
+    checks.expect(journalAfterDrain == 0, "journal compacted to " + std::to_string(journalAfterDrain) + " bytes once drained");
+
+    checks.expect(retryStats.delivered == 1 && retryStats.retries == 2 && retried.size() == 3,
+                  "delivered on the third attempt after " + std::to_string(retryStats.retries) + " retries");
+    if (retried.size() == 3) {
+        auto first = std::chrono::duration_cast<milliseconds>(retried[1].at - retried[0].at);
+        auto second = std::chrono::duration_cast<milliseconds>(retried[2].at - retried[1].at);
+        checks.expect(first >= settings.retryBase && second >= 2 * settings.retryBase,
+                      "backoff " + std::to_string(first.count()) + " ms then " + std::to_string(second.count()) + " ms (>= 20, 40)");
+    }
+    checks.expect(doomedStats.failed == 1 && doomedStats.retries == 3 && doomedStats.pending == 0,
+                  "given up after " + std::to_string(doomedStats.retries) + " failed attempts (3)");
+
+    checks.expect(recovered == 1, "undelivered message recovered from the journal on restart");
+    checks.expect(survived.size() == 1 && delivered(survived, "sms", "survivor\nsecond line"), "recovered message delivered intact");
+
+    checks.expect(reopened.rfind("E 1 ack 100 old two\nE 2 sms ", 0) == 0 && reopened.find("fresh") != std::string::npos &&
+                  reopened.find("old one") == std::string::npos,
+                  "journal rewritten on open with the delivered record dropped and ids renumbered");
+    checks.expect(replayed.size() == 2 && delivered(replayed, "ack", "old two") && delivered(replayed, "sms", "fresh"),
+                  "both journaled messages delivered after restart");
+
+    std::filesystem::remove(journal, ec);
+    return checks.finish();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+
+/**
+ * @class SelfTest
+ * @brief Headless checks driven from the command line (--selftest-*).
+ *
+ * Each check builds its subject against portable stand-ins (RecordingActionSink, a fake
+ * email transport), prints one line per assertion and returns a process exit code: 0 when
+ * every assertion held, 1 otherwise. None of them needs a game client or a configuration.
+ */
+class SelfTest {
+public:
+    /**
+     * @brief Check that runs of action steps reach every target window in order, focusing
+     *        each window once per run (--selftest-targets)
+     * @return Process exit code (0 on success)
+     */
+    static int targetBatching();
+
+    /**
+     * @brief Check the key events, pacing points and run counts InputBatch builds for
+     *        keystrokes, chords and text (--selftest-input)
+     * @return Process exit code (0 on success)
+     */
+    static int inputBatch();
+
+    /**
+     * @brief Check EmailOutbox batching, retry backoff, giving up, and recovery from its
+     *        journal across restarts, against a fake transport (--selftest-outbox)
+     * @return Process exit code (0 on success)
+     */
+    static int outbox();
+};
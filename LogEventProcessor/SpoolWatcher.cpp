@@ -0,0 +1,375 @@
+#include "SpoolWatcher.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+#endif
+
+namespace {
+
+const char kEntryExtension[] = ".resp";
+const char kTempExtension[] = ".tmp";
+const size_t kStampDigits = 17; // yyyyMMddHHmmssfff
+
+int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool endsWith(const std::string& text, const char* suffix, size_t suffixLength) {
+    return text.size() >= suffixLength && text.compare(text.size() - suffixLength, suffixLength, suffix) == 0;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date (no timegm/_mkgmtime needed)
+int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = static_cast<unsigned>(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+// UTC stamp at the start of a spool file name, in Unix milliseconds
+bool parseStamp(const std::string& name, int64_t& ms) {
+    if (name.size() < kStampDigits) {
+        return false;
+    }
+    for (size_t i = 0; i < kStampDigits; ++i) {
+        if (!std::isdigit(static_cast<unsigned char>(name[i]))) {
+            return false;
+        }
+    }
+    auto field = [&](size_t pos, size_t length) { return std::stoi(name.substr(pos, length)); };
+    int year = field(0, 4), month = field(4, 2), day = field(6, 2);
+    int hour = field(8, 2), minute = field(10, 2), second = field(12, 2), millis = field(14, 3);
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+    int64_t days = daysFromCivil(year, static_cast<unsigned>(month), static_cast<unsigned>(day));
+    ms = ((days * 24 + hour) * 60 + minute) * 60000 + second * 1000 + millis;
+    return true;
+}
+
+} // namespace
+
+SpoolWatcher::SpoolWatcher(Handler handler) : _handler(std::move(handler)) {
+}
+
+SpoolWatcher::~SpoolWatcher() {
+    stop();
+}
+
+bool SpoolWatcher::parseEntryName(const std::string& fileName, int64_t& writtenAtMs, std::string& key) {
+    const size_t extension = sizeof(kEntryExtension) - 1;
+    if (!endsWith(fileName, kEntryExtension, extension) || fileName.size() <= kStampDigits + 1 + extension ||
+        fileName[kStampDigits] != '_' || !parseStamp(fileName, writtenAtMs)) {
+        return false;
+    }
+    key = fileName.substr(kStampDigits + 1, fileName.size() - kStampDigits - 1 - extension);
+    return true;
+}
+
+bool SpoolWatcher::start(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_thread.joinable()) {
+        return true;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (!std::filesystem::is_directory(directory, ec)) {
+        std::cerr << "[SPOOL] Cannot create spool directory: " << directory << std::endl;
+        return false;
+    }
+    _directory = directory;
+    // Entries written before we started answer tells we never sent
+    _startedAtMs = nowMs();
+    _stopRequested = false;
+#ifdef _WIN32
+    _wakeEvent = CreateEventA(NULL, FALSE, FALSE, NULL);
+#else
+    if (pipe(_wakePipe) == 0) {
+        for (int fd : _wakePipe) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+    } else {
+        _wakePipe[0] = _wakePipe[1] = -1;
+    }
+#endif
+    _stats.eventDriven = openWatch();
+    if (_stats.eventDriven) {
+        std::cout << "[SPOOL] Watching " << std::filesystem::absolute(directory, ec).string() << " for responses" << std::endl;
+    } else {
+        std::cout << "[SPOOL] Change notifications unavailable; polling " << directory
+                  << " every " << _settings.pollInterval.count() << " ms" << std::endl;
+    }
+    _thread = std::thread(&SpoolWatcher::run, this);
+    return true;
+}
+
+void SpoolWatcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_thread.joinable()) {
+            return;
+        }
+        _stopRequested = true;
+    }
+    wake();
+    _thread.join();
+    closeWatch();
+    closeWake();
+}
+
+void SpoolWatcher::configure(const SpoolSettings& settings) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _settings = settings;
+    _settings.dedupeWindow = std::max<size_t>(1, _settings.dedupeWindow);
+}
+
+SpoolStats SpoolWatcher::getStats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+void SpoolWatcher::run() {
+    while (true) {
+        scan();
+        std::chrono::milliseconds timeout;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_stopRequested) {
+                break;
+            }
+            timeout = _stats.eventDriven ? _settings.rescanInterval : _settings.pollInterval;
+        }
+        waitForChange(timeout);
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stopRequested) {
+            break;
+        }
+    }
+}
+
+void SpoolWatcher::scan() {
+    namespace fs = std::filesystem;
+    std::vector<std::string> names;
+    std::error_code ec;
+    for (fs::directory_iterator it(_directory, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec)) {
+            names.push_back(it->path().filename().string());
+        }
+    }
+    if (names.empty()) {
+        return;
+    }
+    // Stamped names sort oldest first
+    std::sort(names.begin(), names.end());
+
+    SpoolSettings settings;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        settings = _settings;
+    }
+    int64_t now = nowMs();
+    int64_t expiresBefore = now - std::chrono::duration_cast<std::chrono::milliseconds>(settings.maxAge).count();
+    int64_t cutoff = std::max(_startedAtMs, expiresBefore);
+    auto discard = [&](const fs::path& path, size_t SpoolStats::*counter, const char* reason) {
+        fs::remove(path, ec);
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.*counter += 1;
+        std::cout << "[SPOOL] Discarded " << reason << " entry " << path.filename().string() << std::endl;
+    };
+
+    for (const auto& name : names) {
+        fs::path path = fs::path(_directory) / name;
+        int64_t writtenAt = 0;
+        std::string key;
+        if (endsWith(name, kTempExtension, sizeof(kTempExtension) - 1)) {
+            // A writer that died before its rename leaves a temp file; drop it once it is too old to deliver
+            if (parseStamp(name, writtenAt) && writtenAt < expiresBefore) {
+                discard(path, &SpoolStats::stale, "abandoned");
+            }
+            continue;
+        }
+        if (!endsWith(name, kEntryExtension, sizeof(kEntryExtension) - 1)) {
+            continue; // Not ours
+        }
+        if (!parseEntryName(name, writtenAt, key)) {
+            discard(path, &SpoolStats::rejected, "misnamed");
+            continue;
+        }
+        if (writtenAt < cutoff) {
+            discard(path, &SpoolStats::stale, "stale");
+            continue;
+        }
+        if (_recentSet.count(key)) {
+            discard(path, &SpoolStats::duplicates, "duplicate");
+            continue;
+        }
+
+        std::string text;
+        std::ifstream in(path.string(), std::ios::binary);
+        if (in.is_open()) {
+            text.resize(settings.maxEntryBytes + 1);
+            in.read(&text[0], static_cast<std::streamsize>(text.size()));
+            text.resize(static_cast<size_t>(in.gcount()));
+            in.close();
+        }
+        while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) {
+            text.pop_back();
+        }
+        if (text.empty() || text.size() > settings.maxEntryBytes) {
+            discard(path, &SpoolStats::rejected, text.empty() ? "empty" : "oversized");
+            continue;
+        }
+
+        if (!_handler(key, text)) {
+            // Later entries wait too, so responses are never delivered out of order
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stats.held++;
+            break;
+        }
+        fs::remove(path, ec);
+        rememberKey(key, settings.dedupeWindow);
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.delivered++;
+    }
+}
+
+void SpoolWatcher::rememberKey(const std::string& key, size_t window) {
+    if (_recentSet.insert(key).second) {
+        _recentKeys.push_back(key);
+    }
+    while (_recentKeys.size() > window) {
+        _recentSet.erase(_recentKeys.front());
+        _recentKeys.pop_front();
+    }
+}
+
+#ifdef _WIN32
+
+bool SpoolWatcher::openWatch() {
+    HANDLE handle = FindFirstChangeNotificationA(_directory.c_str(), FALSE, FILE_NOTIFY_CHANGE_FILE_NAME);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    _changeHandle = handle;
+    return true;
+}
+
+void SpoolWatcher::closeWatch() {
+    if (_changeHandle) {
+        FindCloseChangeNotification(_changeHandle);
+        _changeHandle = NULL;
+    }
+}
+
+void SpoolWatcher::waitForChange(std::chrono::milliseconds timeout) {
+    HANDLE handles[2];
+    DWORD count = 0;
+    if (_wakeEvent) handles[count++] = _wakeEvent;
+    if (_changeHandle) handles[count++] = _changeHandle;
+    DWORD waitMs = static_cast<DWORD>(std::max<int64_t>(1, timeout.count()));
+    if (count == 0) {
+        Sleep(waitMs);
+        return;
+    }
+    DWORD result = WaitForMultipleObjects(count, handles, FALSE, waitMs);
+    if (result < WAIT_OBJECT_0 + count && handles[result - WAIT_OBJECT_0] == _changeHandle) {
+        // Re-arm; the scan that follows picks up everything that changed
+        FindNextChangeNotification(_changeHandle);
+    }
+}
+
+void SpoolWatcher::wake() {
+    if (_wakeEvent) {
+        SetEvent(_wakeEvent);
+    }
+}
+
+void SpoolWatcher::closeWake() {
+    if (_wakeEvent) {
+        CloseHandle(_wakeEvent);
+        _wakeEvent = NULL;
+    }
+}
+
+#else
+
+bool SpoolWatcher::openWatch() {
+#ifdef __linux__
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    // Writers rename finished entries in; a plain write is caught on close
+    if (inotify_add_watch(fd, _directory.c_str(), IN_MOVED_TO | IN_CLOSE_WRITE) < 0) {
+        close(fd);
+        return false;
+    }
+    _inotify = fd;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SpoolWatcher::closeWatch() {
+    if (_inotify >= 0) {
+        close(_inotify);
+        _inotify = -1;
+    }
+}
+
+void SpoolWatcher::waitForChange(std::chrono::milliseconds timeout) {
+    pollfd fds[2];
+    nfds_t count = 0;
+    if (_wakePipe[0] >= 0) {
+        fds[count++] = { _wakePipe[0], POLLIN, 0 };
+    }
+    if (_inotify >= 0) {
+        fds[count++] = { _inotify, POLLIN, 0 };
+    }
+    int waitMs = static_cast<int>(std::max<int64_t>(1, timeout.count()));
+    if (poll(fds, count, waitMs) <= 0) {
+        return;
+    }
+    // Drain both descriptors; what changed does not matter, the scan looks at everything
+    char buffer[4096];
+    for (nfds_t i = 0; i < count; ++i) {
+        if (fds[i].revents & POLLIN) {
+            while (read(fds[i].fd, buffer, sizeof(buffer)) > 0) {
+            }
+        }
+    }
+}
+
+void SpoolWatcher::wake() {
+    if (_wakePipe[1] >= 0) {
+        char byte = 1;
+        ssize_t written = write(_wakePipe[1], &byte, 1);
+        (void)written;
+    }
+}
+
+void SpoolWatcher::closeWake() {
+    for (int& fd : _wakePipe) {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+/**
+ * @struct SpoolSettings
+ * @brief Staleness, duplicate and polling limits of a SpoolWatcher
+ */
+struct SpoolSettings {
+    std::chrono::milliseconds pollInterval{1000}; // Rescan period without change notifications
+    std::chrono::milliseconds rescanInterval{5000}; // Rescan period with them (retries held files)
+    std::chrono::seconds maxAge{120};              // Older entries are discarded, not delivered
+    size_t dedupeWindow = 256;                     // Recently delivered keys remembered
+    size_t maxEntryBytes = 4096;                   // Larger entries are discarded as malformed
+};
+
+/**
+ * @struct SpoolStats
+ * @brief Counters of a SpoolWatcher
+ */
+struct SpoolStats {
+    size_t delivered = 0;  // Entries accepted by the handler
+    size_t stale = 0;      // Entries older than maxAge or than the watcher
+    size_t duplicates = 0; // Entries whose key was delivered recently
+    size_t rejected = 0;   // Unreadable, oversized or empty entries
+    size_t held = 0;       // Scans stopped at an entry the handler refused (kept for the next scan)
+    bool eventDriven = false; // Change notifications are active (false = polling)
+};
+
+/**
+ * @class SpoolWatcher
+ * @brief Delivers files dropped into a spool directory, one file per entry.
+ *
+ * A writer creates "<yyyyMMddHHmmssfff>_<key>.tmp" and renames it to the same name with a
+ * ".resp" extension, so the watcher never sees a half-written entry. The timestamp is UTC;
+ * the key identifies the source (an IMAP uid, a GUID per dropped file) for duplicate detection. The
+ * watcher thread sleeps on directory change notifications (inotify, or
+ * FindFirstChangeNotification on Windows) and falls back to polling when those are not
+ * available. Each wake-up scans the directory and hands every entry to the handler in
+ * name order. Delivered, stale, duplicate and malformed entries are deleted; an entry the
+ * handler refuses stays for the next scan until it goes stale.
+ */
+class SpoolWatcher {
+public:
+    /**
+     * @brief Consume one entry; returns false to keep it for a later scan
+     * @param key Entry key from the file name
+     * @param text Entry contents
+     */
+    using Handler = std::function<bool(const std::string& key, const std::string& text)>;
+
+    explicit SpoolWatcher(Handler handler);
+    ~SpoolWatcher();
+
+    SpoolWatcher(const SpoolWatcher&) = delete;
+    SpoolWatcher& operator=(const SpoolWatcher&) = delete;
+
+    /**
+     * @brief Create the directory if needed and start the watcher thread
+     * @param directory Spool directory
+     * @return true if the directory exists
+     */
+    bool start(const std::string& directory);
+
+    /**
+     * @brief Stop the watcher thread; undelivered entries stay in the directory
+     */
+    void stop();
+
+    /**
+     * @brief Change the limits (applies from the next scan)
+     */
+    void configure(const SpoolSettings& settings);
+
+    SpoolStats getStats() const;
+
+    /**
+     * @brief Split an entry file name into its UTC write time and key
+     * @param fileName Name without directory ("20250913125205123_4711.resp")
+     * @param writtenAtMs Output Unix time in milliseconds
+     * @param key Output key
+     * @return true if the name has the entry form
+     */
+    static bool parseEntryName(const std::string& fileName, int64_t& writtenAtMs, std::string& key);
+
+private:
+    Handler _handler;
+    SpoolSettings _settings;
+    std::string _directory;
+    int64_t _startedAtMs = 0;
+    std::deque<std::string> _recentKeys;       // Delivery order, for eviction
+    std::unordered_set<std::string> _recentSet;
+
+    mutable std::mutex _mutex;
+    std::thread _thread;
+    bool _stopRequested = false;
+    SpoolStats _stats;
+
+#ifdef _WIN32
+    HANDLE _changeHandle = NULL; // FindFirstChangeNotification handle
+    HANDLE _wakeEvent = NULL;
+#else
+    int _inotify = -1;
+    int _wakePipe[2] = { -1, -1 };
+#endif
+
+    void run();
+    void scan();
+    bool openWatch();
+    void closeWatch();
+    /**
+     * @brief Sleep until the directory changes, stop() is called or the timeout passes
+     */
+    void waitForChange(std::chrono::milliseconds timeout);
+    void wake();
+    void closeWake();
+    void rememberKey(const std::string& key, size_t window);
+};
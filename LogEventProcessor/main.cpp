@@ -11,6 +11,8 @@
 #include <filesystem>
 #include <thread>
 #include <chrono>
+#include <iomanip>
+#include <algorithm>
 #include "ConfigManager.h"
 #include "LogReader.h"
 #include "EventProcessor.h"
@@ -18,6 +20,10 @@
 #include "LogEvent.h"
 #include "RegexMatcher.h"
 #include "ActionManager.h"
+#include "ActionSender.h"
+#include "Benchmark.h"
+#include "SelfTest.h"
+#include "SpoolWatcher.h"
 
 // Global flag for graceful shutdown
 std::atomic<bool> g_running(true);
@@ -58,7 +64,62 @@ void customEventHandler(const LogEventPtr& event) {
     }
 }
 
+// Duplicate line suppression ahead of matching
+void configureDuplicateFilter(const ConfigManager& config, EventProcessor& eventProcessor) {
+    int windowMs = std::max(0, config.getInt("dedup_window_ms", 0));
+    size_t maxEntries = static_cast<size_t>(std::max(1, config.getInt("dedup_max_entries", 4096)));
+    uint32_t channelMask = 0;
+    std::string unknown;
+    std::string channels = config.getString("dedup_channels", "");
+    if (!parseLogChannels(channels, channelMask, unknown)) {
+        std::cerr << "[DEDUP] Unknown channel '" << unknown << "' in dedup_channels" << std::endl;
+    }
+    eventProcessor.setDuplicateWindow(std::chrono::milliseconds(windowMs), maxEntries, channelMask);
+    if (windowMs > 0) {
+        std::cout << "[DEDUP] Dropping lines repeated within " << windowMs << " ms"
+                  << (channels.empty() ? std::string() : " on channels: " + channels) << std::endl;
+    }
+}
+
+// Batching and retry policy of the sms/email outbox
+OutboxSettings readOutboxSettings(const ConfigManager& config) {
+    OutboxSettings settings;
+    settings.batchWindow = std::chrono::milliseconds(std::max(0, config.getInt("email_batch_window_ms", 2000)));
+    settings.retryMax = std::chrono::milliseconds(std::max(1000, config.getInt("email_retry_max_ms", 300000)));
+    settings.maxAttempts = static_cast<unsigned>(std::max(0, config.getInt("email_max_attempts", 8)));
+    return settings;
+}
+
+// Token-bucket limits on action sequences
+RateLimitSettings readRateLimits(const ConfigManager& config) {
+    RateLimitSettings settings;
+    settings.globalPerMinute = std::max(0, config.getInt("action_rate_per_minute", 0));
+    settings.globalBurst = std::max(1, config.getInt("action_rate_burst", 10));
+    settings.rulePerMinute = std::max(0, config.getInt("rule_rate_per_minute", 0));
+    settings.ruleBurst = std::max(1, config.getInt("rule_rate_burst", 3));
+    std::string policy = config.getString("action_rate_policy", "delay");
+    if (!parseRateLimitPolicy(policy, settings.policy)) {
+        std::cerr << "[RATE] Unknown action_rate_policy '" << policy << "' (expected drop, coalesce or delay); using delay" << std::endl;
+    }
+    settings.maxStaleness = std::chrono::milliseconds(std::max(0, config.getInt("action_max_staleness_ms", 3000)));
+    settings.maxBacklog = static_cast<size_t>(std::max(1, config.getInt("action_rate_backlog", 64)));
+    return settings;
+}
+
+// Staleness and polling limits of the email response spool
+SpoolSettings readSpoolSettings(const ConfigManager& config) {
+    SpoolSettings settings;
+    settings.maxAge = std::chrono::seconds(std::max(1, config.getInt("email_response_max_age_seconds", 120)));
+    settings.pollInterval = std::chrono::milliseconds(std::max(50, config.getInt("email_response_poll_ms", 1000)));
+    return settings;
+}
+
 int main(int argc, char* argv[]) {
+    // Helper stand-in mode: stdout is the reply stream, so nothing else may print to it
+    if (argc > 1 && std::string(argv[1]) == "--email-helper-standin") {
+        return Benchmark::serveEmailHelperStandin();
+    }
+
     // Set up signal handlers
     std::signal(SIGINT, signalHandler);
     std::signal(SIGTERM, signalHandler);
@@ -67,11 +128,59 @@ int main(int argc, char* argv[]) {
     std::cout << "A multi-threaded log file monitoring application" << std::endl;
     std::cout << "Press Ctrl+C to exit gracefully" << std::endl << std::endl;
     
-    // Determine config file path: prefer portable config next to executable
+    // Parse command line: [config.yaml] [--bench corpus.log] [--bench-pipeline corpus.log] [--bench-startup]
+    //                     [--bench-targets N] [--bench-iterations N] [--bench-email-helper "command"] [--stats]
+    //                     [--selftest-targets] [--selftest-input] [--selftest-outbox]
+    //                     (--email-helper-standin, first, runs the email helper stand-in)
     std::string configPath;
-    if (argc > 1) {
-        configPath = argv[1];
-    } else {
+    std::string benchCorpusPath;
+    std::string pipelineCorpusPath;
+    int benchIterations = 5;
+    int benchTargets = 1;
+    bool benchStartup = false;
+    std::string benchEmailHelperCommand;
+    bool showRuleStats = false;
+    std::string selfTest;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--stats") {
+            showRuleStats = true;
+        } else if (arg == "--bench-startup") {
+            benchStartup = true;
+        } else if (arg == "--bench" && i + 1 < argc) {
+            benchCorpusPath = argv[++i];
+        } else if (arg == "--bench-pipeline" && i + 1 < argc) {
+            pipelineCorpusPath = argv[++i];
+        } else if (arg == "--bench-targets" && i + 1 < argc) {
+            try { benchTargets = std::stoi(argv[++i]); } catch (...) { benchTargets = 1; }
+        } else if (arg == "--bench-email-helper" && i + 1 < argc) {
+            benchEmailHelperCommand = argv[++i];
+        } else if (arg == "--bench-iterations" && i + 1 < argc) {
+            try { benchIterations = std::stoi(argv[++i]); } catch (...) { benchIterations = 5; }
+        } else if (arg.rfind("--selftest-", 0) == 0) {
+            selfTest = arg.substr(11);
+        } else if (configPath.empty()) {
+            configPath = arg;
+        }
+    }
+
+    // Headless self-checks need no configuration
+    if (selfTest == "targets") {
+        return SelfTest::targetBatching();
+    }
+    if (selfTest == "input") {
+        return SelfTest::inputBatch();
+    }
+    if (selfTest == "outbox") {
+        return SelfTest::outbox();
+    }
+    if (!selfTest.empty()) {
+        std::cerr << "Unknown self-test: --selftest-" << selfTest << std::endl;
+        return 1;
+    }
+    
+    // Determine config file path: prefer portable config next to executable
+    if (configPath.empty()) {
         char modulePath[MAX_PATH] = {0};
         if (GetModuleFileNameA(NULL, modulePath, MAX_PATH) > 0) {
             std::string exePath(modulePath);
@@ -121,6 +230,30 @@ int main(int argc, char* argv[]) {
         std::cerr << "Failed to load configuration. Using default settings." << std::endl;
     }
     
+    // Offline benchmark modes: run against the configured or generated rules and exit
+    if (benchStartup) {
+        Benchmark benchmark(config, benchIterations);
+        return benchmark.compileStartup();
+    }
+    if (!benchEmailHelperCommand.empty()) {
+        Benchmark benchmark(config, benchIterations);
+        return benchmark.emailHelper(benchEmailHelperCommand, static_cast<size_t>(benchIterations) * 200);
+    }
+    if (!benchCorpusPath.empty()) {
+        Benchmark benchmark(config, benchIterations);
+        if (!benchmark.loadCorpus(benchCorpusPath)) {
+            return 1;
+        }
+        return benchmark.compareEngines();
+    }
+    if (!pipelineCorpusPath.empty()) {
+        Benchmark benchmark(config, benchIterations);
+        if (!benchmark.loadCorpus(pipelineCorpusPath)) {
+            return 1;
+        }
+        return benchmark.pipeline(static_cast<size_t>(std::max(1, benchTargets)));
+    }
+    
     // Get configuration values
     std::string logFilePath = config.getLogFilePath();
     std::string outputDir = config.getOutputDirectory();
@@ -131,23 +264,39 @@ int main(int argc, char* argv[]) {
     std::cout << "  Output directory: " << outputDir << std::endl;
     std::cout << "  Polling interval: " << pollingInterval << "ms" << std::endl;
     
+    // Learned rule profiles let the adaptive order start where the last run left off
+    std::string ruleProfilePath = (std::filesystem::path(outputDir) / "rule_profiles.tsv").string();
+    std::string ruleStatsCsvPath = (std::filesystem::path(outputDir) / "rule_stats.csv").string();
+    std::string outboxPath = (std::filesystem::path(outputDir) / "outbox.log").string();
+    int ruleStatsCsvInterval = config.getInt("rule_stats_csv_interval_seconds", 0);
+    int ruleEvictIdleSeconds = config.getInt("rule_evict_idle_seconds", 600);
+    
     // Initialize regex matcher and action manager
     g_regexMatcher = std::make_unique<RegexMatcher>();
     g_actionManager = std::make_unique<ActionManager>();
     
     if (g_actionManager->initialize()) {
         g_actionManager->setRegexMatcher(g_regexMatcher.get());
+        g_actionManager->setRateLimits(readRateLimits(config));
         
         // Configure process targeting
         bool targetAllProcesses = config.getTargetAllProcesses();
         std::vector<int> targetProcessIds = config.getTargetProcessIds();
         std::vector<std::string> targetProcessNames = config.getTargetProcessNames();
-        g_actionManager->getActionSender().configureProcessTargeting(targetAllProcesses, targetProcessIds, targetProcessNames);
+        if (ActionSender* sender = g_actionManager->getActionSender()) {
+            sender->configureProcessTargeting(targetAllProcesses, targetProcessIds, targetProcessNames);
+            sender->setKeyPacing(std::chrono::milliseconds(std::max(0, config.getInt("input_key_pacing_ms", 0))));
+            sender->configureOutbox(outboxPath, readOutboxSettings(config));
+            sender->setEmailHelperEnabled(config.getBool("email_helper", true));
+        }
         
         // Load regex rules and actions from configuration
         if (config.loadRegexRulesAndActions(*g_regexMatcher, *g_actionManager)) {
             std::cout << "  Regex rules: " << g_regexMatcher->getRuleCount() << " loaded" << std::endl;
             std::cout << "  Action mappings: " << g_actionManager->getMappingCount() << " loaded" << std::endl;
+            if (g_regexMatcher->isAdaptiveOrder()) {
+                g_regexMatcher->loadRuleProfiles(ruleProfilePath);
+            }
         } else {
             std::cout << "  Configuration: Failed to load regex rules and actions" << std::endl;
         }
@@ -166,6 +315,14 @@ int main(int argc, char* argv[]) {
     // Set custom event handler (used in non-parallel mode)
     eventProcessor.setEventHandler(customEventHandler);
     
+    SpoolWatcher responseSpool([](const std::string& key, const std::string& response) {
+        if (!g_actionManager || !g_actionManager->submitEmailResponse(response)) {
+            return false; // Kept in the spool until the game window is ready
+        }
+        std::cout << "[EMAIL RESPONSE] Response " << key << ": " << response << std::endl;
+        return true;
+    });
+    
     try {
         // Start the components
         logReader.start();
@@ -178,11 +335,16 @@ int main(int argc, char* argv[]) {
         } else {
             eventProcessor.enableParallelProcessing(false, 0);
         }
+        configureDuplicateFilter(config, eventProcessor);
         // Start processor (works for both modes)
         eventProcessor.start();
 
+        // EmailMonitor drops each emailed response into the spool; the watcher hands it to the scheduler
+        responseSpool.configure(readSpoolSettings(config));
+        responseSpool.start(config.getString("email_response_spool", "response_spool"));
+
         // Watch the config file for changes and hot-reload
-        std::thread([&configPath, &config, &eventProcessor, workerCount]() {
+        std::thread([&configPath, &config, &eventProcessor, &ruleProfilePath, &outboxPath, &responseSpool, workerCount]() {
             auto getWriteTicks = [&]() -> unsigned long long {
                 WIN32_FILE_ATTRIBUTE_DATA fad;
                 if (GetFileAttributesExA(configPath.c_str(), GetFileExInfoStandard, &fad)) {
@@ -200,19 +362,33 @@ int main(int argc, char* argv[]) {
                     return;
                 }
                 try {
+                    // Carry learned rule profiles over to the new matcher
+                    if (g_regexMatcher && g_regexMatcher->isAdaptiveOrder()) {
+                        g_regexMatcher->saveRuleProfiles(ruleProfilePath);
+                    }
                     if (g_actionManager) { g_actionManager->clearActionMappings(); }
                     g_regexMatcher = std::make_unique<RegexMatcher>();
                     if (g_actionManager) { g_actionManager->setRegexMatcher(g_regexMatcher.get()); }
                     if (!config.loadRegexRulesAndActions(*g_regexMatcher, *g_actionManager)) {
                         std::cerr << "Reload: failed to load rules/actions from config." << std::endl;
                     }
+                    if (g_regexMatcher->isAdaptiveOrder()) {
+                        g_regexMatcher->loadRuleProfiles(ruleProfilePath);
+                    }
                     
                     // Configure process targeting
                     bool targetAllProcesses = config.getTargetAllProcesses();
                     std::vector<int> targetProcessIds = config.getTargetProcessIds();
                     std::vector<std::string> targetProcessNames = config.getTargetProcessNames();
                     std::cout << "[HOTRELOAD] Process targeting - TargetAll: " << targetAllProcesses << ", PIDs: " << targetProcessIds.size() << std::endl;
-                    g_actionManager->getActionSender().configureProcessTargeting(targetAllProcesses, targetProcessIds, targetProcessNames);
+                    if (ActionSender* sender = g_actionManager->getActionSender()) {
+                        sender->configureProcessTargeting(targetAllProcesses, targetProcessIds, targetProcessNames);
+                        sender->setKeyPacing(std::chrono::milliseconds(std::max(0, config.getInt("input_key_pacing_ms", 0))));
+                        sender->configureOutbox(outboxPath, readOutboxSettings(config));
+                        sender->setEmailHelperEnabled(config.getBool("email_helper", true));
+                    }
+                    responseSpool.configure(readSpoolSettings(config));
+                    g_actionManager->setRateLimits(readRateLimits(config));
                     
                     bool pp = config.getBool("parallel_processing", false);
                     if (pp) {
@@ -221,6 +397,7 @@ int main(int argc, char* argv[]) {
                     } else {
                         eventProcessor.enableParallelProcessing(false, 0);
                     }
+                    configureDuplicateFilter(config, eventProcessor);
                     std::cout << "Config applied. Rules: " << g_regexMatcher->getRuleCount()
                               << ", Actions: " << g_actionManager->getMappingCount() << std::endl;
                 } catch (const std::exception& ex) {
@@ -246,16 +423,7 @@ int main(int argc, char* argv[]) {
         // Main loop - wait for shutdown signal
         while (g_running.load()) {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            
-            // Check for email responses every 5 seconds
-            static auto lastEmailCheckTime = std::chrono::steady_clock::now();
             auto now = std::chrono::steady_clock::now();
-            if (std::chrono::duration_cast<std::chrono::seconds>(now - lastEmailCheckTime).count() >= 5) {
-                if (g_actionManager) {
-                    g_actionManager->checkEmailResponses();
-                }
-                lastEmailCheckTime = now;
-            }
             
             // Print status every 10 seconds
             static auto lastStatusTime = std::chrono::steady_clock::now();
@@ -263,16 +431,102 @@ int main(int argc, char* argv[]) {
                 std::cout << "Status: Line " << logReader.getCurrentLineNumber() 
                          << ", Processed " << eventProcessor.getProcessedEventCount() 
                          << " events, Queue size: " << eventQueue.size();
+                size_t suppressed = eventProcessor.getSuppressedEventCount();
+                if (suppressed > 0) {
+                    std::cout << ", Duplicates suppressed: " << suppressed;
+                }
                 if (g_regexMatcher) {
-                    std::cout << ", Regex matches: " << g_regexMatcher->getMatchCount();
+                    std::cout << ", Regex matches: " << g_regexMatcher->getMatchCount()
+                              << ", Rules/line: " << std::fixed << std::setprecision(1)
+                              << g_regexMatcher->getAverageRulesEvaluated() << std::defaultfloat;
+                    // Name the rule eating the most search time
+                    double totalNs = 0.0;
+                    RuleStats costliest;
+                    for (const auto& stats : g_regexMatcher->getAllRuleStats()) {
+                        totalNs += stats.totalNs;
+                        if (stats.totalNs > costliest.totalNs) costliest = stats;
+                    }
+                    if (totalNs > 0.0) {
+                        std::cout << ", Costliest rule: " << costliest.name << " ("
+                                  << static_cast<int>(100.0 * costliest.totalNs / totalNs + 0.5) << "% of search time)";
+                    }
+                    size_t cacheHits, cacheLookups, cacheBypassed;
+                    if (g_regexMatcher->getMatchCacheStats(cacheHits, cacheLookups, cacheBypassed) && cacheLookups > 0) {
+                        std::cout << ", Match cache hits: " << static_cast<int>(100.0 * cacheHits / cacheLookups + 0.5) << "%";
+                    }
+                    size_t quarantined = g_regexMatcher->getQuarantinedCount();
+                    if (quarantined > 0) {
+                        std::cout << ", Quarantined rules: " << quarantined;
+                    }
                 }
                 if (g_actionManager) {
                     std::cout << ", Actions executed: " << g_actionManager->getExecutedActionCount()
                              << ", Failed: " << g_actionManager->getFailedActionCount();
+                    if (g_actionManager->getActionSink().getFocusSwitchCount() > 0) {
+                        std::cout << ", Focus switches/sequence: " << std::fixed << std::setprecision(1)
+                                  << g_actionManager->getFocusSwitchesPerSequence() << std::defaultfloat;
+                    }
+                    size_t pendingSteps = g_actionManager->getPendingStepCount();
+                    if (pendingSteps > 0) {
+                        std::cout << ", Scheduled steps: " << pendingSteps;
+                    }
+                    RateLimitStats rate = g_actionManager->getRateLimitStats();
+                    if (rate.delayed + rate.dropped + rate.coalesced > 0) {
+                        std::cout << ", Rate limited: delayed " << rate.delayed << ", dropped " << rate.dropped
+                                  << ", coalesced " << rate.coalesced << ", expired " << rate.expired
+                                  << ", waiting " << rate.backlog;
+                    }
+                    if (ActionSender* sender = g_actionManager->getActionSender()) {
+                        OutboxStats outbox = sender->getOutboxStats();
+                        if (outbox.enqueued > 0) {
+                            std::cout << ", Emails sent: " << outbox.delivered << " in " << outbox.batches
+                                      << " batch(es), pending " << outbox.pending << ", retries " << outbox.retries
+                                      << ", failed " << outbox.failed;
+                        }
+                    }
+                    SpoolStats spool = responseSpool.getStats();
+                    if (spool.delivered + spool.stale + spool.duplicates + spool.rejected > 0) {
+                        std::cout << ", Responses: " << spool.delivered << " (stale " << spool.stale
+                                  << ", duplicate " << spool.duplicates << ", rejected " << spool.rejected << ")";
+                    }
                 }
                 std::cout << std::endl;
+                if (showRuleStats && g_regexMatcher) {
+                    g_regexMatcher->printRuleStats(std::cout);
+                }
                 lastStatusTime = now;
             }
+            
+            static auto lastStatsCsvTime = std::chrono::steady_clock::now();
+            if (ruleStatsCsvInterval > 0 &&
+                std::chrono::duration_cast<std::chrono::seconds>(now - lastStatsCsvTime).count() >= ruleStatsCsvInterval) {
+                if (g_regexMatcher) {
+                    g_regexMatcher->appendRuleStatsCsv(ruleStatsCsvPath);
+                }
+                lastStatsCsvTime = now;
+            }
+            
+            // Free the compiled patterns of rules that stayed disabled for the idle period
+            static auto lastEvictTime = std::chrono::steady_clock::now();
+            if (ruleEvictIdleSeconds > 0 &&
+                std::chrono::duration_cast<std::chrono::seconds>(now - lastEvictTime).count() >= 30) {
+                if (g_regexMatcher) {
+                    g_regexMatcher->evictIdleRules(std::chrono::seconds(ruleEvictIdleSeconds));
+                }
+                lastEvictTime = now;
+            }
+            
+            // Re-rank rules by observed hit rate and cost every 30 seconds and persist what was learned
+            static auto lastOrderTime = std::chrono::steady_clock::now();
+            if (std::chrono::duration_cast<std::chrono::seconds>(now - lastOrderTime).count() >= 30) {
+                if (g_regexMatcher && g_regexMatcher->isAdaptiveOrder()) {
+                    if (g_regexMatcher->updateEvaluationOrder()) {
+                        std::cout << "[ORDER] Rule evaluation order updated" << std::endl;
+                    }
+                    g_regexMatcher->saveRuleProfiles(ruleProfilePath);
+                }
+                lastOrderTime = now;
+            }
         }
         
     } catch (const std::exception& e) {
@@ -283,7 +537,8 @@ int main(int argc, char* argv[]) {
     // Graceful shutdown
     std::cout << "Shutting down components..." << std::endl;
     
-    // Stop the log reader first to prevent new events
+    // Stop the log reader and the response spool first to prevent new events
+    responseSpool.stop();
     logReader.stop();
     
     // Process remaining events in the queue
@@ -293,6 +548,13 @@ int main(int argc, char* argv[]) {
     // Stop the event processor
     eventProcessor.stop();
     
+    if (g_regexMatcher && g_regexMatcher->isAdaptiveOrder()) {
+        g_regexMatcher->saveRuleProfiles(ruleProfilePath);
+    }
+    if (showRuleStats && g_regexMatcher) {
+        g_regexMatcher->printRuleStats(std::cout);
+    }
+    
     std::cout << "Application shutdown complete." << std::endl;
     return 0;
 }
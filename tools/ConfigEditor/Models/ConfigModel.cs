@@ -18,6 +18,27 @@ namespace ConfigEditor.Models
         [YamlMember(Alias = "process_errors")] public bool ProcessErrors { get; set; } = true;
         [YamlMember(Alias = "process_warnings")] public bool ProcessWarnings { get; set; } = true;
         [YamlMember(Alias = "process_info")] public bool ProcessInfo { get; set; } = true;
+        [YamlMember(Alias = "regex_engine")] public string? RegexEngine { get; set; } = "std";
+        [YamlMember(Alias = "adaptive_rule_order")] public bool AdaptiveRuleOrder { get; set; } = false;
+        [YamlMember(Alias = "rule_stats_csv_interval_seconds")] public int RuleStatsCsvIntervalSeconds { get; set; } = 0;
+        [YamlMember(Alias = "rule_cache")] public bool RuleCache { get; set; } = true;
+        [YamlMember(Alias = "regex_match_limit")] public int RegexMatchLimit { get; set; } = 1000000;
+        [YamlMember(Alias = "regex_search_budget_ms")] public int RegexSearchBudgetMs { get; set; } = 50;
+        [YamlMember(Alias = "regex_quarantine_strikes")] public int RegexQuarantineStrikes { get; set; } = 3;
+        [YamlMember(Alias = "rule_evict_idle_seconds")] public int RuleEvictIdleSeconds { get; set; } = 600;
+        [YamlMember(Alias = "first_match")] public bool FirstMatch { get; set; } = false;
+        [YamlMember(Alias = "match_cache_entries")] public int MatchCacheEntries { get; set; } = 2048;
+        [YamlMember(Alias = "dedup_window_ms")] public int DedupWindowMs { get; set; } = 0;
+        [YamlMember(Alias = "dedup_max_entries")] public int DedupMaxEntries { get; set; } = 4096;
+        [YamlMember(Alias = "dedup_channels")] public string? DedupChannels { get; set; }
+        [YamlMember(Alias = "input_key_pacing_ms")] public int InputKeyPacingMs { get; set; } = 0;
+        [YamlMember(Alias = "action_rate_per_minute")] public int ActionRatePerMinute { get; set; } = 0;
+        [YamlMember(Alias = "action_rate_burst")] public int ActionRateBurst { get; set; } = 10;
+        [YamlMember(Alias = "rule_rate_per_minute")] public int RuleRatePerMinute { get; set; } = 0;
+        [YamlMember(Alias = "rule_rate_burst")] public int RuleRateBurst { get; set; } = 3;
+        [YamlMember(Alias = "action_rate_policy")] public string ActionRatePolicy { get; set; } = "delay";
+        [YamlMember(Alias = "action_max_staleness_ms")] public int ActionMaxStalenessMs { get; set; } = 3000;
+        [YamlMember(Alias = "action_rate_backlog")] public int ActionRateBacklog { get; set; } = 64;
 
         // Email configuration for SMS action type
         [YamlMember(Alias = "email_smtp_server")] public string? EmailSmtpServer { get; set; }
@@ -28,15 +49,32 @@ namespace ConfigEditor.Models
         [YamlMember(Alias = "email_to")] public string? EmailTo { get; set; }
         [YamlMember(Alias = "email_enable_ssl")] public bool EmailEnableSsl { get; set; } = true;
         [YamlMember(Alias = "email_poll_interval_seconds")] public int EmailPollIntervalSeconds { get; set; } = 30;
+        [YamlMember(Alias = "email_batch_window_ms")] public int EmailBatchWindowMs { get; set; } = 2000;
+        [YamlMember(Alias = "email_retry_max_ms")] public int EmailRetryMaxMs { get; set; } = 300000;
+        [YamlMember(Alias = "email_max_attempts")] public int EmailMaxAttempts { get; set; } = 8;
+        [YamlMember(Alias = "email_helper")] public bool EmailHelper { get; set; } = true;
+        [YamlMember(Alias = "email_response_spool")] public string EmailResponseSpool { get; set; } = "response_spool";
+        [YamlMember(Alias = "email_response_max_age_seconds")] public int EmailResponseMaxAgeSeconds { get; set; } = 120;
+        [YamlMember(Alias = "email_response_poll_ms")] public int EmailResponsePollMs { get; set; } = 1000;
 
         // Process targeting configuration
         [YamlMember(Alias = "target_all_processes")] public bool TargetAllProcesses { get; set; } = true;
         [YamlMember(Alias = "target_process_ids")] public List<int>? TargetProcessIds { get; set; }
         [YamlMember(Alias = "target_process_names")] public List<string>? TargetProcessNames { get; set; }
 
+        [YamlMember(Alias = "rule_groups")] public List<RuleGroup>? RuleGroups { get; set; }
         [YamlMember(Alias = "regex_rules")] public List<RegexRule> RegexRules { get; set; } = new List<RegexRule>();
     }
 
+    public class RuleGroup
+    {
+        [YamlMember(Alias = "name")] public string Name { get; set; } = string.Empty;
+        [YamlMember(Alias = "gate")] public string? Gate { get; set; }
+        [YamlMember(Alias = "gate_pattern")] public string? GatePattern { get; set; }
+        [YamlMember(Alias = "parent")] public string? Parent { get; set; }
+        [YamlMember(Alias = "engine")] public string? Engine { get; set; }
+    }
+
     public class RegexRule : INotifyPropertyChanged
     {
         private string _name = string.Empty;
@@ -46,6 +84,10 @@ namespace ConfigEditor.Models
         private int _modifiers;
         private bool _enabled = true;
         private int _cooldownMs;
+        private string? _engine;
+        private bool _stopProcessing;
+        private string? _group;
+        private string? _channel;
         private List<ActionStep>? _actions;
 
         [YamlMember(Alias = "name")] public string Name { get => _name; set => SetField(ref _name, value); }
@@ -56,6 +98,10 @@ namespace ConfigEditor.Models
         [YamlMember(Alias = "modifiers")] public int Modifiers { get => _modifiers; set => SetField(ref _modifiers, value); }
         [YamlMember(Alias = "enabled")] public bool Enabled { get => _enabled; set => SetField(ref _enabled, value); }
         [YamlMember(Alias = "cooldown_ms")] public int CooldownMs { get => _cooldownMs; set => SetField(ref _cooldownMs, value); }
+        [YamlMember(Alias = "engine")] public string? Engine { get => _engine; set => SetField(ref _engine, value); }
+        [YamlMember(Alias = "stop_processing")] public bool StopProcessing { get => _stopProcessing; set => SetField(ref _stopProcessing, value); }
+        [YamlMember(Alias = "group")] public string? Group { get => _group; set => SetField(ref _group, value); }
+        [YamlMember(Alias = "channel")] public string? Channel { get => _channel; set => SetField(ref _channel, value); }
 
         // Optional multi-step support
         [YamlMember(Alias = "actions")] public List<ActionStep>? Actions { get => _actions; set => SetField(ref _actions, value); }
@@ -71,6 +117,10 @@ namespace ConfigEditor.Models
                 Modifiers = Modifiers,
                 Enabled = Enabled,
                 CooldownMs = CooldownMs,
+                Engine = Engine,
+                StopProcessing = StopProcessing,
+                Group = Group,
+                Channel = Channel,
                 Actions = Actions?.Select(a => a.Clone()).ToList()
             };
         }
@@ -35,6 +35,7 @@ namespace EmailMonitor
         private bool _imapEnableSsl;
         private HashSet<string> _processedEmailIds;
         private DateTime _startupTime;
+        private string _spoolDirectory = "response_spool";
 
         public event EventHandler<string> OnResponseReceived;
 
@@ -70,18 +71,13 @@ namespace EmailMonitor
             _isRunning = true;
             _cancellationTokenSource = new CancellationTokenSource();
 
-            // Clear any existing response file on startup to avoid processing old responses
-            if (File.Exists("response.txt"))
-            {
-                File.Delete("response.txt");
-                Console.WriteLine($"[EMAIL MONITOR] Cleared existing response file on startup");
-            }
+            Directory.CreateDirectory(_spoolDirectory);
 
             Console.WriteLine($"[EMAIL MONITOR] Starting email monitoring for {_toEmail}");
             Console.WriteLine($"[EMAIL MONITOR] Monitoring emails received after {_startupTime:yyyy-MM-dd HH:mm:ss}");
             Console.WriteLine($"[EMAIL MONITOR] Polling every {_checkIntervalMs / 1000} seconds (configured via email_poll_interval_seconds)");
             Console.WriteLine($"[EMAIL MONITOR] Current working directory: {Directory.GetCurrentDirectory()}");
-            Console.WriteLine($"[EMAIL MONITOR] Response file will be written to: {Path.GetFullPath("response.txt")}");
+            Console.WriteLine($"[EMAIL MONITOR] Responses will be written to: {Path.GetFullPath(_spoolDirectory)}");
 
             try
             {
@@ -160,12 +156,8 @@ namespace EmailMonitor
                         Console.WriteLine($"[EMAIL MONITOR] File-based response received: {response}");
                         OnResponseReceived?.Invoke(this, response);
                         
-                        // Append to response.txt for the main application
-                        string timestampedResponse = $"{DateTime.Now:yyyy-MM-dd HH:mm:ss}|{response}";
-                        string responseFilePath = Path.GetFullPath("response.txt");
-                        Console.WriteLine($"[EMAIL MONITOR] Appending file-based response to: {responseFilePath}");
-                        File.AppendAllText(responseFilePath, timestampedResponse + Environment.NewLine);
-                        Console.WriteLine($"[EMAIL MONITOR] Successfully appended file-based response");
+                        // Every dropped file is a new response, even under a reused name
+                        SpoolResponse(response, "file-" + Guid.NewGuid().ToString("N"));
                     }
 
                     // Delete the processed file
@@ -257,13 +249,7 @@ namespace EmailMonitor
                                 Console.WriteLine($"[EMAIL MONITOR] Response received from {_toEmail}: {response}");
                                 OnResponseReceived?.Invoke(this, response);
                                 
-                                // Append response to file with timestamp for the main application
-                                string timestampedResponse = $"{DateTime.Now:yyyy-MM-dd HH:mm:ss}|{response}";
-                                string responseFilePath = Path.GetFullPath("response.txt");
-                                Console.WriteLine($"[EMAIL MONITOR] Appending IMAP response to: {responseFilePath}");
-                                Console.WriteLine($"[EMAIL MONITOR] Response content: {timestampedResponse}");
-                                File.AppendAllText(responseFilePath, timestampedResponse + Environment.NewLine);
-                                Console.WriteLine($"[EMAIL MONITOR] Successfully appended {timestampedResponse.Length} characters to {responseFilePath}");
+                                SpoolResponse(response, "imap-" + uid);
                             }
                             else
                             {
@@ -287,6 +273,21 @@ namespace EmailMonitor
             }
         }
 
+        // Hand a response to LogEventProcessor: one file per response in the spool directory, named
+        // "<UTC yyyyMMddHHmmssfff>_<key>.resp". It is written under a .tmp name and renamed, so the
+        // reader only ever sees complete files; the key lets it drop a response delivered twice.
+        private void SpoolResponse(string response, string key)
+        {
+            string safeKey = Regex.Replace(key, "[^A-Za-z0-9-]", "-");
+            string name = $"{DateTime.UtcNow:yyyyMMddHHmmssfff}_{safeKey}";
+            string tempPath = Path.Combine(_spoolDirectory, name + ".tmp");
+            string entryPath = Path.Combine(_spoolDirectory, name + ".resp");
+            Directory.CreateDirectory(_spoolDirectory);
+            File.WriteAllText(tempPath, response, new System.Text.UTF8Encoding(false));
+            File.Move(tempPath, entryPath);
+            Console.WriteLine($"[EMAIL MONITOR] Spooled response to: {Path.GetFullPath(entryPath)}");
+        }
+
         private string GetEmailContent(MimeMessage message)
         {
             try
@@ -452,6 +453,8 @@ namespace EmailMonitor
                         config.ImapPassword = line.Split(new char[] { ':' }, 2)[1].Trim();
                     else if (line.StartsWith("email_imap_enable_ssl:"))
                         config.ImapEnableSsl = line.Split(new char[] { ':' }, 2)[1].Trim().ToLower() == "true";
+                    else if (line.StartsWith("email_response_spool:"))
+                        config.ResponseSpool = line.Split(new char[] { ':' }, 2)[1].Trim();
                     else if (line.StartsWith("email_poll_interval_seconds:"))
                     {
                         int interval;
@@ -464,10 +467,13 @@ namespace EmailMonitor
                 string imapUsername = !string.IsNullOrEmpty(config.ImapUsername) ? config.ImapUsername : config.Username;
                 string imapPassword = !string.IsNullOrEmpty(config.ImapPassword) ? config.ImapPassword : config.Password;
                 
-                return new EmailMonitor(
+                var monitor = new EmailMonitor(
                     config.SmtpServer, config.SmtpPort, config.Username, config.Password,
                     config.From, config.To, config.EnableSsl, config.PollIntervalSeconds * 1000, // Convert seconds to milliseconds
                     config.ImapServer, config.ImapPort, imapUsername, imapPassword, config.ImapEnableSsl);
+                if (!string.IsNullOrEmpty(config.ResponseSpool))
+                    monitor._spoolDirectory = config.ResponseSpool;
+                return monitor;
             }
             catch (Exception ex)
             {
@@ -496,5 +502,8 @@ namespace EmailMonitor
         
         // Email monitoring poll interval
         public int PollIntervalSeconds { get; set; } = 30;
+        
+        // Directory LogEventProcessor watches for responses
+        public string ResponseSpool { get; set; } = "response_spool";
     }
 }
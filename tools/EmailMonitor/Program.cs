@@ -31,7 +31,7 @@ namespace EmailMonitor
             monitor.OnResponseReceived += (sender, response) =>
             {
                 Console.WriteLine($"[RESPONSE] {response}");
-                // The EmailMonitor class already writes the response with timestamp to response.txt
+                // The EmailMonitor class already spools the response for LogEventProcessor
                 // No additional processing needed here
             };
 
@@ -2,6 +2,7 @@ using System;
 using System.Net;
 using System.Net.Mail;
 using System.IO;
+using System.Text;
 
 namespace EmailService
 {
@@ -9,9 +10,15 @@ namespace EmailService
     {
         static int Main(string[] args)
         {
+            if (args.Length == 2 && args[0] == "--serve")
+            {
+                return Serve(args[1]);
+            }
+
             if (args.Length < 2)
             {
                 Console.WriteLine("Usage: EmailService.exe <config_path> <message>");
+                Console.WriteLine("       EmailService.exe --serve <config_path>");
                 return 1;
             }
 
@@ -36,6 +43,69 @@ namespace EmailService
             }
         }
 
+        // Resident mode for LogEventProcessor: the config is read once and every request on stdin
+        // is answered on stdout. Frames are a 4-byte little-endian length and a UTF-8 body; a
+        // request is "<kind>\n<message>", a reply is "OK" or "ERROR <reason>". Logging goes to
+        // stderr because stdout carries the replies.
+        static int Serve(string configPath)
+        {
+            EmailConfig config;
+            try
+            {
+                config = LoadConfig(configPath);
+            }
+            catch (Exception ex)
+            {
+                Console.Error.WriteLine($"Error: {ex.Message}");
+                return 1;
+            }
+
+            using (var input = new BinaryReader(Console.OpenStandardInput()))
+            using (var output = new BinaryWriter(Console.OpenStandardOutput()))
+            using (var client = CreateClient(config))
+            {
+                while (true)
+                {
+                    byte[] request;
+                    try
+                    {
+                        int length = input.ReadInt32();
+                        if (length < 0 || length > (1 << 20))
+                            return 1;
+                        request = input.ReadBytes(length);
+                        if (request.Length != length)
+                            return 0;
+                    }
+                    catch (EndOfStreamException)
+                    {
+                        return 0; // LogEventProcessor closed the pipe
+                    }
+
+                    string reply;
+                    try
+                    {
+                        string text = Encoding.UTF8.GetString(request);
+                        int newline = text.IndexOf('\n');
+                        string kind = newline > 0 ? text.Substring(0, newline) : "sms";
+                        string message = newline >= 0 ? text.Substring(newline + 1) : text;
+                        client.Send(CreateMessage(config, message));
+                        Console.Error.WriteLine($"Email sent ({kind})");
+                        reply = "OK";
+                    }
+                    catch (Exception ex)
+                    {
+                        Console.Error.WriteLine($"Error: {ex.Message}");
+                        reply = "ERROR " + ex.Message;
+                    }
+
+                    byte[] replyBytes = Encoding.UTF8.GetBytes(reply);
+                    output.Write(replyBytes.Length);
+                    output.Write(replyBytes);
+                    output.Flush();
+                }
+            }
+        }
+
         static EmailConfig LoadConfig(string configPath)
         {
             // Simple YAML parsing for email configuration
@@ -77,28 +147,37 @@ namespace EmailService
             Console.WriteLine($"  Enable SSL: {config.EnableSsl}");
             Console.WriteLine($"  Message: {message}");
             
-            using (var client = new SmtpClient(config.SmtpServer, config.SmtpPort))
+            using (var client = CreateClient(config))
             {
-                client.EnableSsl = config.EnableSsl;
-                client.UseDefaultCredentials = false;
-                client.Credentials = new NetworkCredential(config.Username, config.Password);
-                client.DeliveryMethod = SmtpDeliveryMethod.Network;
-
-                var mailMessage = new MailMessage
-                {
-                    From = new MailAddress(config.From),
-                    Subject = "EQ Tell Message",
-                    Body = message,
-                    IsBodyHtml = false
-                };
-
-                mailMessage.To.Add(config.To);
-
-                client.Send(mailMessage);
+                client.Send(CreateMessage(config, message));
             }
             
             Console.WriteLine("Email sent successfully");
         }
+
+        static SmtpClient CreateClient(EmailConfig config)
+        {
+            var client = new SmtpClient(config.SmtpServer, config.SmtpPort);
+            client.EnableSsl = config.EnableSsl;
+            client.UseDefaultCredentials = false;
+            client.Credentials = new NetworkCredential(config.Username, config.Password);
+            client.DeliveryMethod = SmtpDeliveryMethod.Network;
+            return client;
+        }
+
+        static MailMessage CreateMessage(EmailConfig config, string message)
+        {
+            var mailMessage = new MailMessage
+            {
+                From = new MailAddress(config.From),
+                Subject = "EQ Tell Message",
+                Body = message,
+                IsBodyHtml = false
+            };
+
+            mailMessage.To.Add(config.To);
+            return mailMessage;
+        }
     }
 
     class EmailConfig